@@ -0,0 +1,18 @@
+#include <filesystem>
+#include <iostream>
+
+#include "backtest/market_data.h"
+
+// Convert orderbook.txt and trades.txt of the log directory into the binary file for backtests
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cout << "Usage: " << argv[0] << " <log_directory> <output_file>" << std::endl;
+        return 1;
+    }
+    std::filesystem::path log_directory = argv[1];
+    size_t n_records = MarketDataFile::Convert(log_directory / "orderbook.txt", log_directory / "trades.txt", argv[2]);
+
+    MarketDataFile data(argv[2]);
+    std::cout << "Records: " << n_records << "; depth: " << data.GetDepth() << std::endl;
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <random>
+
+#include "backtest/market_data.h"
+#include "backtest/sweep_results.h"
+#include "backtest/thread_pool.h"
+#include "runner.h"
+#include "strategies/grid_trading.h"
+
+// Parameter sweep of GridTrading over recorded days.
+// Config (default: private/sweep.yaml):
+//   runner: figi, lot_size, px_step
+//   backtest: money, qty           -- initial positions of each day
+//   strategy: debug, ...           -- base parameters
+//   sweep:
+//     data: [day1.bin, ...]        -- files from convert_market_data
+//     output: sweep.bin             -- SweepResultsFile (scripts/research/sweep_results.py)
+//     threads: 0                   -- 0: all cores
+//     n_samples: 0                 -- 0: full grid; otherwise random sample from the grid
+//     seed: 0
+//     parameters: {spread: [2, 3], order_size: [1], max_levels: [3, 5]}
+
+using Parameters = std::vector<int>;  // values in the order of the sweep.parameters
+
+struct DayInfo {
+    double first_mid = 0;
+    double last_mid = 0;
+};
+
+using SweepResult = SweepResultsFile::Record;
+
+DayInfo GetDayInfo(const MarketDataFile& data) {
+    DayInfo info;
+    bool is_first = true;
+    for (size_t i = 0; i < data.Size(); ++i) {
+        if (data.GetRecord(i).type != MarketDataFile::RecordType::OrderBook) {
+            continue;
+        }
+        const int32_t* levels = data.GetLevels(i);
+        double mid = (levels[0] + levels[2 * data.GetDepth()]) / 2.0;
+        if (is_first) {
+            info.first_mid = mid;
+            is_first = false;
+        }
+        info.last_mid = mid;
+    }
+    return info;
+}
+
+std::vector<Parameters> GetParameters(const std::vector<std::vector<int>>& values, size_t n_samples, uint64_t seed) {
+    std::vector<Parameters> result;
+    if (n_samples > 0) {
+        // Random sample from the grid
+        std::mt19937_64 rng(seed);
+        for (size_t i = 0; i < n_samples; ++i) {
+            Parameters parameters;
+            for (const std::vector<int>& options : values) {
+                parameters.push_back(options[std::uniform_int_distribution<size_t>(0, options.size() - 1)(rng)]);
+            }
+            result.push_back(std::move(parameters));
+        }
+        return result;
+    }
+    // Full grid
+    std::vector<size_t> index(values.size(), 0);
+    while (true) {
+        Parameters parameters;
+        for (size_t j = 0; j < values.size(); ++j) {
+            parameters.push_back(values[j][index[j]]);
+        }
+        result.push_back(std::move(parameters));
+        size_t j = 0;
+        while (j < values.size() && ++index[j] == values[j].size()) {
+            index[j++] = 0;
+        }
+        if (j == values.size()) {
+            return result;
+        }
+    }
+}
+
+SweepResult RunConfiguration(const ConfigType& config, const std::vector<std::unique_ptr<MarketDataFile>>& days, const std::vector<DayInfo>& day_infos) {
+    SweepResult result;
+    const int money = config["backtest"]["money"].as<int>();
+    const int qty = config["backtest"]["qty"].as<int>(0);
+    Runner::StrategyGetter strategy_getter = [](Runner& runner) {
+        return std::make_shared<GridTrading>(runner, runner.GetConfig()["strategy"]);
+    };
+    for (size_t i = 0; i < days.size(); ++i) {
+        // Each day starts from the same positions in the isolated Runner
+        Runner runner(config, strategy_getter);
+        runner.Backtest(*days[i]);
+
+        const Positions& positions = runner.GetUserConnector().GetPositions();
+        const VirtualExchangeStats& stats = runner.GetBacktestStats();
+        result.pnl += (positions.money - money) + positions.qty * day_infos[i].last_mid - qty * day_infos[i].first_mid;
+        result.turnover += stats.turnover;
+        result.filled_qty += stats.filled_qty;
+        result.n_fills += stats.n_fills;
+        result.n_posts += stats.n_posts;
+        result.n_cancels += stats.n_cancels;
+        result.max_inventory = std::max(result.max_inventory, stats.max_inventory);
+        result.final_qty = positions.qty;
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    const std::string config_path = argc > 1 ? argv[1] : "private/sweep.yaml";
+    ConfigType base_config = YAML::LoadFile(config_path);
+    const ConfigType& sweep = base_config["sweep"];
+
+    // Map market data
+    std::vector<std::unique_ptr<MarketDataFile>> days;
+    std::vector<DayInfo> day_infos;
+    size_t n_records = 0;
+    for (const auto& path : sweep["data"]) {
+        days.push_back(std::make_unique<MarketDataFile>(path.as<std::string>()));
+        day_infos.push_back(GetDayInfo(*days.back()));
+        n_records += days.back()->Size();
+        assert(days.back()->GetDepth() == days.front()->GetDepth() && "All days must have the same depth");
+    }
+    if (days.empty()) {
+        std::cout << "sweep.data is empty" << std::endl;
+        return 1;
+    }
+
+    // Generate configurations
+    std::vector<std::string> names;
+    std::vector<std::vector<int>> values;
+    for (const auto& parameter : sweep["parameters"]) {
+        names.push_back(parameter.first.as<std::string>());
+        values.push_back(parameter.second.as<std::vector<int>>());
+        assert(!values.back().empty());
+    }
+    std::vector<Parameters> parameters = GetParameters(values, sweep["n_samples"].as<size_t>(0), sweep["seed"].as<uint64_t>(0));
+
+    // Build the configs in the main thread: YAML nodes are not thread-safe
+    std::vector<ConfigType> configs;
+    for (const Parameters& configuration : parameters) {
+        ConfigType config = YAML::Clone(base_config);
+        config.remove("sweep");
+        config["runner"]["mode"] = "backtest";
+        config["runner"].remove("log_directory");
+        config["market"]["depth"] = days.front()->GetDepth();
+        for (size_t j = 0; j < names.size(); ++j) {
+            config["strategy"][names[j]] = configuration[j];
+        }
+        configs.push_back(config);
+    }
+
+    // Run configurations
+    WorkStealingPool pool(sweep["threads"].as<size_t>(0));
+    std::cout << "Configurations: " << configs.size() << "; days: " << days.size() << "; records: " << n_records << "; threads: " << pool.GetThreadsCount() << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results(configs.size());
+    std::atomic_size_t n_done = 0;
+    for (size_t i = 0; i < configs.size(); ++i) {
+        pool.Submit([&, i]() {
+            try {
+                results[i] = RunConfiguration(configs[i], days, day_infos);
+            } catch (const std::exception& exc) {
+                std::cout << "Configuration " << i << " failed: " << exc.what() << std::endl;
+                results[i].ok = 0;
+            }
+            size_t done = ++n_done;
+            if (done % 100 == 0) {
+                std::cout << "Done: " << done << "/" << configs.size() << std::endl;
+            }
+        });
+    }
+    pool.Wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Finished in " << seconds << " s (" << configs.size() * n_records / seconds / 1e6 << " M records/s)" << std::endl;
+
+    // Write results
+    const std::string output_path = sweep["output"].as<std::string>("sweep.bin");
+    SweepResultsFile::Write(output_path, names, parameters, results);
+    std::cout << "Results: " << std::filesystem::absolute(output_path) << std::endl;
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "backtest/load_generator.h"
+#include "strategies/grid_trading.h"
+
+// Load test of the Runner with synthetic market data.
+// Config (default: private/load_test.yaml):
+//   runner: figi, lot_size, px_step      -- endpoint: localhost:50051 for the grpc mode
+//   market: depth
+//   backtest: money, qty                 -- positions of the in_process mode
+//   strategy: GridTrading parameters
+//   load_test:                           -- LoadGenerator config (backtest/load_generator.h)
+//     root_cert: server.crt              -- grpc mode: certificate of exe/market_data_server
+// Find the saturation point by increasing the rates until the skip rate and the latency grow.
+
+void PrintLatencies(const char* name, std::vector<int64_t>& latencies) {
+    if (latencies.empty()) {
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double q) { return latencies[static_cast<size_t>(q * (latencies.size() - 1))] / 1000.0; };
+    std::cout << name << " latency: p50=" << percentile(0.5) << " us; p90=" << percentile(0.9) << " us; p99=" << percentile(0.99)
+              << " us; p99.9=" << percentile(0.999) << " us; max=" << percentile(1.0) << " us" << std::endl;
+}
+
+void PrintConnectorLatency(const char* name, const LatencyTracker& tracker) {
+    if (tracker.Empty()) {
+        return;
+    }
+    std::cout << name << " connector latency (last " << std::min(tracker.GetCount(), LatencyTracker::WINDOW) << "): p50="
+              << tracker.GetPercentile(0.5) / 1000.0 << " us; p99=" << tracker.GetPercentile(0.99) / 1000.0 << " us" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    const std::string config_path = argc > 1 ? argv[1] : "private/load_test.yaml";
+    ConfigType config = YAML::LoadFile(config_path);
+    const ConfigType& load_test = config["load_test"];
+    const std::string mode = load_test["mode"].as<std::string>("in_process");
+    config["runner"].remove("log_directory");
+    if (mode == "in_process") {
+        config["runner"]["mode"] = "backtest";
+    } else if (mode == "grpc") {
+        config["runner"]["mode"] = "live";
+        if (!config["runner"]["token"]) config["runner"]["token"] = "load-test";
+        if (!config["user"]["account_id"]) config["user"]["account_id"] = "load-test";
+        // The stand-in server has a self-signed certificate
+        if (load_test["root_cert"]) setenv("GRPC_DEFAULT_SSL_ROOTS_FILE_PATH", load_test["root_cert"].as<std::string>().c_str(), 1);
+    } else {
+        std::cout << "Unknown load_test.mode: " << mode << std::endl;
+        return 1;
+    }
+
+    Runner runner(config, [](Runner& runner) {
+        return std::make_shared<GridTrading>(runner, runner.GetConfig()["strategy"]);
+    });
+    LoadGenerator generator(runner, load_test);
+    LoadTestStats stats = mode == "in_process" ? generator.RunInProcess() : generator.RunEndToEnd();
+
+    // Report
+    const NotificationStats& notifications = stats.notifications;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Mode: " << mode << "; duration: " << stats.seconds << " s" << std::endl;
+    std::cout << "OrderBooks: " << notifications.n_orderbooks << " (" << notifications.n_orderbooks / stats.seconds << " /s); skipped notifications: "
+              << 100.0 * notifications.n_orderbook_skips / std::max<size_t>(notifications.n_orderbooks, 1) << "%" << std::endl;
+    std::cout << "Trades: " << notifications.n_trades << " (" << notifications.n_trades / stats.seconds << " /s); skipped notifications: "
+              << 100.0 * notifications.n_trade_skips / std::max<size_t>(notifications.n_trades, 1) << "%" << std::endl;
+    PrintLatencies("OrderBook", stats.orderbook_latencies);
+    PrintLatencies("Trade", stats.trade_latencies);
+    PrintConnectorLatency("OrderBook", stats.orderbook_connector_latency);
+    PrintConnectorLatency("Trade", stats.trade_connector_latency);
+
+    if (mode == "grpc") {
+        // Streams of the SDK cannot be stopped: exit without destructors
+        std::cout.flush();
+        std::_Exit(0);
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+#include <iostream>
+
+#include "backtest/market_data_server.h"
+
+// Stand-in for MarketDataStreamService and InstrumentsService of Tinkoff Invest API for end-to-end load tests
+// (load_test.mode: grpc). Config: backtest/market_data_server.h (default: private/load_test.yaml)
+
+int main(int argc, char** argv) {
+    const std::string config_path = argc > 1 ? argv[1] : "private/load_test.yaml";
+    ConfigType config = YAML::LoadFile(config_path);
+    try {
+        MarketDataServer server(config);
+        std::cout << "MarketDataStreamService and InstrumentsService stand-in on " << server.GetAddress() << std::endl;
+        server.Wait();
+    } catch (const std::runtime_error& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -20,7 +20,7 @@ private:
         int target_px_ind = 0;
         int cum_qty = 0;
         for (int i = 0; i < ob.depth; ++i) {
-            cum_qty += ob.qty[i];
+            cum_qty += ob[i].qty;
             if (cum_qty > max_skip_qty) {
                 target_px_ind = i;
                 break;
@@ -28,10 +28,10 @@ private:
         }
         // ob.cum_qty[target_px_ind - 1] < max_skip_qty
         // ob.cum_qty[target_px_ind] > max_skip_qty
-        if (target_px_ind >= 1 && ob.px[target_px_ind] - ob.px[target_px_ind - 1] > 1) {
-            return ob.px[target_px_ind - 1] - ob.Sign();
+        if (target_px_ind >= 1 && ob[target_px_ind].px - ob[target_px_ind - 1].px > 1) {
+            return ob[target_px_ind - 1].px - ob.Sign();
         }
-        return ob.px[target_px_ind];
+        return ob[target_px_ind].px;
     }
 
     void PostOrdersForSide(const LimitOrder* order, int target_px, Direction direction) {
@@ -56,6 +56,10 @@ private:
             }
         } catch (const ServiceReply& reply) {
             m_logger->warn("Could not post the order (possibly prohibited short): {} qty={}, px={}", direction, place_qty, target_px);
+        } catch (const OrderRejected&) {
+            // RiskGate has logged the rule
+        } catch (const OrderRejectedByExchange& rejected) {
+            m_logger->warn("Order is rejected by the exchange ({}): {} qty={}, px={}", rejected.what(), direction, place_qty, target_px);
         }
     }
 
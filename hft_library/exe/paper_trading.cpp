@@ -0,0 +1,53 @@
+#include <filesystem>
+#include <iostream>
+
+#include "config.h"
+#include "runner.h"
+#include "strategies/grid_trading.h"
+
+// GridTrading of runner.mode (live or paper) with shadow paper GridTradings on the same market data.
+// Shadows do not subscribe to the streams: the runner forwards the parsed messages to them, each shadow runs on its own thread.
+// Config (private/config.yaml):
+//   runner, user, strategy       -- as for grid_trading
+//   paper:
+//     money: 100000, qty: 0      -- initial positions of each paper runner
+//     shadows:                   -- strategy parameters that override strategy for each shadow
+//       - {spread: 3}
+//       - {spread: 4, max_levels: 5}
+// Logs of the shadow i are in <runner.log_directory>/shadow_<i>.
+
+ConfigType MakeShadowConfig(const ConfigType& config, const ConfigType& overrides, size_t index) {
+    ConfigType shadow = YAML::Clone(config);
+    shadow["runner"]["mode"] = "paper";
+    shadow["runner"]["log_directory"] = (std::filesystem::path(config["runner"]["log_directory"].as<std::string>()) / ("shadow_" + std::to_string(index))).string();
+    for (const auto& parameter : overrides) {
+        shadow["strategy"][parameter.first.as<std::string>()] = parameter.second;
+    }
+    return shadow;
+}
+
+int main() {
+    auto config = read_config();
+    std::filesystem::create_directory(config["runner"]["log_directory"].as<std::string>());
+
+    Runner::StrategyGetter strategy_getter = [](Runner& runner) {
+        return std::make_shared<GridTrading>(runner, runner.GetConfig()["strategy"]);
+    };
+
+    // Shadows outlive the runner and are created before it starts its streams
+    std::vector<std::unique_ptr<Runner>> shadows;
+    Runner runner(config, strategy_getter);
+    const ConfigType& shadow_overrides = config["paper"]["shadows"];
+    for (size_t i = 0; i < shadow_overrides.size(); ++i) {
+        ConfigType shadow_config = MakeShadowConfig(config, shadow_overrides[i], i);
+        std::filesystem::create_directory(shadow_config["runner"]["log_directory"].as<std::string>());
+        shadows.push_back(std::make_unique<Runner>(shadow_config, strategy_getter, runner));
+    }
+    runner.Start();
+
+    std::cout << "Main thread Sleep: " << shadows.size() << " shadows" << std::endl;
+    std::this_thread::sleep_until(std::chrono::time_point<std::chrono::system_clock>::max());
+
+    std::cout << "Exit 0" << std::endl;
+    return 0;
+}
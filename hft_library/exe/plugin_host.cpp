@@ -0,0 +1,59 @@
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+
+#include "config.h"
+#include "plugin.h"
+#include "runner.h"
+
+// Runner with strategies of a shared-library plugin (hft_library/plugins) that is reloaded without restarting the connectors.
+// Rebuild the plugin and send SIGHUP: every strategy is replaced by the new version between events, with its state.
+// Config (private/config.yaml):
+//   runner, user, strategy or strategies  -- as for grid_trading
+//   plugin:
+//     path: build/hft_library/plugins/grid_trading_plugin.so
+// SIGINT or SIGTERM stops the host.
+
+int main() {
+    auto config = read_config();
+    std::filesystem::create_directory(config["runner"]["log_directory"].as<std::string>());
+    const std::string plugin_path = config["plugin"]["path"].as<std::string>();
+
+    // Signals are handled by sigwait of the main thread: they are blocked before the stream threads inherit the mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGHUP);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    std::shared_ptr<StrategyPlugin> plugin = StrategyPlugin::Load(plugin_path);
+    std::vector<Runner::StrategyGetter> strategy_getters(config["strategies"] ? config["strategies"].size() : 1, plugin->GetStrategyGetter());
+    // Old versions are unloaded with their last strategy
+    plugin.reset();
+    Runner runner(config, strategy_getters);
+    strategy_getters.clear();
+    runner.Start();
+
+    std::cout << "Main thread waits for signals: SIGHUP reloads " << plugin_path << std::endl;
+    while (true) {
+        int signal = 0;
+        sigwait(&signals, &signal);
+        if (signal != SIGHUP) {
+            break;
+        }
+        try {
+            Runner::StrategyGetter strategy_getter = StrategyPlugin::Load(plugin_path)->GetStrategyGetter();
+            for (int strategy_id = 0; strategy_id < runner.GetStrategyCount(); ++strategy_id) {
+                runner.ReplaceStrategy(strategy_id, strategy_getter);
+            }
+            std::cout << "Plugin is reloaded" << std::endl;
+        } catch (const std::exception& e) {
+            // The running version stays
+            std::cout << "Could not reload plugin: " << e.what() << std::endl;
+        }
+    }
+
+    std::cout << "Exit 0" << std::endl;
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include "backtest/market_data.h"
+#include "clock.h"
+#include "runner.h"
+#include "strategies/grid_trading.h"
+
+// Replay a recorded day through GridTrading in backtest mode and measure the hot path.
+// The same workload trains the PGO build (scripts/build/build_release.py).
+// Usage: replay_benchmark <config.yaml> <market_data.bin> [n_runs=5]
+//   config: runner (figi, lot_size, px_step), backtest (money, qty), strategy -- as in private/sweep.yaml
+// Output: metric=value lines (compared by scripts/build/compare_builds.py)
+
+int64_t GetPercentile(std::vector<int64_t>& values, double q) {
+    auto it = values.begin() + static_cast<ptrdiff_t>(q * (values.size() - 1));
+    std::nth_element(values.begin(), it, values.end());
+    return *it;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "Usage: replay_benchmark <config.yaml> <market_data.bin> [n_runs=5]" << std::endl;
+        return 1;
+    }
+    ConfigType config = YAML::LoadFile(argv[1]);
+    MarketDataFile data(argv[2]);
+    const int n_runs = argc > 3 ? std::stoi(argv[3]) : 5;
+    config["runner"]["mode"] = "backtest";
+    config["runner"].remove("log_directory");
+    config["market"]["depth"] = data.GetDepth();
+
+    const Runner::StrategyGetter strategy_getter = [](Runner& runner) {
+        return std::make_shared<GridTrading>(runner, runner.GetConfig()["strategy"]);
+    };
+    std::vector<double> throughputs;  // records per second of each run
+    std::vector<int64_t> latencies;   // ns per record of all runs
+    latencies.reserve(data.Size() * n_runs);
+    int n_fills = 0;
+    for (int run = 0; run < n_runs; ++run) {
+        Runner runner(config, strategy_getter);
+        runner.StartBacktest();
+        TscClock::TicksType run_start = TscClock::Ticks();
+        for (size_t i = 0; i < data.Size(); ++i) {
+            TscClock::TicksType start = TscClock::Ticks();
+            runner.Replay(data, i, i + 1);
+            latencies.push_back(TscClock::TicksToNanoseconds(TscClock::TicksOrdered() - start));
+        }
+        double seconds = TscClock::TicksToNanoseconds(TscClock::Ticks() - run_start) / 1e9;
+        throughputs.push_back(data.Size() / seconds);
+        n_fills = runner.GetBacktestStats().n_fills;
+    }
+
+    // Report
+    std::sort(throughputs.begin(), throughputs.end());
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << "records=" << data.Size() << "\n";
+    std::cout << "runs=" << n_runs << "\n";
+    std::cout << "fills=" << n_fills << "\n";
+    std::cout << "throughput_median=" << throughputs[throughputs.size() / 2] << "\n";
+    std::cout << "throughput_max=" << throughputs.back() << "\n";
+    std::cout << "latency_p50_ns=" << GetPercentile(latencies, 0.5) << "\n";
+    std::cout << "latency_p90_ns=" << GetPercentile(latencies, 0.9) << "\n";
+    std::cout << "latency_p99_ns=" << GetPercentile(latencies, 0.99) << "\n";
+    std::cout << "latency_p999_ns=" << GetPercentile(latencies, 0.999) << "\n";
+    std::cout << "latency_max_ns=" << *std::max_element(latencies.begin(), latencies.end()) << std::endl;
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <iomanip>
+#include <iostream>
+
+#include "backtest/wire_player.h"
+#include "strategies/grid_trading.h"
+
+// Replay the captured stream messages (runner.wire_record) through the connector callbacks and GridTrading.
+// Usage: replay_wire <config.yaml> <wire.gz> [speed=0] [log_directory]
+//   config: the config of the recorded run (figi, lot_size, px_step, market.depth must match) with backtest (money, qty)
+//   speed: 1 keeps the recorded timing, k is k times faster, 0 is as fast as possible
+//   log_directory: write the connector logs of the replay (not the directory of the recording)
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "Usage: replay_wire <config.yaml> <wire.gz> [speed=0] [log_directory]" << std::endl;
+        return 1;
+    }
+    ConfigType config = YAML::LoadFile(argv[1]);
+    const double speed = argc > 3 ? std::stod(argv[3]) : 0;
+    config["runner"]["mode"] = "backtest";
+    config["runner"]["wire_record"] = false;
+    if (argc > 4) {
+        config["runner"]["log_directory"] = argv[4];
+    } else {
+        config["runner"].remove("log_directory");
+    }
+
+    Runner runner(config, [](Runner& runner) {
+        return std::make_shared<GridTrading>(runner, runner.GetConfig()["strategy"]);
+    });
+    WirePlayer player(runner, argv[2], speed);
+    WirePlayerStats stats = player.Play();
+
+    // Report
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "Replayed in " << stats.seconds << " s" << std::endl;
+    for (size_t i = 0; i < N_WIRE_STREAMS; ++i) {
+        std::cout << WireStreamName(static_cast<WireStream>(i)) << ": " << stats.n_messages[i] << " messages" << std::endl;
+    }
+    std::cout << "Skipped reports of the live orders: " << stats.n_skipped << std::endl;
+    const VirtualExchangeStats& exchange = runner.GetBacktestStats();
+    std::cout << "Posts: " << exchange.n_posts << "; cancels: " << exchange.n_cancels << "; fills: " << exchange.n_fills << std::endl;
+    runner.GetRiskGate().LogCounters();
+    runner.GetSequencer().LogCounters();
+    return 0;
+}
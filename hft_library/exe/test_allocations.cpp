@@ -0,0 +1,46 @@
+#include <filesystem>
+#include <iostream>
+
+#include "allocations.h"
+#include "runner.h"
+#include "strategies/grid_trading.h"
+#include "test_market_data.h"
+
+// Replay market data in backtest mode and check that the hot path does not allocate in steady state.
+// Built only with HFT_TRACK_ALLOCATIONS=ON.
+// Usage: test_allocations [market_data.bin]  -- synthetic random walk day by default
+
+static_assert(TRACK_ALLOCATIONS, "test_allocations requires the library built with HFT_TRACK_ALLOCATIONS=ON");
+
+constexpr int DEPTH = 10;
+constexpr int N_EVENTS = 200'000;
+constexpr double WARMUP_FRACTION = 0.5;  // containers reach their steady-state capacity
+
+int main(int argc, char** argv) {
+    const std::string data_path = argc > 1 ? argv[1] : GenerateMarketData(std::filesystem::temp_directory_path() / "hft_test_allocations", DEPTH, N_EVENTS);
+    MarketDataFile data(data_path);
+
+    Runner runner(GetBacktestConfig(data.GetDepth()), [](Runner& runner) {
+        return std::make_shared<GridTrading>(runner, runner.GetConfig()["strategy"]);
+    });
+    const size_t warmup_end = static_cast<size_t>(data.Size() * WARMUP_FRACTION);
+    runner.StartBacktest();
+    runner.Replay(data, 0, warmup_end);
+    runner.ResetReplayAllocations();
+    runner.Replay(data, warmup_end, data.Size());
+
+    // Check steady state
+    bool ok = true;
+    const std::pair<const char*, ReplayEvent> events[] = {
+        {"OrderBook", ReplayEvent::OrderBook},
+        {"Trade", ReplayEvent::Trade},
+        {"Fill", ReplayEvent::Fill}};
+    for (const auto& [name, event] : events) {
+        const EventAllocations& allocations = runner.GetReplayAllocations(event);
+        std::cout << name << ": events=" << allocations.n_events << "; allocations=" << allocations.n_allocations
+                  << "; events_with_allocations=" << allocations.n_events_with_allocations << std::endl;
+        ok &= allocations.n_events > 0 && allocations.n_allocations == 0;
+    }
+    std::cout << (ok ? "OK" : "FAILED: steady-state replay allocates or has no events") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+
+#include "backtest/market_data_server.h"
+#include "connector/instruments.h"
+#include "runner.h"
+#include "strategies/grid_trading.h"
+#include "test_utils.h"
+
+// Check InstrumentMetadataCache against the in-process InstrumentsService stand-in (backtest/market_data_server.h):
+// cold start, cache hit and stale cache, a mismatch at startup and on the background refresh, and backtests without the cache.
+// Usage: test_instruments [private/load_test.yaml]  -- runner: figi, lot_size, px_step; load_test: server {cert, key}, root_cert
+
+// Stand-in on its own port; lot_size != 0 overrides the served lot
+ConfigType GetServerConfig(const ConfigType& config, const std::string& address, int lot_size) {
+    ConfigType server_config = YAML::Clone(config);
+    server_config["load_test"]["server"]["address"] = address;
+    if (lot_size != 0) {
+        server_config["load_test"]["instrument"]["lot_size"] = lot_size;
+    }
+    return server_config;
+}
+
+ConfigType GetCacheConfig(const std::filesystem::path& directory, int max_age_h) {
+    ConfigType cache_config;
+    cache_config["cache_directory"] = directory.string();
+    cache_config["max_age_h"] = max_age_h;
+    return cache_config;
+}
+
+// Instrument of the config or of the metadata
+ConfigType GetInstrumentConfig(const ConfigType& config, bool with_lot_size) {
+    ConfigType instrument_config;
+    instrument_config["runner"]["figi"] = config["runner"]["figi"].as<std::string>();
+    if (with_lot_size) {
+        instrument_config["runner"]["lot_size"] = config["runner"]["lot_size"].as<int>();
+        instrument_config["runner"]["px_step"] = config["runner"]["px_step"].as<double>();
+    }
+    return instrument_config;
+}
+
+bool IsRejected(const ConfigType& instrument_config, const InstrumentMetadataCache& cache) {
+    try {
+        MakeInstrument(instrument_config, &cache, GetNullLogger("instruments"));
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+void TestMatch(const ConfigType& config, const std::filesystem::path& directory) {
+    const std::string figi = config["runner"]["figi"].as<std::string>();
+    MarketDataServer server(GetServerConfig(config, "localhost:50061", 0));
+    InvestApiClient client(server.GetAddress(), "test");
+
+    {
+        InstrumentMetadataCache cache(GetCacheConfig(directory, 24), figi, &client, GetNullLogger("instruments"));
+        Check(cache.Get() && server.GetInstrumentRequests() == 1, "cold start fetches the metadata");
+        Check(std::filesystem::exists(directory / (figi + ".bin")), "fetched metadata is saved");
+        const Instrument instrument = MakeInstrument(GetInstrumentConfig(config, false), &cache, GetNullLogger("instruments"));
+        Check(instrument.lot_size == config["runner"]["lot_size"].as<int>() && std::abs(instrument.px_step - config["runner"]["px_step"].as<double>()) < 1e-9,
+              "lot_size and px_step are taken from the metadata");
+    }
+
+    // Cache hit: no request at startup, the refresh confirms the instrument
+    InstrumentMetadataCache cache(GetCacheConfig(directory, 24), figi, &client, GetNullLogger("instruments"));
+    Check(cache.Get() && server.GetInstrumentRequests() == 1, "fresh cache is used without a request");
+    const Instrument instrument = MakeInstrument(GetInstrumentConfig(config, true), &cache, GetNullLogger("instruments"));
+    bool is_mismatch = false;
+    cache.StartRefresh(instrument, [&is_mismatch](const std::string&) { is_mismatch = true; });
+    cache.StopRefresh();
+    Check(server.GetInstrumentRequests() == 2 && !is_mismatch, "refresh of the cache confirms the instrument");
+
+    // Stale cache is fetched at startup and not refreshed again
+    InstrumentMetadataCache stale_cache(GetCacheConfig(directory, 0), figi, &client, GetNullLogger("instruments"));
+    Check(stale_cache.Get() && server.GetInstrumentRequests() == 3, "stale cache is fetched at startup");
+    stale_cache.StartRefresh(instrument, [&is_mismatch](const std::string&) { is_mismatch = true; });
+    stale_cache.StopRefresh();
+    Check(server.GetInstrumentRequests() == 3, "fetched metadata is not refreshed");
+}
+
+void TestMismatch(const ConfigType& config, const std::filesystem::path& directory) {
+    const std::string figi = config["runner"]["figi"].as<std::string>();
+    MarketDataServer server(GetServerConfig(config, "localhost:50062", config["runner"]["lot_size"].as<int>() * 10));
+    InvestApiClient client(server.GetAddress(), "test");
+
+    // The cache of TestMatch is fresh: the mismatch is found by the refresh
+    {
+        InstrumentMetadataCache cache(GetCacheConfig(directory, 24), figi, &client, GetNullLogger("instruments"));
+        const Instrument instrument = MakeInstrument(GetInstrumentConfig(config, true), &cache, GetNullLogger("instruments"));
+        std::string error;
+        cache.StartRefresh(instrument, [&error](const std::string& mismatch) { error = mismatch; });
+        cache.StopRefresh();
+        Check(error.find("lot_size") != std::string::npos, "refresh reports the mismatch of lot_size");
+    }
+
+    // The refresh has saved the new metadata: the next start rejects the config
+    {
+        InstrumentMetadataCache cache(GetCacheConfig(directory, 24), figi, &client, GetNullLogger("instruments"));
+        Check(server.GetInstrumentRequests() == 1 && IsRejected(GetInstrumentConfig(config, true), cache), "cached mismatch is rejected at startup");
+    }
+
+    // Cold start
+    std::filesystem::remove_all(directory);
+    InstrumentMetadataCache cache(GetCacheConfig(directory, 24), figi, &client, GetNullLogger("instruments"));
+    Check(server.GetInstrumentRequests() == 2 && IsRejected(GetInstrumentConfig(config, true), cache), "fetched mismatch is rejected at startup");
+}
+
+// The cache of TestMismatch contradicts the config: backtests do not read it
+void TestBacktest(const ConfigType& config, const std::filesystem::path& directory) {
+    ConfigType backtest_config = GetInstrumentConfig(config, true);
+    backtest_config["runner"]["mode"] = "backtest";
+    backtest_config["runner"]["instrument"]["cache_directory"] = directory.string();
+    backtest_config["market"]["depth"] = 5;
+    backtest_config["backtest"]["money"] = 100'000;
+    backtest_config["strategy"]["debug"] = false;
+    backtest_config["strategy"]["spread"] = 2;
+    backtest_config["strategy"]["order_size"] = 1;
+    backtest_config["strategy"]["max_levels"] = 5;
+    bool is_constructed = true;
+    try {
+        Runner runner(backtest_config, [](Runner& runner) { return std::make_shared<GridTrading>(runner, runner.GetStrategyConfig()); });
+    } catch (const std::runtime_error&) {
+        is_constructed = false;
+    }
+    Check(is_constructed, "backtest does not read the instrument cache");
+}
+
+int main(int argc, char** argv) {
+    const std::string config_path = argc > 1 ? argv[1] : "private/load_test.yaml";
+    const ConfigType config = YAML::LoadFile(config_path);
+    if (config["load_test"]["root_cert"]) setenv("GRPC_DEFAULT_SSL_ROOTS_FILE_PATH", config["load_test"]["root_cert"].as<std::string>().c_str(), 1);
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "hft_test_instruments";
+    std::filesystem::remove_all(directory);
+
+    TestMatch(config, directory);
+    TestMismatch(config, directory);
+    TestBacktest(config, directory);
+    std::filesystem::remove_all(directory);
+    return Report();
+}
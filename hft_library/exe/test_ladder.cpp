@@ -0,0 +1,91 @@
+#include <string>
+
+#include "connector/ladder.h"
+#include "test_utils.h"
+
+// Check PriceLadder: qty and best prices of a snapshot, levels cleared by the next one, moves of the best price across
+// the edge of the window, empty levels of a thin book and the count of levels outside the window.
+// Usage: test_ladder
+
+constexpr int SIZE = 16;
+constexpr int DEPTH = 3;
+
+struct Book {
+    int bid_px[DEPTH];
+    int bid_qty[DEPTH];
+    int ask_px[DEPTH];
+    int ask_qty[DEPTH];
+};
+
+void Update(PriceLadder& ladder, const Book& book) {
+    ladder.Update(book.bid_px, book.bid_qty, book.ask_px, book.ask_qty, DEPTH);
+}
+
+void TestSnapshot() {
+    PriceLadder ladder(SIZE, DEPTH);
+    Update(ladder, Book{{100, 99, 97}, {5, 6, 7}, {101, 102, 103}, {1, 2, 3}});
+    Check(ladder.GetBestPx<true>() == 100 && ladder.GetBestPx<false>() == 101, "best prices of the snapshot");
+    Check(ladder.GetQty<true>(99) == 6 && ladder.GetQty<false>(103) == 3, "qty at the levels");
+    Check(ladder.GetQty<true>(98) == 0 && ladder.GetQty<true>(101) == 0 && ladder.GetQty<false>(100) == 0, "no qty between the levels and across the sides");
+
+    Update(ladder, Book{{100, 98, 97}, {5, 8, 7}, {101, 102, 103}, {1, 2, 3}});
+    Check(ladder.GetQty<true>(99) == 0 && ladder.GetQty<true>(98) == 8, "levels of the previous snapshot are cleared");
+    Check(ladder.GetDroppedLevels() == 0, "no level is dropped inside the window");
+}
+
+void TestMoveAcrossEdge() {
+    PriceLadder ladder(SIZE, DEPTH);
+    Update(ladder, Book{{100, 99, 98}, {5, 6, 7}, {101, 102, 103}, {1, 2, 3}});
+
+    // The best prices jump beyond the window of the previous book: the window is recentered before the levels are set
+    Update(ladder, Book{{120, 119, 118}, {4, 5, 6}, {121, 122, 123}, {7, 8, 9}});
+    Check(ladder.GetBestPx<true>() == 120 && ladder.GetBestPx<false>() == 121, "best prices follow the jump");
+    Check(ladder.GetQty<true>(119) == 5 && ladder.GetQty<false>(123) == 9, "levels beyond the old window are set");
+    // 100 and 116 share a slot: the old level must not show through
+    Check(ladder.GetQty<true>(100) == 0 && ladder.GetQty<false>(101) == 0, "levels left behind the window are zero");
+    Check(ladder.GetQty<true>(116) == 0 && ladder.GetQty<false>(117) == 0, "slots of the old levels are cleared");
+    Check(ladder.GetDroppedLevels() == 0, "no level is dropped after recentering");
+
+    // Step by step down to the edge of the middle half and over it
+    int n_wrong = 0;
+    for (int bid_px = 119; bid_px >= 90; --bid_px) {
+        Update(ladder, Book{{bid_px, bid_px - 1, bid_px - 2}, {1, 2, 3}, {bid_px + 1, bid_px + 2, bid_px + 3}, {4, 5, 6}});
+        n_wrong += ladder.GetQty<true>(bid_px - 2) != 3 || ladder.GetQty<false>(bid_px + 3) != 6 || ladder.GetQty<true>(bid_px + 1) != 0 ||
+                   ladder.GetQty<false>(bid_px + 4) != 0 || !ladder.IsInWindow(bid_px - 2) || !ladder.IsInWindow(bid_px + 3);
+    }
+    Check(n_wrong == 0 && ladder.GetDroppedLevels() == 0, "window follows a walk of the best price");
+}
+
+void TestEmptyLevels() {
+    PriceLadder ladder(SIZE, DEPTH);
+    Update(ladder, Book{{100, 99, 98}, {5, 6, 7}, {101, 102, 103}, {1, 2, 3}});
+
+    // Level 0 of a thin book may be empty: the best px is the first level with qty
+    Update(ladder, Book{{0, 99, 98}, {0, 6, 7}, {101, 102, 103}, {1, 2, 3}});
+    Check(ladder.GetBestPx<true>() == 99 && ladder.GetQty<true>(98) == 7, "empty level 0 is skipped for the best bid");
+
+    // A one-sided book far away recenters at its best px: an empty level 0 does not anchor the window at px 0
+    Update(ladder, Book{{0, 0, 0}, {0, 0, 0}, {0, 300, 301}, {0, 4, 5}});
+    Check(ladder.GetBestPx<true>() == 0 && ladder.GetBestPx<false>() == 300, "empty bid side has no best px");
+    Check(ladder.GetQty<false>(300) == 4 && ladder.GetQty<false>(301) == 5 && ladder.GetDroppedLevels() == 0, "one-sided book is inside the window");
+
+    // An empty book keeps the window
+    Update(ladder, Book{{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}});
+    Check(ladder.GetBestPx<false>() == 0 && ladder.GetQty<false>(300) == 0 && ladder.IsInWindow(300), "empty book keeps the window");
+}
+
+void TestDroppedLevels() {
+    PriceLadder ladder(SIZE, DEPTH);
+    // A book wider than the window: the outer levels are dropped and counted
+    Update(ladder, Book{{100, 99, 80}, {5, 6, 7}, {101, 102, 130}, {1, 2, 3}});
+    Check(ladder.GetQty<true>(80) == 0 && ladder.GetQty<false>(130) == 0 && ladder.GetQty<true>(99) == 6, "levels outside the window are not set");
+    Check(ladder.GetDroppedLevels() == 2, "levels outside the window are counted");
+}
+
+int main() {
+    TestSnapshot();
+    TestMoveAcrossEdge();
+    TestEmptyLevels();
+    TestDroppedLevels();
+    return Report();
+}
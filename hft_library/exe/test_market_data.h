@@ -0,0 +1,71 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include "backtest/market_data.h"
+#include "config.h"
+
+// Market data fixture of the backtest test executables
+
+// Random walk day of one px spread with trades at the best prices: orderbook.txt and trades.txt in the format
+// of the logs are written to directory and converted. Returns the path of market_data.bin
+inline std::string GenerateMarketData(const std::filesystem::path& directory, int depth, int n_events) {
+    std::filesystem::create_directories(directory);
+    std::ofstream orderbook(directory / "orderbook.txt");
+    std::ofstream trades(directory / "trades.txt");
+    orderbook << "strategy_time,exchange_time";
+    for (int i = 0; i < depth; ++i) {
+        orderbook << ",bid_px_" << i << ",bid_qty_" << i << ",ask_px_" << i << ",ask_qty_" << i;
+    }
+    orderbook << "\n";
+    trades << "strategy_time,exchange_time,direction,px,qty\n";
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<int> qty_distribution(1, 50);
+    int ask_px = 10000;
+    TimeType time = 1'700'000'000'000'000'000;
+    for (int i = 0; i < n_events; ++i) {
+        time += 1'000'000;
+        TimeType exchange_time = time;
+        TimeType receive_time = time + 300'000;
+        if (rng() % 3 == 0) {
+            // Trade at the best price
+            bool is_buy = rng() % 2 == 0;
+            trades << receive_time << "," << exchange_time << "," << (is_buy ? "Buy" : "Sell") << "," << (is_buy ? ask_px : ask_px - 1) << "," << qty_distribution(rng) << "\n";
+        } else {
+            // Random walk of the spread of one px step
+            ask_px += static_cast<int>(rng() % 3) - 1;
+            orderbook << receive_time << "," << exchange_time;
+            for (int j = 0; j < depth; ++j) {
+                orderbook << "," << ask_px - 1 - j << "," << qty_distribution(rng) << "," << ask_px + j << "," << qty_distribution(rng);
+            }
+            orderbook << "\n";
+        }
+    }
+    orderbook.close();
+    trades.close();
+
+    std::string output_path = directory / "market_data.bin";
+    MarketDataFile::Convert(directory / "orderbook.txt", directory / "trades.txt", output_path);
+    return output_path;
+}
+
+// GridTrading backtest of the synthetic instrument
+inline ConfigType GetBacktestConfig(int depth) {
+    ConfigType config;
+    config["runner"]["figi"] = "TEST";
+    config["runner"]["lot_size"] = 1;
+    config["runner"]["px_step"] = 0.01;
+    config["runner"]["mode"] = "backtest";
+    config["market"]["depth"] = depth;
+    config["backtest"]["money"] = 100'000'000;
+    config["backtest"]["qty"] = 50;
+    config["strategy"]["debug"] = false;
+    config["strategy"]["spread"] = 2;
+    config["strategy"]["order_size"] = 1;
+    config["strategy"]["max_levels"] = 5;
+    return config;
+}
@@ -0,0 +1,85 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "plugin.h"
+#include "runner.h"
+#include "test_market_data.h"
+#include "test_utils.h"
+
+// Reload grid_trading_plugin as plugin_host does on SIGHUP in a backtest: the new version resumes from the state of the
+// old one over the same resting orders. A copy of the plugin with another ABI record is rejected before it is loaded.
+// Usage: test_plugin_reload [grid_trading_plugin.so]  -- ../plugins/grid_trading_plugin.so of the executable by default
+
+constexpr int DEPTH = 5;
+constexpr int N_EVENTS = 20'000;
+
+// Remember the last strategy built by the getter
+Runner::StrategyGetter Track(Runner::StrategyGetter strategy_getter, std::weak_ptr<Strategy>& current) {
+    return [strategy_getter = std::move(strategy_getter), &current](Runner& runner) {
+        std::shared_ptr<Strategy> strategy = strategy_getter(runner);
+        current = strategy;
+        return strategy;
+    };
+}
+
+void TestReload(const std::string& plugin_path, const MarketDataFile& data) {
+    std::weak_ptr<Strategy> current;
+    Runner runner(GetBacktestConfig(DEPTH), Track(StrategyPlugin::Load(plugin_path)->GetStrategyGetter(), current));
+    runner.StartBacktest();
+    runner.Replay(data, 0, data.Size() / 2);
+
+    std::weak_ptr<Strategy> old_version = current;
+    const std::string state = old_version.lock()->SaveState();
+    const size_t n_orders = runner.GetUserConnector().GetPositions().orders.size();
+    const int n_fills = runner.GetBacktestStats().n_fills;
+    Check(!state.empty() && n_orders > 0, "old version has a state and resting orders");
+
+    runner.ReplaceStrategy(0, Track(StrategyPlugin::Load(plugin_path)->GetStrategyGetter(), current));
+    std::shared_ptr<Strategy> new_version = current.lock();
+    Check(old_version.expired() && new_version, "old version is replaced and destroyed");
+    Check(new_version->SaveState() == state, "new version loads the state of the old one");
+    Check(runner.GetUserConnector().GetPositions().orders.size() == n_orders, "resting orders are kept");
+
+    runner.Replay(data, data.Size() / 2, data.Size());
+    Check(runner.GetBacktestStats().n_fills > n_fills, "new version trades");
+}
+
+void TestAbiMismatch(const std::string& plugin_path) {
+    const std::optional<PluginAbi> abi = StrategyPlugin::ReadAbi(plugin_path);
+    Check(abi && *abi == MakePluginAbi(), "plugin has the ABI record of the host");
+
+    // Copy with another ABI version
+    std::ifstream input(plugin_path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    const PluginAbi host_abi = MakePluginAbi();
+    const size_t offset = bytes.find(std::string(reinterpret_cast<const char*>(&host_abi), sizeof(PluginAbi)));
+    Check(offset != std::string::npos, "ABI record is found in the file");
+    if (offset == std::string::npos) {
+        return;
+    }
+    PluginAbi other_abi = host_abi;
+    ++other_abi.version;
+    std::memcpy(bytes.data() + offset, &other_abi, sizeof(PluginAbi));
+    const std::filesystem::path other_path = std::filesystem::temp_directory_path() / "hft_test_plugin_reload_other_abi.so";
+    std::ofstream(other_path, std::ios::binary) << bytes;
+
+    bool is_rejected = false;
+    try {
+        StrategyPlugin::Load(other_path.string());
+    } catch (const std::runtime_error&) {
+        is_rejected = true;
+    }
+    Check(is_rejected, "plugin with another ABI record is rejected");
+    std::filesystem::remove(other_path);
+}
+
+int main(int argc, char** argv) {
+    const std::string plugin_path = argc > 1 ? argv[1] : (std::filesystem::path(argv[0]).parent_path() / ".." / "plugins" / "grid_trading_plugin.so").string();
+    MarketDataFile data(GenerateMarketData(std::filesystem::temp_directory_path() / "hft_test_plugin_reload", DEPTH, N_EVENTS));
+
+    TestReload(plugin_path, data);
+    TestAbiMismatch(plugin_path);
+    return Report();
+}
@@ -0,0 +1,97 @@
+#include <string>
+
+#include "connector/sequencer.h"
+#include "test_utils.h"
+
+// Check StreamSequencer: dropped and processed out-of-order events, duplicate fills by trade id, the merged sequence
+// and the counters of each anomaly class.
+// Usage: test_sequencer
+
+StreamSequencer MakeSequencer(int stale_book_ms) {
+    ConfigType config;
+    config["stale_book_ms"] = stale_book_ms;
+    return StreamSequencer(config, GetNullLogger("sequencer"));
+}
+
+void TestOrderBooks() {
+    StreamSequencer sequencer = MakeSequencer(0);
+    Check(sequencer.OnOrderBook(1'000, 1'100), "first book is accepted");
+    Check(!sequencer.OnOrderBook(900, 1'200), "older book is dropped");
+    Check(sequencer.OnOrderBook(1'000, 1'300), "book of the same time is accepted");
+    Check(sequencer.GetLast(StreamType::OrderBook).sequence == 2 && sequencer.GetLast(StreamType::OrderBook).receive_time == 1'300, "dropped book is not stamped");
+    Check(sequencer.GetAnomalies(StreamAnomaly::OrderBookOutOfOrder) == 1, "out-of-order book is counted");
+
+    // Without stale_book_ms a book older than the last trade is kept
+    sequencer.OnTrade(5'000'000'000, 5'000'000'100);
+    Check(sequencer.OnOrderBook(2'000, 5'000'000'200), "book behind the trades is kept without stale_book_ms");
+}
+
+void TestStaleBook() {
+    StreamSequencer sequencer = MakeSequencer(1);
+    sequencer.OnTrade(10'000'000, 10'000'100);
+    Check(sequencer.OnOrderBook(9'500'000, 10'000'200), "book within stale_book_ms of the trade is accepted");
+    Check(!sequencer.OnOrderBook(8'000'000, 10'000'300) && sequencer.GetAnomalies(StreamAnomaly::OrderBookStale) == 0, "older book is out of order first");
+    sequencer.OnFill("1", 20'000'000, 20'000'100);
+    Check(!sequencer.OnOrderBook(18'000'000, 20'000'200), "book older than the fill by more than stale_book_ms is dropped");
+    Check(sequencer.GetAnomalies(StreamAnomaly::OrderBookStale) == 1, "stale book is counted");
+}
+
+void TestTrades() {
+    StreamSequencer sequencer = MakeSequencer(0);
+    sequencer.OnTrade(2'000, 2'100);
+    sequencer.OnTrade(1'000, 2'200);
+    Check(sequencer.GetLast(StreamType::Trades).sequence == 2 && sequencer.GetLast(StreamType::Trades).exchange_time == 1'000, "out-of-order trade is processed");
+    Check(sequencer.GetAnomalies(StreamAnomaly::TradeOutOfOrder) == 1, "out-of-order trade is counted");
+}
+
+void TestFills() {
+    StreamSequencer sequencer = MakeSequencer(0);
+    sequencer.OnOrderBook(1'000, 1'100);
+    Check(sequencer.OnFill("trade-1", 2'000, 2'100), "new trade id is accepted");
+    Check(sequencer.IsBookBehindFills() && sequencer.GetAnomalies(StreamAnomaly::BookBehindFill) == 1, "fill newer than the book is counted");
+    Check(!sequencer.OnFill("trade-1", 2'000, 2'200), "known trade id is suppressed");
+    Check(sequencer.GetAnomalies(StreamAnomaly::FillDuplicate) == 1 && sequencer.GetLast(StreamType::Orders).sequence == 1, "duplicate is counted and not stamped");
+    Check(sequencer.OnFill("", 2'000, 2'300) && sequencer.OnFill("", 2'000, 2'400), "empty trade id is not checked");
+
+    // Trade ids of a resync are remembered without stamping
+    Check(sequencer.MarkFill("trade-2") && !sequencer.MarkFill("trade-2"), "MarkFill remembers the trade id");
+    Check(!sequencer.OnFill("trade-2", 3'000, 3'100), "fill marked by a resync is suppressed");
+
+    // Ids are compared as strings: long ids with a common prefix are distinct
+    const std::string prefix(64, 'x');
+    Check(sequencer.OnFill(prefix + "a", 4'000, 4'100) && sequencer.OnFill(prefix + "b", 4'000, 4'200), "long trade ids are compared in full");
+    sequencer.OnOrderBook(5'000, 5'100);
+    Check(!sequencer.IsBookBehindFills(), "book catches up with the fills");
+}
+
+void TestFillIdsRing() {
+    StreamSequencer sequencer = MakeSequencer(0);
+    sequencer.OnFill("first", 1'000, 1'100);
+    // The oldest trade id is forgotten when the ring is full
+    int n_accepted = 0;
+    for (int i = 0; i < 1'000 && !sequencer.MarkFill("first"); ++i) {
+        n_accepted += sequencer.MarkFill("id-" + std::to_string(i));
+    }
+    Check(n_accepted > 0 && sequencer.GetAnomalies(StreamAnomaly::FillDuplicate) == 0, "oldest trade id leaves the ring after the capacity");
+}
+
+void TestMergedSequence() {
+    StreamSequencer sequencer = MakeSequencer(0);
+    sequencer.OnOrderBook(1'000, 1'100);
+    sequencer.OnTrade(1'000, 1'200);
+    sequencer.OnFill("1", 1'000, 1'300);
+    sequencer.OnOrderBook(500, 1'400);  // dropped
+    Check(sequencer.GetMergedSequence() == 3, "merged sequence counts the accepted events");
+    Check(sequencer.GetLast(StreamType::OrderBook).merged_sequence == 1 && sequencer.GetLast(StreamType::Trades).merged_sequence == 2 && sequencer.GetLast(StreamType::Orders).merged_sequence == 3,
+          "streams are stamped in the order of processing");
+}
+
+int main() {
+    TestOrderBooks();
+    TestStaleBook();
+    TestTrades();
+    TestFills();
+    TestFillIdsRing();
+    TestMergedSequence();
+    return Report();
+}
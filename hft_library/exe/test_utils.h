@@ -0,0 +1,27 @@
+#pragma once
+
+#include <spdlog/sinks/null_sink.h>
+#include <spdlog/spdlog.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Harness of the test executables: Check prints each result, Report prints the summary and returns the exit code
+
+inline bool g_ok = true;
+
+inline void Check(bool condition, const std::string& name) {
+    std::cout << (condition ? "OK      " : "FAILED  ") << name << std::endl;
+    g_ok &= condition;
+}
+
+inline int Report() {
+    std::cout << (g_ok ? "OK" : "FAILED") << std::endl;
+    return g_ok ? 0 : 1;
+}
+
+// Logger of the code under test: the output of the test is the checks only
+inline std::shared_ptr<spdlog::logger> GetNullLogger(const std::string& name) {
+    return std::make_shared<spdlog::logger>(name, std::make_shared<spdlog::sinks::null_sink_mt>());
+}
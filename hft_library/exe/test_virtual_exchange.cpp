@@ -0,0 +1,104 @@
+#include <string>
+#include <vector>
+
+#include "backtest/virtual_exchange.h"
+#include "test_utils.h"
+
+// Check the fill logic of VirtualExchange (without the queue model): crossing books, trades through our px,
+// price priority inside a side and posting order across the sides.
+// Usage: test_virtual_exchange
+
+std::vector<VirtualFill> DrainFills(VirtualExchange& exchange) {
+    std::vector<VirtualFill> fills;
+    VirtualFill fill;
+    while (exchange.NextFill(fill)) {
+        fills.push_back(fill);
+    }
+    return fills;
+}
+
+bool IsFill(const VirtualFill& fill, const std::string& order_id, Direction direction, int px, int qty) {
+    return fill.order_id == order_id && fill.direction == direction && fill.px == px && fill.qty == qty;
+}
+
+void TestCrossingBook() {
+    VirtualExchange exchange;
+    exchange.OnOrderBook(99, 101);
+    const std::string buy_id = exchange.PostOrder(100, 2, Direction::Buy);
+    const std::string sell_id = exchange.PostOrder(102, 1, Direction::Sell);
+    Check(DrainFills(exchange).empty(), "resting orders inside the spread are not filled");
+
+    // The ask moves through our bid: the whole order fills at its own px
+    exchange.OnOrderBook(98, 100);
+    std::vector<VirtualFill> fills = DrainFills(exchange);
+    Check(fills.size() == 1 && IsFill(fills[0], buy_id, Direction::Buy, 100, 2), "book crossing our bid fills it at the order px");
+    Check(!exchange.CancelOrder(buy_id), "filled order is not resting");
+    Check(exchange.CancelOrder(sell_id), "resting order is cancelled");
+    Check(exchange.GetStats().n_fills == 1 && exchange.GetStats().filled_qty == 2 && exchange.GetStats().inventory == 2, "stats of the crossing fill");
+}
+
+void TestTradeLiquidity() {
+    VirtualExchange exchange;
+    exchange.OnOrderBook(99, 101);
+    const std::string first_id = exchange.PostOrder(100, 5, Direction::Buy);
+    const std::string second_id = exchange.PostOrder(100, 5, Direction::Buy);
+
+    // A sell trade at our px fills up to its qty, the orders share it
+    exchange.OnTrade(Direction::Sell, 100, 7);
+    std::vector<VirtualFill> fills = DrainFills(exchange);
+    Check(fills.size() == 2 && IsFill(fills[0], first_id, Direction::Buy, 100, 5) && IsFill(fills[1], second_id, Direction::Buy, 100, 2),
+          "trade qty is shared by the orders at its px");
+
+    // A buy trade does not reach our bids; the next book resets the trade liquidity
+    exchange.OnTrade(Direction::Buy, 100, 10);
+    Check(DrainFills(exchange).empty(), "trade of the same side does not fill");
+    exchange.OnOrderBook(99, 101);
+    Check(DrainFills(exchange).empty(), "book resets the liquidity of the trade");
+
+    // A trade through our px fills the rest
+    exchange.OnTrade(Direction::Sell, 99, 10);
+    fills = DrainFills(exchange);
+    Check(fills.size() == 1 && IsFill(fills[0], second_id, Direction::Buy, 100, 3), "trade through our px fills the rest");
+}
+
+void TestPricePriority() {
+    VirtualExchange exchange;
+    exchange.OnOrderBook(99, 103);
+    const std::string low_id = exchange.PostOrder(100, 1, Direction::Buy);
+    const std::string high_id = exchange.PostOrder(102, 1, Direction::Buy);
+
+    // Both bids are crossed: the higher one fills first
+    exchange.OnOrderBook(97, 98);
+    std::vector<VirtualFill> fills = DrainFills(exchange);
+    Check(fills.size() == 2 && IsFill(fills[0], high_id, Direction::Buy, 102, 1) && IsFill(fills[1], low_id, Direction::Buy, 100, 1),
+          "bids fill from the highest px");
+
+    const std::string high_ask_id = exchange.PostOrder(105, 1, Direction::Sell);
+    const std::string low_ask_id = exchange.PostOrder(104, 1, Direction::Sell);
+    exchange.OnOrderBook(106, 107);
+    fills = DrainFills(exchange);
+    Check(fills.size() == 2 && IsFill(fills[0], low_ask_id, Direction::Sell, 104, 1) && IsFill(fills[1], high_ask_id, Direction::Sell, 105, 1),
+          "asks fill from the lowest px");
+}
+
+void TestSidesInPostingOrder() {
+    VirtualExchange exchange;
+    exchange.OnOrderBook(95, 105);
+    const std::string buy_id = exchange.PostOrder(100, 1, Direction::Buy);
+    const std::string sell_id = exchange.PostOrder(99, 1, Direction::Sell);
+
+    // A locked book crosses both sides: px of different sides are not compared, the earlier order fills first
+    exchange.OnOrderBook(101, 98);
+    std::vector<VirtualFill> fills = DrainFills(exchange);
+    Check(fills.size() == 2 && IsFill(fills[0], buy_id, Direction::Buy, 100, 1) && IsFill(fills[1], sell_id, Direction::Sell, 99, 1),
+          "sides fill in the order of posting");
+    Check(exchange.GetStats().inventory == 0 && exchange.GetStats().max_inventory == 1, "inventory after both sides");
+}
+
+int main() {
+    TestCrossingBook();
+    TestTradeLiquidity();
+    TestPricePriority();
+    TestSidesInPostingOrder();
+    return Report();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+// Heap allocations of the current thread.
+// Counted by the replaced global operator new if the library is built with HFT_TRACK_ALLOCATIONS.
+#ifdef HFT_TRACK_ALLOCATIONS
+constexpr bool TRACK_ALLOCATIONS = true;
+#else
+constexpr bool TRACK_ALLOCATIONS = false;
+#endif
+
+struct AllocationCounters {
+    size_t n_allocations = 0;
+    size_t n_bytes = 0;
+};
+
+// Always zero if tracking is disabled
+AllocationCounters GetThreadAllocations();
+
+// Allocations of the events of one type
+struct EventAllocations {
+    size_t n_events = 0;
+    size_t n_allocations = 0;
+    size_t n_events_with_allocations = 0;
+
+    void Add(size_t n) {
+        ++n_events;
+        n_allocations += n;
+        n_events_with_allocations += (n > 0);
+    }
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "backtest/synthetic_market.h"
+#include "runner.h"
+
+// Config of load tests (section load_test):
+//   mode: in_process             -- in_process: call the MarketConnector callbacks from two stream threads
+//                                   grpc: subscribe to the stand-in server at runner.endpoint (exe/market_data_server)
+//   duration_s: 10
+//   orderbook_rate: 100000       -- messages per second of each stream; 0: as fast as possible
+//   trade_rate: 30000
+//   burst_size: 1                -- messages sent back-to-back, bursts keep the average rate
+//   synthetic: {...}             -- SyntheticMarket
+struct LoadTestConfig {
+    double duration_s;
+    double orderbook_rate;
+    double trade_rate;
+    size_t burst_size;
+
+    explicit LoadTestConfig(const ConfigType& config);
+};
+
+struct LoadTestStats {
+    double seconds = 0;
+    NotificationStats notifications;
+    // In-process: from the scheduled send time to the return of the callback (includes waiting for the lock)
+    std::vector<int64_t> orderbook_latencies;
+    std::vector<int64_t> trade_latencies;
+    // Copies of the connector trackers: from the exchange time of the message to its receive time
+    LatencyTracker orderbook_connector_latency;
+    LatencyTracker trade_connector_latency;
+};
+
+// Drive MarketConnector of the Runner with synthetic messages
+class LoadGenerator {
+   private:
+    Runner& m_runner;
+    const ConfigType m_config;
+    const LoadTestConfig m_load;
+
+   public:
+    LoadGenerator(Runner& runner, const ConfigType& config);
+
+    // Backtest mode Runner: the strategy trades against VirtualExchange (fills are not simulated)
+    LoadTestStats RunInProcess();
+
+    // Live mode Runner: only MarketConnector is started, so the strategy is not notified
+    LoadTestStats RunEndToEnd();
+
+   private:
+    // Send messages of one stream at the rate until the end
+    void Produce(SyntheticMarket& market, bool is_trades, double rate, TscClock::TicksType start, TscClock::TicksType end, std::vector<int64_t>& latencies);
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "clock.h"
+
+// Recorded market data: orderbooks and trades merged by receive time
+// File layout: Header, then n_records records of GetRecordSize() bytes.
+// OrderBook records are followed by levels: bid_px[depth], bid_qty[depth], ask_px[depth], ask_qty[depth].
+class MarketDataFile {
+   public:
+    constexpr static char MAGIC[8] = "HFTMD01";
+
+    struct Header {
+        char magic[8];
+        int32_t depth;
+        int32_t reserved;
+        int64_t n_records;
+    };
+
+    enum class RecordType : int32_t {
+        OrderBook = 0,
+        Trade = 1
+    };
+
+    struct Record {
+        TimeType receive_time;   // strategy_time from the logs
+        TimeType exchange_time;  // exchange_time from the logs
+        RecordType type;
+        // Trade fields
+        int32_t direction;  // 1 for buy, -1 for sell
+        int32_t px;
+        int32_t qty;
+    };
+
+   private:
+    const Header* m_header = nullptr;
+    const char* m_records = nullptr;
+    size_t m_size = 0;  // mapped size in bytes
+    size_t m_record_size = 0;
+
+   public:
+    // Map the file read-only: the pages are shared by all readers
+    explicit MarketDataFile(const std::string& path);
+
+    MarketDataFile(const MarketDataFile&) = delete;
+
+    MarketDataFile& operator=(const MarketDataFile&) = delete;
+
+    ~MarketDataFile();
+
+    [[nodiscard]] int GetDepth() const { return m_header->depth; }
+
+    [[nodiscard]] size_t Size() const { return static_cast<size_t>(m_header->n_records); }
+
+    [[nodiscard]] const Record& GetRecord(size_t i) const {
+        return *reinterpret_cast<const Record*>(m_records + i * m_record_size);
+    }
+
+    // Levels of the OrderBook record: bid_px, bid_qty, ask_px, ask_qty blocks of depth elements
+    [[nodiscard]] const int32_t* GetLevels(size_t i) const {
+        return reinterpret_cast<const int32_t*>(m_records + i * m_record_size + sizeof(Record));
+    }
+
+    static size_t GetRecordSize(int depth);
+
+    // Convert orderbook.txt and trades.txt from the log directory. Return number of records
+    static size_t Convert(const std::string& orderbook_path, const std::string& trades_path, const std::string& output_path);
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "connector/utils.h"
+#include "constants.h"
+
+namespace grpc {
+class Server;
+}
+
+class MarketDataStreamServiceImpl;
+
+class InstrumentsServiceImpl;
+
+// Local stand-in of MarketDataStreamService and InstrumentsService of Tinkoff Invest API for end-to-end tests
+// (exe/market_data_server, exe/test_instruments).
+// Each subscription stream gets synthetic orderbooks or trades at the rates of load_test and a ping every second.
+// InstrumentsService.GetInstrumentBy answers with the instrument of runner (the metadata check of the Runner).
+// Config:
+//   runner: figi, lot_size, px_step
+//   load_test: orderbook_rate, trade_rate, burst_size, synthetic
+//     server: {address: 0.0.0.0:50051, cert: server.crt, key: server.key}
+//     instrument: {lot_size, px_step, trading_status: 5, api_trade_available: true}  -- optional: overrides of the metadata to test mismatches
+// The SDK connects with TLS. Self-signed certificate for localhost (trusted by load_test.root_cert):
+//   openssl req -x509 -newkey rsa:2048 -nodes -days 365 -subj "/CN=localhost" -addext "subjectAltName=DNS:localhost" -keyout server.key -out server.crt
+class MarketDataServer {
+   private:
+    const Instrument m_instrument;
+    const std::string m_address;
+    std::unique_ptr<MarketDataStreamServiceImpl> m_market_data_service;
+    std::unique_ptr<InstrumentsServiceImpl> m_instruments_service;
+    std::unique_ptr<grpc::Server> m_server;
+
+   public:
+    // Serves on the threads of gRPC. Throws if the server does not start
+    explicit MarketDataServer(const ConfigType& config);
+
+    MarketDataServer(const MarketDataServer&) = delete;
+
+    MarketDataServer& operator=(const MarketDataServer&) = delete;
+
+    ~MarketDataServer();
+
+    [[nodiscard]] const std::string& GetAddress() const;
+
+    // Block until the server is shut down
+    void Wait();
+
+    // GetInstrumentBy requests of runner.figi
+    [[nodiscard]] size_t GetInstrumentRequests() const;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Results of grid_sweep: one fixed-size record per configuration
+// File layout: Header, parameter names (n_parameters * NAME_SIZE bytes, zero padded),
+// then n_results records: int32 values of the parameters followed by Record (no padding between them).
+// Reader: scripts/research/sweep_results.py
+class SweepResultsFile {
+   public:
+    constexpr static char MAGIC[8] = "HFTSW01";
+    constexpr static size_t NAME_SIZE = 32;
+
+    struct Header {
+        char magic[8];
+        int32_t n_parameters;
+        int32_t reserved;
+        int64_t n_results;
+    };
+
+    struct Record {
+        double pnl = 0;  // mark-to-mid, in px steps
+        int64_t turnover = 0;
+        int64_t filled_qty = 0;
+        int32_t ok = 1;  // 0 if the configuration failed
+        int32_t n_fills = 0;
+        int32_t n_posts = 0;
+        int32_t n_cancels = 0;
+        int32_t max_inventory = 0;
+        int32_t final_qty = 0;  // of the last day
+    };
+
+    // parameters[i] are the values of names for results[i]
+    static void Write(const std::string& path, const std::vector<std::string>& names, const std::vector<std::vector<int>>& parameters, const std::vector<Record>& results);
+};
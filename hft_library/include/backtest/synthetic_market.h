@@ -0,0 +1,46 @@
+#pragma once
+
+#include <random>
+
+#include "config.h"
+#include "connector/utils.h"
+#include "hft_library/third_party/TinkoffInvestSDK/services/marketdatastreamservice.h"
+
+// Synthetic MarketDataResponse messages for load tests: random walk of the best ask with a one-step spread.
+// Config (all optional):
+//   start_px: 10000          -- best ask in px steps
+//   move_probability: 0.1    -- probability of a one-step move per orderbook
+//   max_qty: 50
+//   seed: 0
+class SyntheticMarket {
+   private:
+    const Instrument& m_instrument;
+    const int m_depth;
+    const int64_t m_px_step_nano;  // exact quotations without the floating point of Instrument::PxToQuotation
+    const double m_move_probability;
+    std::mt19937_64 m_rng;
+    std::uniform_real_distribution<double> m_uniform{0.0, 1.0};
+    std::uniform_int_distribution<int> m_qty;
+
+    int m_ask_px;
+
+   public:
+    SyntheticMarket(const Instrument& instrument, int depth, const ConfigType& config);
+
+    // Fill the reused message: no allocations after the first fill
+    void FillOrderBook(MarketDataResponse& response, TimeType time);
+
+    void FillTrade(MarketDataResponse& response, TimeType time);
+
+    // Successful subscription responses
+    void FillOrderBookSubscription(MarketDataResponse& response) const;
+
+    void FillTradesSubscription(MarketDataResponse& response) const;
+
+    static void FillPing(MarketDataResponse& response, TimeType time);
+
+   private:
+    static void SetTime(google::protobuf::Timestamp& timestamp, TimeType time);
+
+    void SetPx(Quotation& quotation, int px) const;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool with per-worker task queues.
+// A worker takes tasks from the back of its own queue and steals from the front of the others.
+class WorkStealingPool {
+   public:
+    using Task = std::function<void()>;
+
+   private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::vector<std::jthread> m_workers;
+    size_t m_next_queue = 0;
+
+    // Pending tasks and sleeping workers
+    std::mutex m_mutex;
+    std::condition_variable_any m_has_tasks;
+    std::condition_variable m_all_done;
+    size_t m_n_queued = 0;
+    size_t m_n_unfinished = 0;
+
+   public:
+    // n_threads = 0: use all cores
+    explicit WorkStealingPool(size_t n_threads);
+
+    ~WorkStealingPool();
+
+    [[nodiscard]] size_t GetThreadsCount() const;
+
+    // Tasks are distributed over the queues round-robin
+    void Submit(Task task);
+
+    // Wait for all submitted tasks
+    void Wait();
+
+   private:
+    void WorkerLoop(std::stop_token stop_token, size_t index);
+
+    bool TryPop(size_t index, Task& task);
+};
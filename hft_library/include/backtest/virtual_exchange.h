@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "connector/market.h"
+#include "connector/utils.h"
+
+struct VirtualFill {
+    std::string order_id;
+    Direction direction;
+    int px;
+    int qty;
+};
+
+struct VirtualExchangeStats {
+    int n_posts = 0;
+    int n_cancels = 0;
+    int n_fills = 0;
+    int64_t filled_qty = 0;  // in lots
+    int64_t turnover = 0;    // sum of px * qty
+    int inventory = 0;       // signed executed qty
+    int max_inventory = 0;   // max of |inventory|
+};
+
+// Simulated exchange for backtests and paper trading: our limit orders are matched against market data.
+// Orders fill at their own px when the book crosses them or a trade prints at or through them.
+// Without the queue model a trade at our px fills us up to the trade qty.
+// Queue model: a new order is behind the visible qty of its level. Trades at our px consume the queue first;
+// a smaller level qty in the next book means cancels ahead of us. Our orders are not in the market book.
+class VirtualExchange {
+   private:
+    constexpr static int UNKNOWN_QTY = -1;  // px is beyond the visible depth
+
+    struct RestingOrder {
+        std::string order_id;
+        Direction direction;
+        int px;
+        int qty;
+        int queue_ahead = 0;     // visible qty ahead of us at px
+        int trade_fill_qty = 0;  // qty of the last trade at px left after the queue ahead
+    };
+
+    std::vector<RestingOrder> m_orders;
+    size_t m_next_order_id = 0;
+
+    // Book of the queue position of new orders (nullptr: queue is not modelled)
+    const MarketOrderBook* m_queue_book = nullptr;
+
+    // Current market state
+    int m_best_bid_px = 0;
+    int m_best_ask_px = std::numeric_limits<int>::max();
+    // Liquidity of the last trade that is not consumed by our orders
+    Direction m_trade_direction = Direction::Buy;
+    int m_trade_px = 0;
+    int m_trade_qty = 0;
+
+    VirtualExchangeStats m_stats;
+
+   public:
+    // Model queue positions. order_book is the current book when orders are posted
+    void EnableQueueModel(const MarketOrderBook& order_book);
+
+    std::string PostOrder(int px, int qty, Direction direction);
+
+    // Return false if the order is not resting (already filled)
+    bool CancelOrder(const std::string& order_id);
+
+    // Market events
+    void OnOrderBook(const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty, int depth);
+
+    // Without levels the queue ahead is only reduced by trades
+    void OnOrderBook(int best_bid_px, int best_ask_px);
+
+    void OnTrade(Direction direction, int px, int qty);
+
+    // Match one order against the current market state. Return false if nothing is matched
+    bool NextFill(VirtualFill& fill);
+
+    [[nodiscard]] const VirtualExchangeStats& GetStats() const;
+
+   private:
+    // Executable qty of the order against the current market state
+    int GetExecutableQty(const RestingOrder& order) const;
+
+    // Part of the last trade at the order px that reaches the order
+    int GetTradeFillQty(const RestingOrder& order) const;
+
+    // Qty of the level at px: 0 if there is no such level inside the visible depth; UNKNOWN_QTY beyond it
+    static int GetLevelQty(const int* px, const int* qty, int depth, int target_px, bool is_bid);
+};
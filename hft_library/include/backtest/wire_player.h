@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+
+#include "connector/wire.h"
+#include "runner.h"
+
+struct WirePlayerStats {
+    std::array<size_t, N_WIRE_STREAMS> n_messages{};
+    size_t n_skipped = 0;  // Orders and OrderState messages of the live orders
+    double seconds = 0;
+};
+
+// Feed the recorded stream messages (connector/wire.h) into the stream callbacks of a backtest Runner.
+// Callbacks get the recorded receive time: latencies and logs are reproduced exactly.
+// Our orders are matched by VirtualExchange against the recorded books and trades as in Runner::Replay: the recorded
+// reports of the live orders are skipped.
+class WirePlayer {
+   private:
+    Runner& m_runner;
+    WireReader m_reader;
+    const double m_speed;  // 1: original timing; k: k times faster; 0: as fast as possible
+
+   public:
+    WirePlayer(Runner& runner, const std::string& path, double speed);
+
+    WirePlayerStats Play();
+
+   private:
+    void MatchMarketData(const MarketDataResponse& response);
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HFT_HAS_TSC 1
+#else
+#define HFT_HAS_TSC 0
+#endif
+
+using TimeType = int64_t;  // nanoseconds since epoch
+
+// Clock based on the CPU timestamp counter (TSC)
+// Ticks are converted to epoch nanoseconds with scale and offset calibrated against system_clock in background.
+// Recalibration slews the scale instead of stepping back, so converted time never decreases.
+// Without TSC (non-x86) ticks are steady_clock nanoseconds.
+class TscClock {
+   public:
+    using TicksType = uint64_t;
+
+    // Raw ticks for latency measurement: do not use them as time
+    static TicksType Ticks() {
+#if HFT_HAS_TSC
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    // Raw ticks that wait for the preceding instructions to complete
+    static TicksType TicksOrdered() {
+#if HFT_HAS_TSC
+        unsigned int aux;
+        return __rdtscp(&aux);
+#else
+        return Ticks();
+#endif
+    }
+
+    // Nanoseconds since epoch
+    static TimeType Now() {
+        return TicksToTime(Ticks());
+    }
+
+    static TimeType TicksToTime(TicksType ticks) {
+        return Instance().Convert(ticks);
+    }
+
+    // Convert duration in ticks to nanoseconds
+    static int64_t TicksToNanoseconds(int64_t ticks) {
+        return static_cast<int64_t>((static_cast<__int128>(ticks) * Instance().m_mult.load(std::memory_order_relaxed)) >> MULT_SHIFT);
+    }
+
+    // Calibrated ticks frequency in GHz
+    static double GetFrequency();
+
+    // Is invariant TSC used (synchronized across cores and not affected by frequency changes)
+    static bool IsInvariant();
+
+   private:
+    constexpr static int MULT_SHIFT = 32;  // ns = ticks * m_mult >> MULT_SHIFT
+    constexpr static std::chrono::milliseconds INITIAL_CALIBRATION_PERIOD{10};
+    constexpr static std::chrono::milliseconds CALIBRATION_PERIOD{1000};
+    constexpr static double MAX_SLEW = 500e-6;         // max relative change of the scale to absorb an error
+    constexpr static TimeType MAX_STEP = 10'000'000;  // step forward on errors larger than 10ms
+
+    // Calibration published by seqlock
+    std::atomic<uint64_t> m_sequence = 0;
+    std::atomic<TicksType> m_base_ticks = 0;
+    std::atomic<TimeType> m_base_time = 0;
+    std::atomic<uint64_t> m_mult = 0;
+
+    // Calibration thread
+    std::mutex m_mutex;
+    std::condition_variable_any m_cv;
+    std::jthread m_thread;
+
+    TscClock();
+
+    static TscClock& Instance() {
+        static TscClock clock;
+        return clock;
+    }
+
+    TimeType Convert(TicksType ticks) const {
+        uint64_t sequence;
+        TicksType base_ticks;
+        TimeType base_time;
+        uint64_t mult;
+        do {
+            sequence = m_sequence.load(std::memory_order_acquire);
+            base_ticks = m_base_ticks.load(std::memory_order_relaxed);
+            base_time = m_base_time.load(std::memory_order_relaxed);
+            mult = m_mult.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((sequence & 1) || sequence != m_sequence.load(std::memory_order_relaxed));
+        // ticks may be taken before the current base: keep the difference signed
+        int64_t delta = static_cast<int64_t>(ticks - base_ticks);
+        return base_time + static_cast<int64_t>((static_cast<__int128>(delta) * mult) >> MULT_SHIFT);
+    }
+
+    void Publish(TicksType base_ticks, TimeType base_time, uint64_t mult);
+
+    void CalibrationLoop(std::stop_token stop_token);
+};
@@ -2,4 +2,7 @@
 
 #include "constants.h"
 
-ConfigType read_config();
\ No newline at end of file
+ConfigType read_config();
+
+// Section of the strategy: strategies[strategy_id] or strategy (one strategy)
+ConfigType get_strategy_config(const ConfigType& config, int strategy_id);
\ No newline at end of file
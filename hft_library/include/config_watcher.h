@@ -0,0 +1,103 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "constants.h"
+
+// Immutable snapshots published by one thread and read on the event thread with one atomic load.
+// Old snapshots live until destruction: a reader never sees a freed snapshot, and reloads are rare
+template <typename T>
+class AtomicSnapshot {
+   private:
+    std::vector<std::unique_ptr<const T>> m_snapshots;  // accessed by the publisher
+    std::atomic<const T*> m_current = nullptr;
+
+   public:
+    explicit AtomicSnapshot(T value) {
+        Publish(std::move(value));
+    }
+
+    [[nodiscard]] const T& Get() const {
+        return *m_current.load(std::memory_order_acquire);
+    }
+
+    void Publish(T value) {
+        m_snapshots.push_back(std::make_unique<const T>(std::move(value)));
+        m_current.store(m_snapshots.back().get(), std::memory_order_release);
+    }
+};
+
+// Watch the config file and deliver the parsed config to subscribers on the watcher thread (off the event thread).
+// Subscribers validate their section and publish a snapshot; the file is skipped if it can not be parsed
+// Config (section runner.config_reload, optional):
+//   path: private/config.yaml  -- file to watch
+//   period_ms: 1000            -- period of modification time checks
+class ConfigWatcher {
+   public:
+    using Callback = std::function<void(const ConfigType& config)>;  // throws on invalid parameters
+
+    // Callback is removed on destruction
+    class Subscription {
+       private:
+        ConfigWatcher* m_watcher = nullptr;
+        size_t m_id = 0;
+
+       public:
+        Subscription() = default;
+
+        Subscription(Subscription&& other) noexcept;
+
+        Subscription& operator=(Subscription&& other) noexcept;
+
+        ~Subscription();
+
+       private:
+        friend class ConfigWatcher;
+
+        Subscription(ConfigWatcher* watcher, size_t id);
+    };
+
+   private:
+    std::shared_ptr<spdlog::logger> m_logger;
+
+    // Parameters
+    const std::filesystem::path m_path;
+    const std::chrono::milliseconds m_period;
+
+    // Subscribers: callbacks run under the mutex, so a subscription is not destroyed during its callback
+    std::mutex m_mutex;
+    std::map<size_t, Callback> m_callbacks;
+    size_t m_next_id = 0;
+
+    std::filesystem::file_time_type m_last_write_time;
+    int m_n_reloads = 0;
+
+    // Wakes up the loop on stop
+    std::condition_variable_any m_stop_cv;
+
+    std::jthread m_thread;
+
+   public:
+    ConfigWatcher(const ConfigType& config, std::shared_ptr<spdlog::logger> logger);
+
+    [[nodiscard]] Subscription Subscribe(Callback callback);
+
+    void Start();
+
+   private:
+    void Unsubscribe(size_t id);
+
+    void Loop(std::stop_token stop_token);
+
+    void Reload();
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "clock.h"
+#include "connector/utils.h"
+
+class MarketConnector;
+
+// OHLCV bar of the trade stream. Prices in px steps, volumes in lots
+struct Bar {
+    TimeType start_time = 0;  // exchange time, multiple of the resolution
+    int open = 0;
+    int high = 0;
+    int low = 0;
+    int close = 0;
+    int64_t volume = 0;
+    int64_t buy_volume = 0;  // volume of the trades with Direction::Buy
+    int64_t turnover = 0;    // sum of px * qty
+    int n_trades = 0;
+
+    // Volume-weighted px in px steps
+    [[nodiscard]] double GetVwap() const {
+        return volume > 0 ? static_cast<double>(turnover) / static_cast<double>(volume) : close;
+    }
+};
+
+// Bars of one resolution: the open bar and a ring of the last closed bars.
+// Intervals without trades have no bars. O(1) per trade, no allocations after the construction.
+class BarSeries {
+   public:
+    const TimeType resolution;  // in ns
+
+   private:
+    std::vector<Bar> m_closed;  // ring of the closed bars
+    size_t m_n_closed = 0;
+    Bar m_open_bar;
+    bool m_has_open_bar = false;
+
+   public:
+    BarSeries(TimeType resolution, size_t history);
+
+    // Number of stored closed bars
+    [[nodiscard]] size_t Size() const;
+
+    // Closed bars: [0] => last closed bar
+    [[nodiscard]] const Bar& operator[](size_t i) const;
+
+    // Bar of the current interval: nullptr if there are no trades in it yet
+    [[nodiscard]] const Bar* GetOpenBar() const;
+
+   private:
+    friend class MarketConnector;
+
+    // Close the open bar if time is past its interval. Return true if a bar is closed
+    bool CloseBefore(TimeType time);
+
+    // Trades that are late for the open bar interval are added to the open bar
+    void AddTrade(TimeType time, Direction direction, int px, int qty);
+};
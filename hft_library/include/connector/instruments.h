@@ -0,0 +1,84 @@
+#pragma once
+
+#include <spdlog/fmt/ostr.h>
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <thread>
+
+#include "connector/utils.h"
+#include "constants.h"
+#include "hft_library/third_party/TinkoffInvestSDK/investapiclient.h"
+
+// Metadata of the instrument from InstrumentsService. Stored as is in the cache file: trivially copyable
+struct InstrumentMetadata {
+    char figi[16];
+    char ticker[16];
+    char class_code[16];
+    char currency[8];
+    int32_t lot_size;
+    int32_t trading_status;  // SecurityTradingStatus
+    int64_t px_step_units;   // min_price_increment
+    int32_t px_step_nano;
+    int32_t is_api_trade_available;
+    TimeType update_time;  // ns since epoch
+
+    [[nodiscard]] double GetPxStep() const;
+
+    [[nodiscard]] bool IsNormalTrading() const;
+};
+
+std::ostream& operator<<(std::ostream& os, const InstrumentMetadata& metadata);
+
+// Metadata of runner.figi: the cache file gives an instant start, InstrumentsService confirms it in the background.
+// Without a fresh cache the metadata is fetched at startup (Live and Paper modes; backtests use the config only).
+// Config (section runner.instrument, optional):
+//   cache_directory: private/instruments  -- <figi>.bin with the last fetched metadata
+//   max_age_h: 24                          -- older cache is fetched again at startup
+//   fetch: true                            -- false: only the cache and config (no InstrumentsService)
+class InstrumentMetadataCache {
+   private:
+    std::shared_ptr<spdlog::logger> m_logger;
+    InvestApiClient* m_client;
+
+    // Parameters
+    const std::filesystem::path m_path;
+    const TimeType m_max_age;  // in ns
+    const bool m_fetch;
+
+    std::optional<InstrumentMetadata> m_metadata;
+    bool m_is_from_cache = false;
+
+    // Background refresh of the cache
+    std::jthread m_thread;
+
+   public:
+    InstrumentMetadataCache(const ConfigType& config, const std::string& figi, InvestApiClient* client, std::shared_ptr<spdlog::logger> logger);
+
+    // Metadata at startup: cache or synchronous fetch (nullopt without both)
+    [[nodiscard]] const std::optional<InstrumentMetadata>& Get() const { return m_metadata; }
+
+    // Fetch the metadata in the background if it came from the cache: save it and check the instrument again.
+    // on_mismatch(error) is called on the refresh thread if the fetched metadata contradicts the instrument
+    void StartRefresh(const Instrument& instrument, std::function<void(const std::string& error)> on_mismatch);
+
+    // Wait for the refresh (before the owner of on_mismatch is destroyed)
+    void StopRefresh();
+
+   private:
+    [[nodiscard]] std::optional<InstrumentMetadata> Load() const;
+
+    void Save(const InstrumentMetadata& metadata) const;
+
+    [[nodiscard]] InstrumentMetadata Fetch(const std::string& figi) const;
+};
+
+// Instrument of runner.figi: lot_size and px_step of the config or of the metadata if they are absent (cache is nullptr in Backtest mode).
+// Throws if the config contradicts the metadata
+Instrument MakeInstrument(const ConfigType& config, const InstrumentMetadataCache* cache, const std::shared_ptr<spdlog::logger>& logger);
+
+// Throws std::runtime_error on a mismatch of lot_size or px_step (every px conversion depends on them)
+void CheckInstrument(const Instrument& instrument, const InstrumentMetadata& metadata);
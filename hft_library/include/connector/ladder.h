@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// Both sides of the order book indexed by px: slot px & (size - 1) of a ring buffer that covers the window [anchor, anchor + size).
+// Qty at px and the best prices are O(1). The slot of a px does not depend on the anchor: the window follows the book without shifting levels.
+// Rebuilt from each snapshot in O(depth): the levels of the previous snapshot are cleared, so every slot outside the book is zero.
+// The depth is limited by the window only; levels of a book wider than size ticks are dropped and counted
+class PriceLadder {
+   private:
+    const int m_mask;  // size - 1
+    int m_anchor = 0;  // lowest px of the window
+
+    // qty by slot
+    std::vector<int> m_bid_qty;
+    std::vector<int> m_ask_qty;
+    // px of the levels of the last snapshot
+    std::vector<int> m_bid_pxs;
+    std::vector<int> m_ask_pxs;
+
+    int m_best_bid_px = 0;
+    int m_best_ask_px = 0;
+    size_t m_n_dropped_levels = 0;
+
+   public:
+    // size: ticks of the window (power of 2); depth: levels per side of a snapshot
+    PriceLadder(int size, int depth);
+
+    void Update(const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty, int depth);
+
+    // Market qty resting at px (0 outside the book)
+    template <bool IsBid>
+    [[nodiscard]] int GetQty(int px) const {
+        if (!IsInWindow(px)) {
+            return 0;
+        }
+        if constexpr (IsBid) {
+            return m_bid_qty[px & m_mask];
+        } else {
+            return m_ask_qty[px & m_mask];
+        }
+    }
+
+    // px of the first non-empty level of the side (0 if the side is empty)
+    template <bool IsBid>
+    [[nodiscard]] int GetBestPx() const {
+        if constexpr (IsBid) {
+            return m_best_bid_px;
+        } else {
+            return m_best_ask_px;
+        }
+    }
+
+    [[nodiscard]] bool IsInWindow(int px) const {
+        return static_cast<unsigned>(px - m_anchor) <= static_cast<unsigned>(m_mask);
+    }
+
+    [[nodiscard]] int GetSize() const { return m_mask + 1; }
+
+    // Levels outside the window since the start (runner.status: n_ladder_dropped_levels)
+    [[nodiscard]] size_t GetDroppedLevels() const { return m_n_dropped_levels; }
+
+   private:
+    template <bool IsBid>
+    void SetLevels(const int* px, const int* qty, int depth);
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "clock.h"
+
+// Rolling tracker of latency samples: receive_time - exchange_time
+// Samples include the offset between the local and the exchange clock.
+// The rolling minimum estimates that offset (plus the minimal network delay).
+class LatencyTracker {
+   public:
+    constexpr static size_t WINDOW = 4096;
+
+   private:
+    std::array<int64_t, WINDOW> m_samples{};
+    size_t m_count = 0;
+
+    // Monotonic queue of sample indices for the rolling minimum
+    std::array<size_t, WINDOW> m_min_queue{};
+    size_t m_min_queue_begin = 0;
+    size_t m_min_queue_end = 0;
+
+    // Buffer for percentile computation
+    mutable std::vector<int64_t> m_buffer;
+
+   public:
+    LatencyTracker();
+
+    void Add(TimeType exchange_time, TimeType receive_time);
+
+    [[nodiscard]] bool Empty() const;
+
+    [[nodiscard]] size_t GetCount() const;
+
+    [[nodiscard]] int64_t GetLast() const;
+
+    // O(1)
+    [[nodiscard]] int64_t GetMin() const;
+
+    // O(WINDOW): use for reporting only
+    [[nodiscard]] int64_t GetPercentile(double q) const;
+
+    // Sample number index of the window: index < GetCount() and index + WINDOW >= GetCount()
+    [[nodiscard]] int64_t GetSample(size_t index) const;
+};
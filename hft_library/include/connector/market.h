@@ -3,10 +3,17 @@
 #include <spdlog/fmt/ostr.h>
 #include <spdlog/spdlog.h>
 
+#include <array>
+#include <cassert>
 #include <ctime>
+#include <utility>
 
+#include "connector/bars.h"
+#include "connector/ladder.h"
+#include "connector/latency.h"
 #include "connector/utils.h"
 #include "constants.h"
+#include "supervisor.h"
 #include "hft_library/third_party/TinkoffInvestSDK/investapiclient.h"
 #include "hft_library/third_party/TinkoffInvestSDK/services/marketdatastreamservice.h"
 
@@ -16,18 +23,44 @@ class MarketConnector;
 
 class MarketOrderBook;
 
+struct MarketLevel {
+    int px;   // real_px / px_step
+    int qty;  // real_qty / lot_size
+};
+
+// Order book storage: levels of one side are contiguous (8 levels per cache line), the book is cache line aligned.
+// MarketConnector stores MAX_DEPTH levels; snapshots of the subscribed depth are copied with a compile-time Depth
+template <int Depth>
+struct alignas(64) FixedDepthOrderBook {
+    std::array<MarketLevel, Depth> bid{};
+    std::array<MarketLevel, Depth> ask{};
+};
+
+// Depths of the OrderBook subscription: the snapshot copy is instantiated for each of them
+using OrderBookDepths = std::integer_sequence<int, 1, 10, 20, 30, 40, 50>;
+
+// View of one side of the order book storage
 template <bool IsBidParameter>
 class OneSideMarketOrderBook {
    public:
-    // bid[0], ask[0] => best bid/ask
-    // px = real_px / px_step
-    // qty = real_qty / lot_size
-    int px[MAX_DEPTH] = {0};
-    int qty[MAX_DEPTH] = {0};
     int depth;
 
+   private:
+    const MarketLevel* m_levels = nullptr;
+
+   public:
     OneSideMarketOrderBook(int depth);
 
+    // bid[0], ask[0] => best bid/ask
+    const MarketLevel& operator[](int i) const {
+        assert(0 <= i && i < depth);
+        return m_levels[i];
+    }
+
+    const MarketLevel* begin() const { return m_levels; }
+
+    const MarketLevel* end() const { return m_levels + depth; }
+
     constexpr static bool IsBid() {
         return IsBidParameter;
     }
@@ -42,12 +75,12 @@ class OneSideMarketOrderBook {
     }
 
    private:
-    friend MarketOrderBook;
+    friend MarketConnector;
 };
 
 class MarketOrderBook {
    public:
-    TimeType time;
+    TimeType time = 0;
     OneSideMarketOrderBook<true> bid;
     OneSideMarketOrderBook<false> ask;
 
@@ -58,15 +91,6 @@ class MarketOrderBook {
 
    public:
     MarketOrderBook(const Instrument& instrument, int depth);
-
-    template <bool IsBid>
-    OneSideMarketOrderBook<IsBid>& GetOneSideOrderBook();
-
-   private:
-    friend class MarketConnector;
-
-    template <bool IsBid>
-    void Update(const int* px, const int* qty);
 };
 
 struct MarketTrade {
@@ -96,32 +120,63 @@ class Trades {
 
 std::ostream& operator<<(std::ostream& os, const Trades& trades);
 
+// Strategy notifications are skipped while more events are pending
+struct NotificationStats {
+    size_t n_orderbooks = 0;
+    size_t n_orderbook_skips = 0;
+    size_t n_trades = 0;
+    size_t n_trade_skips = 0;
+};
+
 std::ostream& operator<<(std::ostream& os, const MarketOrderBook& ob);
 
 class MarketConnector {
    private:
     // Runner
     Runner& m_runner;
-    // Client
-    InvestApiClient& m_client;
     // Logger
     std::shared_ptr<spdlog::logger> m_logger;
     std::shared_ptr<spdlog::logger> m_trades_logger;
     std::shared_ptr<spdlog::logger> m_orderbook_logger;
+    std::shared_ptr<spdlog::logger> m_bars_logger;
     // Instrument
     const Instrument& m_instrument;
 
     // MarketDataStream
     std::shared_ptr<MarketDataStream> m_market_data_stream;
 
+    // Subscriptions: incremented on resubscribe
+    std::atomic_int m_orderbook_generation = 0;
+    std::atomic_int m_trades_generation = 0;
+
     // Readiness
     bool m_is_order_book_stream_ready = false;
     bool m_is_trade_stream_ready = false;
 
-    // OrderBook
+    // OrderBook: view of the first depth levels of the storage
     MarketOrderBook m_order_book;
+    FixedDepthOrderBook<MAX_DEPTH> m_order_book_levels;
+    // Copy of the snapshot with the subscribed depth (chosen at startup)
+    void (MarketConnector::*m_update_order_book)(const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty) = nullptr;
+    // Same book indexed by px (market.ladder_size ticks)
+    PriceLadder m_ladder;
     // Trades
     Trades m_trades;
+    // Bars of the trades: one series per resolution
+    std::vector<BarSeries> m_bars;
+
+    // Latency
+    LatencyTracker m_orderbook_latency;
+    LatencyTracker m_trades_latency;
+    LatencyTracker m_ping_latency;
+    const TimeType m_stale_latency;  // in ns
+    TimeType m_feed_latency = 0;
+    TimeType m_last_receive_time = 0;  // of the last book, trade or ping
+    bool m_is_feed_stale = false;      // by the latency of the last sample
+    size_t m_n_latency_samples = 0;
+
+    // Notifications
+    NotificationStats m_notification_stats;
 
    public:
     MarketConnector(Runner& runner, const ConfigType& config);
@@ -129,20 +184,80 @@ class MarketConnector {
     // Getters
     const MarketOrderBook& GetOrderBook() const;
 
+    const PriceLadder& GetLadder() const;
+
     const Trades& GetTrades() const;
 
+    const std::vector<BarSeries>& GetBars() const;
+
+    const LatencyTracker& GetOrderBookLatency() const;
+
+    const LatencyTracker& GetTradesLatency() const;
+
+    const LatencyTracker& GetPingLatency() const;
+
+    // Offset of the local clock from the exchange clock (including minimal network delay)
+    TimeType GetClockOffset() const;
+
+    // Latency of the last book/trade after the clock offset correction
+    TimeType GetFeedLatency() const;
+
+    // Time since the last book, trade or ping (0 before the first one and in backtests)
+    TimeType GetFeedSilence() const;
+
+    // Feed latency or silence exceeds market.stale_latency_ms
+    bool IsFeedStale() const;
+
+    const NotificationStats& GetNotificationStats() const;
+
    private:
     // Methods for Runner
     friend class Runner;
 
+    // Injects synthetic messages into the stream callbacks
+    friend class LoadGenerator;
+
+    // Feeds recorded messages into the stream callbacks
+    friend class WirePlayer;
+
     void Start();
 
+    void StartBacktest();
+
+    void Reconnect(StreamType type);
+
+    // Process parsed market data (from the streams or from the recorded data)
+    void ProcessOrderBook(TimeType receive_time, TimeType exchange_time, const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty);
+
+    void ProcessTrade(TimeType receive_time, TimeType exchange_time, Direction direction, int px, int qty);
+
     // Methods for MarketConnector
-    void OrderBookStreamCallBack(MarketDataResponse* response);
+    void SubscribeOrderBook();
+
+    void SubscribeTrades();
+
+    // receive_time is taken on arrival (or recorded by WireRecorder for the replay)
+    void OrderBookStreamCallBack(MarketDataResponse* response, TimeType receive_time);
 
-    void TradeStreamCallBack(MarketDataResponse* response);
+    void TradeStreamCallBack(MarketDataResponse* response, TimeType receive_time);
 
     [[nodiscard]] bool IsReady() const;
 
+    void ProcessPing(const Ping& ping, TimeType receive_time);
+
+    // Close the bars that end before the exchange time and notify the strategy
+    void CloseBars(TimeType time);
+
+    void OnLatencySample(LatencyTracker& tracker, TimeType exchange_time, TimeType receive_time);
+
+    void LogLatency(const char* reason) const;
+
     void ParseLevels(const google::protobuf::RepeatedPtrField<Order>& orders, int* px, int* qty) const;
+
+    // Dispatch to UpdateOrderBook<depth>
+    template <int... Depths>
+    void InitOrderBook(std::integer_sequence<int, Depths...>);
+
+    template <int Depth>
+    void UpdateOrderBook(const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty);
 };
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <cstdint>
+
+#include "config.h"
+#include "connector/market.h"
+#include "connector/utils.h"
+
+// Snapshot of the accounting. Money in px steps per lot (the units of Positions::money)
+struct PnL {
+    int position = 0;        // in lots: > 0 if Long; < 0 if Short
+    double avg_px = 0;       // average entry px of the position (0 if flat)
+    double mid_px = 0;       // mark px: mid of the order book
+    double realized = 0;     // closed part of the position at average cost
+    double unrealized = 0;   // open part of the position marked to mid
+    double fees = 0;         // commissions of all fills
+    double total = 0;        // realized + unrealized - fees
+    double exposure = 0;     // position * mid
+    int64_t turnover = 0;    // sum of px * qty of all fills
+    int64_t volume = 0;      // sum of qty of all fills
+    int64_t n_fills = 0;
+};
+
+// Average cost accounting of our fills, O(1) per fill and per mark.
+// Position opened outside of the tracked fills (initial positions, resync) is valued at the next mid.
+// Config (section pnl, optional):
+//   fee_rate: 0.0004         -- commission as a fraction of the fill notional
+//   sample_period_ms: 1000   -- period of pnl.txt samples (exchange time of the order books)
+class PnLTracker {
+   private:
+    const MarketOrderBook& m_order_book;
+    std::shared_ptr<spdlog::logger> m_logger;
+    const double m_fee_rate;
+    const TimeType m_sample_period;  // in ns
+    TimeType m_next_sample_time = 0;
+
+    int m_position = 0;
+    double m_cost = 0;          // signed cost of the position: position * avg_px
+    int m_unvalued_qty = 0;     // part of the position without cost (valued at the next mid)
+    double m_realized = 0;
+    double m_fees = 0;
+    int64_t m_turnover = 0;
+    int64_t m_volume = 0;
+    int64_t m_n_fills = 0;
+
+   public:
+    PnLTracker(const MarketOrderBook& order_book, std::shared_ptr<spdlog::logger> logger, const ConfigType& config);
+
+    // Marked to the current order book
+    [[nodiscard]] PnL GetPnL() const;
+
+    void OnFill(Direction direction, int px, int qty);
+
+    // Align the position with the broker position (start and resync)
+    void Reconcile(int qty);
+
+    // Value the unvalued position and log a sample once per sample_period_ms
+    void OnOrderBook(TimeType time);
+
+   private:
+    [[nodiscard]] bool HasMid() const;
+
+    [[nodiscard]] double GetMid() const;
+
+    void Log(TimeType time) const;
+};
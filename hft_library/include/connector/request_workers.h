@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed threads for blocking requests that are sent together (e.g. the cancels of a round): no thread is started per request.
+// Run(n, job) calls job(i) for each i < n on the workers and the calling thread and returns when all calls are done.
+// One batch at a time: a batch of another thread waits for the running one. The job must not throw
+class RequestWorkers {
+    // Batch: indices [m_next, m_n) are not taken yet
+    std::mutex m_mutex;
+    std::condition_variable_any m_cv;
+    std::condition_variable m_done_cv;
+    void (*m_call)(const void* job, size_t index) = nullptr;
+    const void* m_job = nullptr;
+    size_t m_n = 0;
+    size_t m_next = 0;
+    size_t m_n_done = 0;
+    bool m_is_running = false;  // a batch is owned by a calling thread
+
+    std::vector<std::jthread> m_threads;
+
+   public:
+    explicit RequestWorkers(int n_threads);
+
+    RequestWorkers(const RequestWorkers&) = delete;
+
+    RequestWorkers& operator=(const RequestWorkers&) = delete;
+
+    ~RequestWorkers();
+
+    template <typename Job>
+    void Run(size_t n, const Job& job) {
+        RunBatch(n, [](const void* job, size_t index) { (*static_cast<const Job*>(job))(index); }, &job);
+    }
+
+   private:
+    void RunBatch(size_t n, void (*call)(const void* job, size_t index), const void* job);
+
+    // Take the next index of the batch and call the job with the mutex released. Returns false if all indices are taken
+    bool CallNext(std::unique_lock<std::mutex>& lock);
+
+    void Loop(std::stop_token stop_token);
+};
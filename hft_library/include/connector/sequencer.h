@@ -0,0 +1,88 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "constants.h"
+#include "supervisor.h"
+
+enum class StreamAnomaly {
+    OrderBookOutOfOrder,  // book is older than the last book: dropped
+    OrderBookStale,       // book is older than the last trade or fill by more than stale_book_ms: dropped
+    TradeOutOfOrder,      // trade is older than the last trade: processed
+    FillDuplicate,        // trade of our order with a known trade_id (redelivery after resubscribe): suppressed
+    BookBehindFill,       // fill is newer than the order book: the book does not reflect it yet
+    Count
+};
+
+const char* StreamAnomalyName(StreamAnomaly anomaly);
+
+// Last accepted event of a stream
+struct StreamStamp {
+    uint64_t sequence = 0;         // per stream
+    uint64_t merged_sequence = 0;  // over all streams in the order of processing
+    TimeType exchange_time = 0;
+    TimeType receive_time = 0;
+};
+
+// Sequence numbers and exchange times of the events of the book, trade and order streams.
+// The streams run on separate threads: events are stamped under the event lock, so the merged sequence is the order
+// in which the strategy sees them.
+// Config (section market.sequencing, optional):
+//   stale_book_ms: 0  -- drop books older than the last trade or fill by more (0: keep them)
+class StreamSequencer {
+   private:
+    constexpr static size_t FILL_IDS_CAPACITY = 256;  // recent trade ids of our orders
+
+    std::shared_ptr<spdlog::logger> m_logger;
+
+    // Parameters
+    const TimeType m_stale_book;  // in ns
+
+    std::array<StreamStamp, 3> m_last{};  // by StreamType
+    uint64_t m_merged_sequence = 0;
+
+    // Recent trade ids (ring): the strings keep their capacity when they are overwritten
+    std::array<std::string, FILL_IDS_CAPACITY> m_fill_ids;
+    size_t m_n_fill_ids = 0;
+
+    // Counters
+    std::array<size_t, static_cast<size_t>(StreamAnomaly::Count)> m_n_anomalies{};
+
+   public:
+    StreamSequencer(const ConfigType& config, std::shared_ptr<spdlog::logger> logger);
+
+    // Returns false if the book is dropped
+    bool OnOrderBook(TimeType exchange_time, TimeType receive_time);
+
+    void OnTrade(TimeType exchange_time, TimeType receive_time);
+
+    // Returns false if the trade of our order is a duplicate. Empty trade_id is not checked
+    bool OnFill(std::string_view trade_id, TimeType exchange_time, TimeType receive_time);
+
+    // Remember the trade of our order without stamping the stream (order states of a resync). Returns false if it is known
+    bool MarkFill(std::string_view trade_id);
+
+    [[nodiscard]] const StreamStamp& GetLast(StreamType type) const { return m_last[static_cast<size_t>(type)]; }
+
+    // Accepted events of all streams
+    [[nodiscard]] uint64_t GetMergedSequence() const { return m_merged_sequence; }
+
+    // The last fill is newer than the order book
+    [[nodiscard]] bool IsBookBehindFills() const {
+        return GetLast(StreamType::Orders).exchange_time > GetLast(StreamType::OrderBook).exchange_time;
+    }
+
+    [[nodiscard]] size_t GetAnomalies(StreamAnomaly anomaly) const { return m_n_anomalies[static_cast<size_t>(anomaly)]; }
+
+    void LogCounters() const;
+
+   private:
+    void Stamp(StreamType type, TimeType exchange_time, TimeType receive_time);
+
+    void Count(StreamAnomaly anomaly, TimeType exchange_time, TimeType last_time);
+};
@@ -3,9 +3,20 @@
 #include <spdlog/fmt/ostr.h>
 #include <spdlog/spdlog.h>
 
+#include <array>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "connector/latency.h"
+#include "connector/pnl.h"
+#include "connector/request_workers.h"
 #include "connector/utils.h"
 #include "constants.h"
+#include "pool_allocator.h"
 #include "hft_library/third_party/TinkoffInvestSDK/investapiclient.h"
+#include "hft_library/third_party/TinkoffInvestSDK/services/operationsservice.h"
 #include "hft_library/third_party/TinkoffInvestSDK/services/ordersservice.h"
 #include "hft_library/third_party/TinkoffInvestSDK/services/ordersstreamservice.h"
 
@@ -15,19 +26,56 @@ class LockGuard;
 
 class Strategy;
 
+// PendingNew -> Live -> PartiallyFilled -> Done
+//                 \-> PendingCancel -> Done
+enum class OrderStatus {
+    PendingNew,       // accepted by the broker, waiting for the exchange acknowledgement
+    Live,             // resting on the exchange
+    PartiallyFilled,  // resting on the exchange with executed qty
+    PendingCancel,    // cancel request is sent
+    Done              // filled, cancelled or rejected
+};
+
+std::ostream& operator<<(std::ostream& os, OrderStatus status);
+
+// Order is rejected by the broker or the exchange (EXECUTION_REPORT_STATUS_REJECTED of PostOrder): nothing rests
+class OrderRejectedByExchange : public std::runtime_error {
+   public:
+    using std::runtime_error::runtime_error;
+};
+
 class LimitOrder {
    public:
     const std::string order_id;
     const Direction direction;
     const int px;  // real_px / px_step
     int qty;       // in lots
+    OrderStatus status = OrderStatus::Live;
+
+    // Booked executed qty. The trades of the streams are unique by trade id; their qty beyond executed_qty is booked
+    // (the PostOrder reply books the lots executed on post before any trade is reported)
+    int executed_qty = 0;
+    int reported_qty = 0;  // qty of the trades reported by TradesStream and OrderStateStream
+
+    // Index of the strategy that posted the order (0 for the orders of the broker resync)
+    int strategy_id = 0;
 };
 
+// Nodes are recycled: no allocations for new orders in steady state
+using OrdersMap = PoolMap<std::string, LimitOrder>;
+
 class Positions {
    public:
-    std::map<std::string, LimitOrder> orders;  // orders by id
+    OrdersMap orders;                          // orders by id
     int qty = 0;                               // > 0 if Long; < 0 if Short
     int money = 0;                             // real_money / (lot * px_step)
+
+    // Aggregates of the resting orders: updated with the orders
+    int open_buy_qty = 0;
+    int64_t open_buy_notional = 0;  // sum of px * qty
+    int open_sell_qty = 0;
+    PoolMap<int, int> open_buy_qty_by_px;   // best resting bid is the last
+    PoolMap<int, int> open_sell_qty_by_px;  // best resting ask is the first
 };
 
 std::ostream& operator<<(std::ostream& os, const LimitOrder& order);
@@ -38,11 +86,10 @@ class UserConnector {
    private:
     // Runner
     Runner& m_runner;
-    // Client
-    InvestApiClient& m_client;
     // Logger
     std::shared_ptr<spdlog::logger> m_logger;
     size_t internal_log_id = 0;
+    size_t m_n_log_events = 0;
     std::shared_ptr<spdlog::logger> m_our_trades_logger;
     std::shared_ptr<spdlog::logger> m_positions_logger;
     std::shared_ptr<spdlog::logger> m_orders_logger;
@@ -54,41 +101,165 @@ class UserConnector {
 
     // OrdersStream: initialized in Start()
     std::shared_ptr<OrdersStream> m_orders_stream;
+    // Subscribe OrderStateStream next to TradesStream (user.order_state_stream): new orders wait for the exchange acknowledgement
+    const bool m_is_order_state_stream_enabled;
+    std::atomic_int m_orders_stream_generation = 0;  // incremented on resubscribe
+
+    // Operations service: initialized in Start()
+    std::shared_ptr<Operations> m_operations_service;
 
     // Orders service: initialized in Start()
     std::shared_ptr<Orders> m_orders_service;
+    // Threads of the cancels that are sent at once (user.cancel_threads, Live mode): the event thread sends one of them too
+    std::unique_ptr<RequestWorkers> m_cancel_workers;
 
     // Readiness
     bool m_is_order_stream_ready = false;
 
-    // Positions
+    // Positions of the account
     Positions m_positions;
+    // Positions of each strategy if the runner hosts several of them: the resting orders live in the owner positions.
+    // With one strategy its positions are the account positions
+    std::vector<Positions> m_strategy_positions;
+
+    // Recently done orders (for late execution reports)
+    OrdersMap m_done_orders;
+    std::array<std::string, DONE_ORDERS_CAPACITY> m_done_order_ids;  // ring in the order of completion
+    size_t m_n_done_orders = 0;
+
+    // Latency of OrdersStream (our trades and pings)
+    LatencyTracker m_orders_stream_latency;
+
+    // Accounting of our fills
+    PnLTracker m_pnl;
 
    public:
-    UserConnector(Runner& runner, const ConfigType& config);
+    UserConnector(Runner& runner, const ConfigType& config, int n_strategies);
 
     // Getters
+    // Positions of the account
     const Positions& GetPositions() const;
 
+    // Positions of the strategy
+    const Positions& GetPositions(int strategy_id) const;
+
+    [[nodiscard]] int GetStrategyCount() const;
+
+    // Resting orders of all strategies
+    [[nodiscard]] size_t GetOrderCount() const;
+
+    const LatencyTracker& GetOrdersStreamLatency() const;
+
+    const PnLTracker& GetPnL() const;
+
    private:
     // Methods for Runner
     friend class Runner;
 
     void Start();
 
-    const LimitOrder& PostOrder(int px, int qty, Direction direction);
+    // Positions from the config instead of GetPositions
+    void StartBacktest(int money, int qty);
+
+    void Reconnect();
+
+    const LimitOrder& PostOrder(int px, int qty, Direction direction, int strategy_id);
 
     void CancelOrder(const std::string& order_id);
 
+    // Cancel requests are sent at once (Live mode): the event lock is released until their replies arrive (Runner::RunWithoutEventLock).
+    // errors[i] is set if order_ids[i] is not cancelled
+    void CancelOrders(const std::vector<std::string>& order_ids, std::vector<std::exception_ptr>& errors);
+
+    // Cancel the resting orders of all strategies from a thread without the event lock (instrument refresh): the lock is
+    // taken to mark and to update the orders but not while the requests are in flight. errors[i] is set if order_ids[i] is not cancelled
+    void CancelAllOrders(std::vector<std::string>& order_ids, std::vector<std::exception_ptr>& errors);
+
+    // Mark the position to the new order book
+    void MarkToMarket(TimeType exchange_time);
+
     // Methods for UserConnector
-    void OrderStreamCallback(TradesStreamResponse* response);
+    void SubscribeOrderStream();
+
+    // Query orders and positions (OrderStream is unsubscribed). Replace the local state.
+    // Fills of the outage are known from the order states: they reach their owners and strategies (on readiness)
+    void Resync();
+
+    // Fills between the snapshot of Resync and the new subscription that the stream has not delivered (by trade id)
+    void ReconcileFills();
+
+    // Final states of the local resting orders that are not active any more (filled or cancelled during the outage)
+    std::vector<OrderState> FetchDoneOrderStates(const GetOrdersResponse& orders);
+
+    // Executions of the order state with unknown trade ids, up to its executed qty. Calls process(order, px, qty) for each
+    template <typename Process>
+    void ProcessMissedFills(const OrderState& order_state, Process process);
+
+    void ParsePositions(const PositionsResponse& positions);
+
+    // Split the account positions between the strategies (strategy config: money, qty; equal parts by default)
+    void AllocatePositions();
+
+    // Attribute the change of the account positions (resync after an outage) to the first strategy
+    void ReconcileStrategyPositions(int qty_old, int money_old);
+
+    void ParseOrders(const GetOrdersResponse& orders);
+
+    // receive_time is taken on arrival (or recorded by WireRecorder for the replay)
+    void OrderStreamCallback(TradesStreamResponse* response, TimeType receive_time);
+
+    void OrderStateStreamCallback(OrderStateStreamResponse* response, TimeType receive_time);
+
+    // Trades of the order reported by either stream: the first report of a trade id is booked at the trade px
+    void ProcessOrderTrades(const LockGuard& lock, const std::string& order_id, Direction direction, const google::protobuf::RepeatedPtrField<OrderTrade>& trades, TimeType receive_time);
+
+    // Reported qty of new trades: the part beyond the executed qty of the order is booked
+    void ProcessExecution(const LockGuard& lock, const std::string& order_id, int px, int reported_qty, Direction direction);
 
     void ProcessOurTrade(const LockGuard& lock, const std::string& order_id, int px, int qty, Direction direction);
 
-    const LimitOrder& ProcessNewPostOrder(const std::string& order_id, int px, int qty, Direction direction);
+    // Update the order, positions and PnL without the notification. Returns a copy of the order
+    LimitOrder BookOurTrade(const std::string& order_id, int px, int qty, Direction direction);
+
+    const LimitOrder& ProcessNewPostOrder(const std::string& order_id, int px, int qty, Direction direction, OrderStatus status, int strategy_id);
+
+    // Positions that own the orders of the strategy
+    Positions& GetOwnerPositions(int strategy_id);
+
+    // Resting order and its owner positions (owner is nullptr if the order is not resting). Looks up the map of each strategy
+    OrdersMap::iterator FindRestingOrder(const std::string& order_id, Positions*& owner);
+
+    // Steps of the cancels that are sent at once: statuses of the orders before PendingCancel
+    std::vector<OrderStatus> MarkPendingCancel(const std::vector<std::string>& order_ids);
+
+    // Without the event lock: errors[i] is set if the request has thrown
+    void SendCancels(const std::vector<std::string>& order_ids, std::vector<std::optional<ServiceReply>>& replies, std::vector<std::exception_ptr>& errors);
+
+    void ProcessCancelReplies(const std::vector<std::string>& order_ids, const std::vector<OrderStatus>& statuses, std::vector<std::optional<ServiceReply>>& replies, std::vector<std::exception_ptr>& errors);
+
+    // Find resting or recently done order
+    LimitOrder* FindOrder(const std::string& order_id);
+
+    // Changes of resting orders (logged to the orders journal)
+    void ReduceOrder(LimitOrder& order, int qty);
+
+    // Move resting order to done orders
+    void RemoveOrder(Positions& owner, OrdersMap::iterator it);
+
+    // Add signed qty of the resting order to the aggregates of the account and owner positions
+    void UpdateOpenOrders(const LimitOrder& order, int qty);
+
+    // Add signed qty of our trade to the account and owner positions
+    void UpdatePositions(int strategy_id, int signed_qty, int px);
 
     bool IsReady() const;
 
     // Methods for logging
-    void LogOrders();
+    // orders.txt is a journal: add/reduce/remove rows per change and periodic snapshots of all orders
+    void LogOrderEvent(const char* event, const LimitOrder& order);
+
+    void LogOrdersSnapshot();
+
+    // Close the event: rows with the same internal_log_id belong to one event
+    void FinishLogEvent();
 };
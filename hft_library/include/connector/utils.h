@@ -4,6 +4,7 @@
 
 #include <iostream>
 
+#include "clock.h"
 #include "hft_library/third_party/TinkoffInvestSDK/investapiclient.h"
 
 class Instrument {
@@ -71,8 +72,9 @@ Type* ParseReply(ServiceReply& reply, std::shared_ptr<spdlog::logger> logger) {
     return response.get();
 }
 
-using TimeType = int64_t;
-
 TimeType time_from_protobuf(const google::protobuf::Timestamp& timestamp);
 
-TimeType current_time();
+// Nanoseconds since epoch from TscClock
+inline TimeType current_time() {
+    return TscClock::Now();
+}
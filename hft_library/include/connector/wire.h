@@ -0,0 +1,130 @@
+#pragma once
+
+#include <google/protobuf/message_lite.h>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clock.h"
+
+struct gzFile_s;
+
+// Stream of the recorded message
+enum class WireStream : int32_t {
+    OrderBook = 0,   // MarketDataResponse
+    Trades = 1,      // MarketDataResponse
+    Orders = 2,      // TradesStreamResponse
+    OrderState = 3,  // OrderStateStreamResponse
+};
+
+constexpr size_t N_WIRE_STREAMS = 4;
+
+const char* WireStreamName(WireStream stream);
+
+// Capture of the raw stream messages (runner.wire_record: true => <log_directory>/wire.gz)
+// gzip file: MAGIC, then records of RecordHeader followed by the serialized message.
+// Records are in the order of the event lock across all streams: the order in which the Runner processed them.
+namespace wire {
+
+constexpr char MAGIC[8] = "HFTWR01";
+
+struct RecordHeader {
+    TimeType receive_time;
+    WireStream stream;
+    uint32_t size;  // bytes of the serialized message
+};
+
+}  // namespace wire
+
+// The stream callback stages its message; the first event lock of the callback records it (LockGuard), so the records
+// follow the processing order. Recording copies the message into a recycled one: serialization, compression and disk
+// writes run in a background thread
+class WireRecorder {
+   private:
+    constexpr static size_t MAX_PENDING_MESSAGES = 1 << 16;  // drop messages if the writer falls behind
+    constexpr static std::chrono::seconds FLUSH_PERIOD{1};
+
+    struct PendingRecord {
+        wire::RecordHeader header;
+        std::unique_ptr<google::protobuf::MessageLite> message;
+    };
+
+    // Message of the current stream callback that is not recorded yet. Zero-initialized as a thread-local object
+    struct StagedMessage {
+        const WireRecorder* recorder;
+        WireStream stream;
+        TimeType receive_time;
+        const google::protobuf::MessageLite* message;
+    };
+
+    inline static thread_local StagedMessage t_staged;
+
+    std::shared_ptr<spdlog::logger> m_logger;
+    gzFile_s* m_file;
+
+    // Records are swapped with the writer; written messages return to the free lists of their streams
+    std::mutex m_mutex;
+    std::condition_variable_any m_cv;
+    std::vector<PendingRecord> m_pending;
+    std::array<std::vector<std::unique_ptr<google::protobuf::MessageLite>>, N_WIRE_STREAMS> m_free_messages;
+    size_t m_n_dropped = 0;
+
+    std::jthread m_thread;
+
+   public:
+    WireRecorder(const std::string& path, std::shared_ptr<spdlog::logger> logger);
+
+    WireRecorder(const WireRecorder&) = delete;
+
+    WireRecorder& operator=(const WireRecorder&) = delete;
+
+    // Write the remaining messages and close the file
+    ~WireRecorder();
+
+    // Stage the message of the stream callback on its thread. The message outlives the callback
+    void Stage(WireStream stream, TimeType receive_time, const google::protobuf::MessageLite& message);
+
+    // Record the staged message of this thread. Called under the event lock
+    void RecordStaged();
+
+    // The callback did not take the event lock (subscription responses)
+    [[nodiscard]] bool HasStaged() const;
+
+   private:
+    void Record(WireStream stream, TimeType receive_time, const google::protobuf::MessageLite& message);
+
+    void WriteLoop(std::stop_token stop_token);
+
+    // Serialize the records into buffer
+    static void Serialize(std::vector<PendingRecord>& records, std::string& buffer);
+
+    void Write(const std::string& buffer);
+};
+
+// Sequential reader of the recorded file
+class WireReader {
+   private:
+    gzFile_s* m_file;
+
+   public:
+    explicit WireReader(const std::string& path);
+
+    WireReader(const WireReader&) = delete;
+
+    WireReader& operator=(const WireReader&) = delete;
+
+    ~WireReader();
+
+    // Read the next record into the reused payload. Return false at the end of the file
+    bool Next(wire::RecordHeader& header, std::string& payload);
+};
@@ -10,3 +10,9 @@ constexpr const char* ENDPOINT = "invest-public-api.tinkoff.ru:443";
 constexpr const char* CONFIG_DIRECTORY = "private/config.yaml";
 constexpr int MAX_DEPTH = 50;
 constexpr static int NUMBER_OF_SPACES_PER_NUMBER = 10;
+constexpr int DEFAULT_STALE_LATENCY_MS = 1000;
+constexpr size_t DONE_ORDERS_CAPACITY = 1000;
+constexpr size_t ORDERS_SNAPSHOT_PERIOD = 1000;  // snapshot of all orders every n log events
+constexpr size_t LATENCY_LOG_PERIOD = 1000;  // log latency percentiles every n samples
+constexpr size_t DEFAULT_BAR_HISTORY = 1024;  // closed bars of each resolution
+constexpr int DEFAULT_LADDER_SIZE = 4096;  // ticks covered by PriceLadder (power of 2)
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "connector/user.h"
+#include "connector/utils.h"
+
+class Runner;
+
+// Frames of order workflows are recycled through thread-local free lists of 64-byte size classes:
+// a workflow per event does not allocate in steady state. Large frames go to the system
+class FramePool {
+    constexpr static size_t CLASS_SIZE = 64;
+    constexpr static size_t N_CLASSES = 64;  // frames up to 4 KiB
+    constexpr static size_t MAX_FREE_FRAMES = 64;  // per size class
+
+    struct FreeFrame {
+        FreeFrame* next;
+    };
+
+    // Zero-initialized and trivially destructible: no destructor is registered for the thread-local object.
+    // Frames left in the lists of an exiting thread are leaked (at most MAX_FREE_FRAMES per size class)
+    struct FreeLists {
+        std::array<FreeFrame*, N_CLASSES> heads;
+        std::array<size_t, N_CLASSES> sizes;
+    };
+
+    static_assert(std::is_trivially_destructible_v<FreeLists>);
+
+    inline static thread_local FreeLists t_free_lists{};
+
+   public:
+    static void* Allocate(size_t size) {
+        const size_t size_class = (size + CLASS_SIZE - 1) / CLASS_SIZE;
+        if (size_class < N_CLASSES && t_free_lists.heads[size_class]) {
+            FreeFrame* frame = t_free_lists.heads[size_class];
+            t_free_lists.heads[size_class] = frame->next;
+            --t_free_lists.sizes[size_class];
+            return frame;
+        }
+        return ::operator new(size_class < N_CLASSES ? size_class * CLASS_SIZE : size);
+    }
+
+    static void Deallocate(void* ptr, size_t size) {
+        const size_t size_class = (size + CLASS_SIZE - 1) / CLASS_SIZE;
+        if (size_class < N_CLASSES && t_free_lists.sizes[size_class] < MAX_FREE_FRAMES) {
+            FreeFrame* frame = static_cast<FreeFrame*>(ptr);
+            frame->next = t_free_lists.heads[size_class];
+            t_free_lists.heads[size_class] = frame;
+            ++t_free_lists.sizes[size_class];
+            return;
+        }
+        ::operator delete(ptr);
+    }
+};
+
+// Order workflow of a strategy: a coroutine that co_awaits Runner::Post and Runner::Cancel.
+// Runner::Spawn starts it; the Runner executes the awaited request after the notification and resumes the workflow with the result.
+// Requests of the suspended workflows are executed together: cancels are sent at once, posts one by one.
+// In Live mode the event lock is released while the cancels are in flight: other events are processed meanwhile and their
+// notifications are deferred; if any arrives the workflows are destroyed before their posts and the strategies are notified.
+// A workflow is destroyed at its suspension point if more events are pending (the market moved): locals are destroyed as usual.
+// Workflows do not outlive the notification that spawned them
+class OrderTask {
+   public:
+    struct promise_type {
+        OrderTask get_return_object() {
+            return OrderTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        // Started by Runner::Spawn
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        // Destroyed by the owner
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        void return_void() {}
+
+        // An exception that the workflow does not handle finishes it: Runner::Spawn or Runner::RunOrderTasks rethrows it
+        // on the event thread as those of synchronous orders
+        void unhandled_exception() { error = std::current_exception(); }
+
+        std::exception_ptr error;
+
+        static void* operator new(size_t size) { return FramePool::Allocate(size); }
+
+        static void operator delete(void* ptr, size_t size) { FramePool::Deallocate(ptr, size); }
+    };
+
+   private:
+    std::coroutine_handle<promise_type> m_handle;
+
+   public:
+    OrderTask(OrderTask&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    OrderTask& operator=(OrderTask&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~OrderTask() {
+        if (m_handle) m_handle.destroy();
+    }
+
+    [[nodiscard]] bool IsDone() const { return m_handle.done(); }
+
+    void Resume() { m_handle.resume(); }
+
+    // Exception that has finished the workflow (nullptr if none)
+    [[nodiscard]] std::exception_ptr GetError() const { return m_handle.promise().error; }
+
+   private:
+    explicit OrderTask(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+};
+
+// Request of a suspended workflow: filled by the Runner before the resumption
+struct OrderRequest {
+    enum class Type {
+        Post,
+        Cancel,
+        CancelBatch
+    };
+
+    Type type;
+    // Post
+    int px = 0;
+    int qty = 0;
+    Direction direction = Direction::Buy;
+    const LimitOrder* order = nullptr;  // posted order
+    // Cancel
+    std::string order_id;
+    // CancelBatch: buffers of the workflow
+    const std::vector<std::string>* order_ids = nullptr;
+    std::vector<std::exception_ptr>* errors = nullptr;
+    // ServiceReply, OrderRejected or OrderRejectedByExchange: rethrown in the workflow
+    std::exception_ptr error;
+};
+
+// co_await Runner::Post(px, qty, direction): the posted order; throws as Runner::PostOrder
+class PostAwaitable {
+    Runner& m_runner;
+    OrderRequest m_request;
+
+   public:
+    PostAwaitable(Runner& runner, int px, int qty, Direction direction)
+        : m_runner(runner), m_request{.type = OrderRequest::Type::Post, .px = px, .qty = qty, .direction = direction} {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    const LimitOrder& await_resume() const {
+        if (m_request.error) std::rethrow_exception(m_request.error);
+        return *m_request.order;
+    }
+};
+
+// co_await Runner::Cancel(order_id): throws as Runner::CancelOrder
+class CancelAwaitable {
+    Runner& m_runner;
+    OrderRequest m_request;
+
+   public:
+    CancelAwaitable(Runner& runner, std::string order_id)
+        : m_runner(runner), m_request{.type = OrderRequest::Type::Cancel, .order_id = std::move(order_id)} {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    void await_resume() const {
+        if (m_request.error) std::rethrow_exception(m_request.error);
+    }
+};
+
+// co_await Runner::Cancel(order_ids, errors): the cancels are sent at once with those of the other workflows.
+// Does not throw: errors is resized to order_ids, errors[i] is set (ServiceReply) if order_ids[i] is not cancelled
+class CancelBatchAwaitable {
+    Runner& m_runner;
+    OrderRequest m_request;
+
+   public:
+    CancelBatchAwaitable(Runner& runner, const std::vector<std::string>& order_ids, std::vector<std::exception_ptr>& errors)
+        : m_runner(runner), m_request{.type = OrderRequest::Type::CancelBatch, .order_ids = &order_ids, .errors = &errors} {
+        errors.assign(order_ids.size(), nullptr);
+    }
+
+    bool await_ready() const noexcept { return m_request.order_ids->empty(); }
+
+    void await_suspend(std::coroutine_handle<> handle);
+
+    void await_resume() const {}
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "allocations.h"
+#include "config.h"
+#include "runner.h"
+#include "strategy.h"
+
+// Strategies built as shared libraries (MODULE targets in hft_library/plugins).
+// The plugin does not link hft_library: its symbols are resolved from the host executable (built with exported symbols).
+// The plugin and the host must be built from the same headers and compiler: the ABI record of the plugin is read from its
+// ELF section before dlopen, so a mismatching plugin never runs its static initializers.
+constexpr uint32_t HFT_PLUGIN_ABI_VERSION = 17;  // increment on changes of Strategy or Runner
+
+constexpr char PLUGIN_ABI_SECTION[] = ".hft_plugin_abi";
+
+struct PluginAbi {
+    uint32_t version;
+    uint32_t runner_size;
+    uint32_t strategy_size;
+    uint32_t padding;
+    uint64_t layout_hash;  // sizes and alignments of the shared classes, compiler version and build flags
+
+    bool operator==(const PluginAbi&) const = default;
+};
+
+namespace plugin_abi {
+
+constexpr uint64_t Mix(uint64_t hash, uint64_t value) {
+    // FNV-1a over the bytes of value
+    for (int i = 0; i < 8; ++i) {
+        hash = (hash ^ ((value >> (8 * i)) & 0xff)) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+constexpr uint64_t LayoutHash() {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char* c = __VERSION__; *c; ++c) {
+        hash = Mix(hash, static_cast<unsigned char>(*c));
+    }
+    const uint64_t values[] = {
+        __cplusplus, _GLIBCXX_USE_CXX11_ABI, TRACK_ALLOCATIONS,
+        sizeof(Runner), alignof(Runner), sizeof(Strategy), alignof(Strategy),
+        sizeof(MarketConnector), sizeof(UserConnector), sizeof(MarketOrderBook), sizeof(PriceLadder),
+        sizeof(Positions), sizeof(LimitOrder), sizeof(PnLTracker), sizeof(Instrument),
+        sizeof(ConfigType), sizeof(std::string), sizeof(std::shared_ptr<spdlog::logger>)};
+    for (uint64_t value : values) {
+        hash = Mix(hash, value);
+    }
+    return hash;
+}
+
+}  // namespace plugin_abi
+
+constexpr PluginAbi MakePluginAbi() {
+    return PluginAbi{
+        .version = HFT_PLUGIN_ABI_VERSION,
+        .runner_size = sizeof(Runner),
+        .strategy_size = sizeof(Strategy),
+        .padding = 0,
+        .layout_hash = plugin_abi::LayoutHash()};
+}
+
+// Entry points of the plugin (extern "C")
+using CreateStrategyFunction = Strategy* (*)(Runner* runner, const ConfigType* config);
+using DestroyStrategyFunction = void (*)(Strategy* strategy);
+
+// Define the ABI record and the entry points for StrategyType(Runner&, const ConfigType&) in one source file of the plugin
+#define HFT_STRATEGY_PLUGIN(StrategyType)                                                                       \
+    __attribute__((used, section(".hft_plugin_abi"))) constinit const PluginAbi hft_plugin_abi = MakePluginAbi(); \
+    extern "C" {                                                                                                \
+    __attribute__((visibility("default"))) Strategy* hft_create_strategy(Runner* runner, const ConfigType* config) { \
+        return new StrategyType(*runner, *config);                                                              \
+    }                                                                                                           \
+    __attribute__((visibility("default"))) void hft_destroy_strategy(Strategy* strategy) {                      \
+        delete strategy;                                                                                        \
+    }                                                                                                           \
+    }
+
+// Loaded version of the plugin. Strategies keep the library loaded until they are destroyed
+class StrategyPlugin : public std::enable_shared_from_this<StrategyPlugin> {
+   private:
+    void* m_handle = nullptr;
+    const std::string m_path;
+    CreateStrategyFunction m_create = nullptr;
+    DestroyStrategyFunction m_destroy = nullptr;
+
+   public:
+    // dlopen caches libraries by path: a private copy of the file is loaded, so a rebuilt plugin at the same path is a new version.
+    // Throws if the ABI record of the file differs from the host
+    static std::shared_ptr<StrategyPlugin> Load(const std::string& path);
+
+    // ABI record of the plugin file without loading it (nullopt if the file has none)
+    static std::optional<PluginAbi> ReadAbi(const std::string& path);
+
+    StrategyPlugin(const StrategyPlugin&) = delete;
+
+    StrategyPlugin& operator=(const StrategyPlugin&) = delete;
+
+    ~StrategyPlugin();
+
+    // Getter of the strategy for the Runner: the strategy is configured by Runner::GetStrategyConfig()
+    Runner::StrategyGetter GetStrategyGetter();
+
+    [[nodiscard]] const std::string& GetPath() const { return m_path; }
+
+   private:
+    StrategyPlugin(void* handle, std::string path);
+};
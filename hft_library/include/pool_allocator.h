@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <new>
+
+// Stateless allocator that recycles single-object allocations through a thread-local free list.
+// Node containers (std::map) reuse their nodes after warm-up instead of calling operator new.
+// Nodes may be freed on another thread: they go to the free list of that thread.
+template <typename T>
+class PoolAllocator {
+    static_assert(sizeof(T) >= sizeof(void*));
+    static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+    constexpr static size_t MAX_FREE_NODES = 1024;  // excess nodes are returned to the system
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    // Trivially destructible: no TLS guard on access and no destructor that runs before the last deallocation of the thread.
+    // Nodes of the free list are leaked when the thread exits (at most MAX_FREE_NODES per thread and type)
+    inline static thread_local FreeNode* t_free_head = nullptr;
+    inline static thread_local size_t t_free_size = 0;
+
+   public:
+    using value_type = T;
+
+    PoolAllocator() = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        if (n == 1 && t_free_head) {
+            FreeNode* node = t_free_head;
+            t_free_head = node->next;
+            --t_free_size;
+            return reinterpret_cast<T*>(node);
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        if (n == 1 && t_free_size < MAX_FREE_NODES) {
+            FreeNode* node = reinterpret_cast<FreeNode*>(ptr);
+            node->next = t_free_head;
+            t_free_head = node;
+            ++t_free_size;
+            return;
+        }
+        ::operator delete(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const { return true; }
+};
+
+template <typename Key, typename Value, typename Compare = std::less<>>
+using PoolMap = std::map<Key, Value, Compare, PoolAllocator<std::pair<const Key, Value>>>;
+
+// Fill the free list of the calling thread with n nodes of Map (n <= 1024): the first inserts on this thread neither allocate nor fault.
+// make_value(i) returns the value_type with a distinct key for each i
+template <typename Map, typename MakeValue>
+void PrefaultPool(size_t n, MakeValue make_value) {
+    Map map;
+    for (size_t i = 0; i < n; ++i) {
+        map.insert(make_value(i));
+    }
+}
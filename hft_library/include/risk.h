@@ -0,0 +1,96 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include "clock.h"
+#include "config.h"
+#include "connector/market.h"
+#include "connector/pnl.h"
+#include "connector/user.h"
+
+enum class RiskRule {
+    OrderQty,       // fat finger: qty of one order
+    OrderNotional,  // fat finger: px * qty of one order
+    Position,       // position if all resting orders of the side and the new order are filled
+    Money,          // buy notional of the resting orders and the new order exceeds money
+    Short,          // sell qty of the resting orders and the new order exceeds the position
+    OrderRate,      // orders per second
+    Collar,         // px crosses the opposite best px by more than the collar
+    Distance,       // px is too far from the best px of its side
+    Loss,           // total PnL is below -max_loss
+    SelfMatch,      // px crosses a resting order of the opposite side (of any strategy of the account)
+    Count
+};
+
+const char* RiskRuleName(RiskRule rule);
+
+// Order is rejected locally by RiskGate: no request is sent
+class OrderRejected : public std::runtime_error {
+   public:
+    const RiskRule rule;
+
+    OrderRejected(RiskRule rule, const std::string& message);
+};
+
+// Pre-trade checks of Runner::PostOrder in O(1): aggregates of the resting orders are kept in Positions.
+// Runs on the event thread under the event lock.
+// Config (section risk, optional; absent or 0 disables a rule):
+//   max_order_qty: 0          -- lots
+//   max_order_notional: 0     -- px * qty (px steps per lot)
+//   max_position: 0           -- |position| in lots if all resting orders of the side are filled
+//   check_money: false        -- buy notional of the resting orders <= money
+//   allow_short: true         -- false: sell qty of the resting orders <= position
+//   max_orders_per_second: 0  -- in exchange time of the order books in backtests
+//   collar_ticks: -1          -- buy px <= best ask + collar; sell px >= best bid - collar
+//   max_distance_ticks: 0     -- buy px >= best bid - distance; sell px <= best ask + distance
+//   max_loss: 0               -- total PnL >= -max_loss (px steps per lot)
+//   prevent_self_match: true  -- buy px < best resting sell px; sell px > best resting buy px
+class RiskGate {
+   private:
+    std::shared_ptr<spdlog::logger> m_logger;
+    const Positions& m_positions;
+    const MarketOrderBook& m_order_book;
+    const PnLTracker& m_pnl;
+
+    // Parameters
+    const int m_max_order_qty;
+    const int64_t m_max_order_notional;
+    const int m_max_position;
+    const bool m_check_money;
+    const bool m_allow_short;
+    const int m_collar_ticks;
+    const int m_max_distance_ticks;
+    const double m_max_loss;
+    const bool m_prevent_self_match;
+
+    // Times of the last max_orders_per_second orders
+    std::vector<TimeType> m_order_times;
+    size_t m_n_orders = 0;
+
+    // Counters
+    size_t m_n_checks = 0;
+    std::array<size_t, static_cast<size_t>(RiskRule::Count)> m_n_rejects{};
+
+   public:
+    RiskGate(const ConfigType& config, const Positions& positions, const MarketOrderBook& order_book, const PnLTracker& pnl, std::shared_ptr<spdlog::logger> logger);
+
+    // Throw OrderRejected if a rule is violated
+    void Check(int px, int qty, Direction direction, TimeType now);
+
+    // Count the order for the rate limit once the exchange has accepted it
+    void OnOrderPosted(TimeType now);
+
+    [[nodiscard]] size_t GetChecks() const { return m_n_checks; }
+
+    [[nodiscard]] size_t GetRejects(RiskRule rule) const { return m_n_rejects[static_cast<size_t>(rule)]; }
+
+    void LogCounters() const;
+
+   private:
+    // RiskRule::Count if the order passes
+    [[nodiscard]] RiskRule Evaluate(int px, int qty, Direction direction, TimeType now) const;
+};
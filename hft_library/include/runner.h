@@ -4,14 +4,36 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <functional>
 #include <mutex>
-
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "allocations.h"
+#include "backtest/market_data.h"
+#include "backtest/virtual_exchange.h"
 #include "config.h"
+#include "config_watcher.h"
+#include "connector/instruments.h"
 #include "connector/market.h"
+#include "connector/sequencer.h"
 #include "connector/user.h"
 #include "connector/utils.h"
+#include "connector/wire.h"
+#include "coroutine.h"
+#include "risk.h"
+#include "shadow_feed.h"
+#include "startup.h"
+#include "status.h"
 #include "strategy.h"
+#include "supervisor.h"
+#include "threading.h"
 
 class Runner;
 
@@ -32,86 +54,427 @@ class LockGuard {
     friend class Runner;
 };
 
+// Live: trade through Tinkoff API
+// Backtest: replay recorded market data against VirtualExchange (no client and no logs without runner.log_directory)
+// Paper: live market data, orders are matched by VirtualExchange with the queue model (paper.money and paper.qty)
+enum class RunnerMode {
+    Live,
+    Backtest,
+    Paper
+};
+
+// Event types of the replay with separate allocation counters
+enum class ReplayEvent {
+    OrderBook,
+    Trade,
+    Fill,
+    Count
+};
+
 class Runner {
    private:
+    const uint64_t m_id;  // unique in the process
+
     // Config
     ConfigType m_config;
+    RunnerMode m_mode;
+    ThreadingConfig m_threading;
 
     // Loggers
     std::map<std::string, std::shared_ptr<spdlog::logger>> m_loggers;
     std::shared_ptr<spdlog::logger> m_runner_logger;
 
-    // Client for connectors
-    InvestApiClient m_client;
+    // Startup phases until the first order (logged by PostOrder)
+    StartupTimeline m_startup;
+
+    // Capture of the stream messages (runner.wire_record): outlives the client
+    std::unique_ptr<WireRecorder> m_wire_recorder;
+
+    // Client for connectors (Live mode)
+    std::unique_ptr<InvestApiClient> m_client;
 
-    // Instrument
+    // Simulated exchange (Backtest mode)
+    std::unique_ptr<VirtualExchange> m_virtual_exchange;
+    std::array<EventAllocations, static_cast<size_t>(ReplayEvent::Count)> m_replay_allocations;  // HFT_TRACK_ALLOCATIONS
+
+    // Instrument: checked against InstrumentsService (runner.instrument). Backtests take it from the config, shadows from the live runner
+    std::unique_ptr<InstrumentMetadataCache> m_instrument_cache;
     Instrument m_instrument;
+    bool m_is_halted = false;  // the refreshed metadata contradicts the instrument: no readiness and no orders
 
     std::atomic_int n_pending_events = 0;
     std::mutex m_mutex;
 
+    // Roles of the stream threads configured by this runner (under m_mutex): the first role keeps the placement
+    std::unordered_map<std::thread::id, ThreadRole> m_stream_thread_roles;
+
+    // Sequence numbers and anomalies of the inbound streams (stamped under the event lock)
+    StreamSequencer m_sequencer;
+
     // Connectors
     MarketConnector m_mkt;
     UserConnector m_usr;
 
+    // Pre-trade checks of PostOrder
+    RiskGate m_risk;
+
+    // Shared memory page for monitors (runner.status)
+    std::unique_ptr<StatusPublisher> m_status;
+
     // Readiness
     bool m_is_mkt_ready = false;
     bool m_is_usr_ready = false;
 
-    // Strategy
-    std::shared_ptr<Strategy> m_strategy;  // Strategy is an abstract class
+    // Reconnection (nullptr for shadows)
+    std::unique_ptr<StreamSupervisor> m_supervisor;
+    TimeType m_outage_start = 0;  // 0 if there is no outage
+
+    // Our trades while the connectors are not ready: delivered to the owners on readiness.
+    // Fills on post are delivered after the notification that posts the order
+    struct PendingOurTrade {
+        LimitOrder order;
+        int executed_qty;
+    };
+
+    std::vector<PendingOurTrade> m_pending_our_trades;
+    bool m_is_notifying = false;
+
+    // Notifications of the events processed while the event thread waits for requests without the event lock
+    // (RunWithoutEventLock): delivered after the notification that sent the requests
+    struct DeferredNotifications {
+        bool readiness = false;
+        bool order_book = false;
+        bool trades = false;
+        bool ping = false;
+        std::vector<const BarSeries*> bars;
+        // Ids of the updated orders: the current state is delivered. Slots [0, n_order_updates) are used, the strings keep their capacity
+        std::vector<std::string> order_ids;
+        size_t n_order_updates = 0;
+
+        [[nodiscard]] bool Any() const { return readiness || order_book || trades || ping || !bars.empty() || n_order_updates != 0; }
+
+        void AddOrderUpdate(const std::string& order_id) {
+            if (std::find(order_ids.begin(), order_ids.begin() + n_order_updates, order_id) != order_ids.begin() + n_order_updates) {
+                return;
+            }
+            if (n_order_updates < order_ids.size()) {
+                order_ids[n_order_updates].assign(order_id);
+            } else {
+                order_ids.push_back(order_id);
+            }
+            ++n_order_updates;
+        }
+
+        // Keeps the capacity of the buffers
+        void Clear() {
+            readiness = order_book = trades = ping = false;
+            bars.clear();
+            n_order_updates = 0;
+        }
+    };
+
+    bool m_is_requesting = false;  // the event lock is released by RunWithoutEventLock
+    int m_n_request_events = 0;    // events processed meanwhile
+    DeferredNotifications m_deferred;
+    DeferredNotifications m_delivering;  // swapped with m_deferred: the buffers are reused
+    bool m_is_delivering = false;        // notifications of m_delivering are running
+
+    // Live parameter reload (runner.config_reload): outlives the strategies that subscribe to it
+    std::unique_ptr<ConfigWatcher> m_config_watcher;
+    // Strategy sections of the last accepted reloads: a reloaded plugin is built with them (written on the watcher thread)
+    mutable std::mutex m_strategy_configs_mutex;
+    std::vector<ConfigType> m_strategy_configs;
+
+    // Strategies share the market data; each of them owns its orders and positions
+    std::vector<std::shared_ptr<Strategy>> m_strategies;  // Strategy is an abstract class
+    int m_active_strategy = 0;                            // strategy that is constructed or notified
+
+    // Paper runners fed with the market data of this runner, each on its own thread
+    std::vector<std::unique_ptr<ShadowFeed>> m_shadows;
+
+    // Order workflows of the current notification (coroutine.h)
+    struct OrderTaskSlot {
+        OrderTask task;
+        int strategy_id;
+        OrderRequest* request = nullptr;  // request of the suspended workflow
+    };
+
+    std::vector<OrderTaskSlot> m_order_tasks;
+    int m_current_task = -1;  // workflow that is running
+    // Buffers of the cancels of one round: keep their capacity between rounds
+    std::vector<std::string> m_cancel_order_ids;
+    std::vector<std::exception_ptr> m_cancel_errors;
 
    public:
     using StrategyGetter = std::function<std::shared_ptr<Strategy>(Runner&)>;
 
     Runner(const ConfigType& config, const StrategyGetter& strategy_getter);
 
+    // Strategy i is configured by strategies[i] (or strategy if there is one strategy)
+    Runner(const ConfigType& config, const std::vector<StrategyGetter>& strategy_getters);
+
+    // Shadow paper runner fed with the market data of primary: the messages are parsed once by primary and processed by the
+    // shadow on its own thread. Shadows have no client, instrument metadata, supervisor, status page, wire record or config
+    // reload, and are not started. Construct them before primary.Start(); they must outlive primary
+    Runner(const ConfigType& config, const StrategyGetter& strategy_getter, Runner& primary);
+
+    ~Runner();
+
     // Start all connectors
     void Start();
 
+    // Swap the strategy for a new version (e.g. of a reloaded plugin) between events: the connectors, streams and orders stay.
+    // The new strategy loads the state saved by the old one; the old one is destroyed before the next event
+    void ReplaceStrategy(int strategy_id, const StrategyGetter& strategy_getter);
+
+    // Replay the recorded day synchronously (Backtest mode)
+    void Backtest(const MarketDataFile& data);
+
+    // Backtest in parts: StartBacktest() and then Replay() of consecutive ranges of records
+    void StartBacktest();
+
+    void Replay(const MarketDataFile& data, size_t begin, size_t end);
+
     // Getters
     const ConfigType& GetConfig() const;
 
+    // Config of the strategy: strategies[strategy_id] or strategy, or its section of the last accepted reload
+    ConfigType GetStrategyConfig(int strategy_id) const;
+
+    // The strategy has accepted its section of a reloaded config (called on the ConfigWatcher thread)
+    void SetStrategyConfig(int strategy_id, const ConfigType& config);
+
+    // Config of the strategy that is constructed (for StrategyGetter)
+    ConfigType GetStrategyConfig() const;
+
+    // Strategy that is constructed or notified: its orders are posted on its behalf
+    int GetActiveStrategyId() const;
+
+    int GetStrategyCount() const;
+
+    RunnerMode GetMode() const;
+
+    const VirtualExchangeStats& GetBacktestStats() const;
+
+    const EventAllocations& GetReplayAllocations(ReplayEvent event) const;
+
+    void ResetReplayAllocations();
+
     const Instrument& GetInstrument() const;
 
     MarketConnector& GetMarketConnector();
 
     UserConnector& GetUserConnector();
 
+    const RiskGate& GetRiskGate() const;
+
+    StreamSequencer& GetSequencer();
+
+    const StreamSequencer& GetSequencer() const;
+
+    ConfigWatcher* GetConfigWatcher();  // nullptr without runner.config_reload (and in Backtest mode)
+
     std::shared_ptr<spdlog::logger> GetLogger(const std::string& name, bool only_text);
 
     int GetPendingEvents() const;
 
-    // Order manipulations
+    // Order manipulations. PostOrder throws OrderRejected if RiskGate rejects the order and OrderRejectedByExchange if the exchange does
     const LimitOrder& PostOrder(int px, int qty, Direction direction);
 
     void CancelOrder(const std::string& order_id);
 
+    // Order workflows: the strategy spawns a coroutine that co_awaits Post and Cancel (coroutine.h)
+    void Spawn(OrderTask task);
+
+    PostAwaitable Post(int px, int qty, Direction direction);
+
+    CancelAwaitable Cancel(const std::string& order_id);
+
+    // Cancel several orders of the workflow at once (errors are reported per order instead of thrown)
+    CancelBatchAwaitable Cancel(const std::vector<std::string>& order_ids, std::vector<std::exception_ptr>& errors);
+
    private:
+    Runner(const ConfigType& config, const std::vector<StrategyGetter>& strategy_getters, Runner* primary);
+
+    void AttachShadow(Runner& shadow);
+
+    friend class PostAwaitable;
+
+    friend class CancelAwaitable;
+
+    friend class CancelBatchAwaitable;
+
     friend class MarketConnector;
 
     friend class LockGuard;
 
+    friend class LoadGenerator;
+
+    friend class WirePlayer;
+
+    friend class ShadowFeed;
+
     // Getters for MarketConnector and UserConnector
     InvestApiClient& GetClient();
 
+    StreamSupervisor& GetSupervisor();
+
+    StartupTimeline& GetStartupTimeline();
+
+    VirtualExchange* GetVirtualExchange();  // nullptr in Live mode
+
     // Methods for synchronization
     LockGuard GetEventLock();
 
+    // Call the stream callback with its message. With runner.wire_record the message is recorded under the first event lock
+    // of the callback: the records follow the processing order of the streams
+    template <typename Callback>
+    void ProcessStreamMessage(WireStream stream, TimeType receive_time, const google::protobuf::MessageLite& message, const Callback& callback) {
+        if (!m_wire_recorder) {
+            callback();
+            return;
+        }
+        m_wire_recorder->Stage(stream, receive_time, message);
+        try {
+            callback();
+        } catch (...) {
+            RecordStagedMessage();
+            throw;
+        }
+        RecordStagedMessage();
+    }
+
+    // The callback did not take the event lock (subscription responses) or has thrown
+    void RecordStagedMessage();
+
+    // Configure stream thread on its first callback
+    void ConfigureStreamThread(ThreadRole role);
+
     // Methods for MarketConnector
+    // Parsed stream messages: processed by this runner and its shadows
+    void DispatchOrderBook(TimeType receive_time, TimeType exchange_time, const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty);
+
+    void DispatchTrade(TimeType receive_time, TimeType exchange_time, Direction direction, int px, int qty);
+
     void OnMarketConnectorReady();
 
+    void OnMarketConnectorLost();
+
     void OnOrderBookUpdate();
 
     void OnTradesUpdate();
 
+    void OnBarClosed(const BarSeries& bars);
+
+    void OnMarkToMarket(TimeType exchange_time);
+
+    // Methods for MarketConnector and UserConnector
+    void OnPingUpdate();
+
     friend class UserConnector;
 
     // Methods for UserConnector
     void OnUserConnectorReady();
 
+    void OnUserConnectorLost();
+
     void OnOurTrade(const LimitOrder& order, int executed_qty);
 
+    void OnOrderUpdate(const LimitOrder& order);
+
+    // Wait for the requests of the event thread without the event lock: events of the other threads are processed meanwhile
+    // and their notifications are deferred. Called from RunOrderTasks (under the event lock, inside a notification)
+    template <typename Function>
+    void RunWithoutEventLock(const Function& function) {
+        assert(m_is_notifying && !m_is_requesting);
+        m_is_requesting = true;
+        m_n_request_events = 0;
+        // The other threads do not see the event thread as a pending event
+        --n_pending_events;
+        m_mutex.unlock();
+        try {
+            function();
+        } catch (...) {
+            ++n_pending_events;
+            m_mutex.lock();
+            m_is_requesting = false;
+            throw;
+        }
+        ++n_pending_events;
+        m_mutex.lock();
+        m_is_requesting = false;
+        // Events that skip their notifications (more events were pending) have moved the market too
+        if (m_n_request_events > 0) {
+            m_deferred.order_book = true;
+        }
+    }
+
     // Methods for Runner
     bool IsReady();
+
+    // Under the event lock: wait until the event thread has the replies of its cancels (RunWithoutEventLock)
+    void WaitForRequests();
+
+    // Instrument check of the background refresh has failed (refresh thread): stop quoting and cancel the resting orders
+    void HaltOnInstrumentMismatch(const std::string& error);
+
+    void OnConnectorsReadiness();
+
+    void DeliverPendingOurTrades();
+
+    void DeliverDeferredNotifications();
+
+    void DeliverDeferredRounds();
+
+    // Strategies are notified in their order on the event thread: the overhead is one call per strategy
+    template <typename Notification>
+    void NotifyStrategy(int strategy_id, const Notification& notification) {
+        const bool is_nested = std::exchange(m_is_notifying, true);
+        m_active_strategy = strategy_id;
+        try {
+            notification(*m_strategies[strategy_id]);
+            // Workflows spawned by the notification run to completion before the next one
+            if (!m_order_tasks.empty()) {
+                RunOrderTasks();
+            }
+        } catch (...) {
+            m_is_notifying = is_nested;
+            throw;
+        }
+        m_is_notifying = is_nested;
+        // Fills on post of the notification
+        if (!is_nested && !m_pending_our_trades.empty() && IsReady()) {
+            DeliverPendingOurTrades();
+        }
+        // Events processed while the cancels of the notification were in flight
+        if (!is_nested && m_deferred.Any()) {
+            DeliverDeferredNotifications();
+        }
+    }
+
+    template <typename Notification>
+    void NotifyStrategies(const Notification& notification) {
+        for (int i = 0; i < static_cast<int>(m_strategies.size()); ++i) {
+            NotifyStrategy(i, notification);
+        }
+    }
+
+    // Methods for order workflows
+    void SuspendOrderTask(OrderRequest& request);
+
+    void ResumeOrderTask(size_t index);
+
+    // Execute the requests of the suspended workflows in rounds and resume them
+    void RunOrderTasks();
+
+    // Deliver executions of VirtualExchange. Returns the number of allocations inside them
+    size_t ProcessVirtualFills();
+
+    // Paper mode: match the orders against the event before and after the strategy sees it
+    void ProcessPaperOrderBook(TimeType receive_time, TimeType exchange_time, const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty);
+
+    void ProcessPaperTrade(TimeType receive_time, TimeType exchange_time, Direction direction, int px, int qty);
+
+    // Stream threads of paper runners race on VirtualExchange: fills are matched under the event lock
+    void ProcessPaperFills();
 };
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "clock.h"
+#include "connector/utils.h"
+#include "constants.h"
+
+class Runner;
+
+// Market data of the live runner for one shadow paper runner: the stream threads copy the parsed message into a
+// bounded queue and return; the shadow processes it on its own thread. Messages are dropped (and counted) while the
+// queue is full: a slow shadow never delays the live runner
+class ShadowFeed {
+   public:
+    constexpr static size_t CAPACITY = 1 << 12;
+
+   private:
+    struct Event {
+        bool is_order_book;
+        TimeType receive_time;
+        TimeType exchange_time;
+        // Trade
+        Direction direction;
+        int px;
+        int qty;
+        // OrderBook
+        std::array<int, MAX_DEPTH> bid_px;
+        std::array<int, MAX_DEPTH> bid_qty;
+        std::array<int, MAX_DEPTH> ask_px;
+        std::array<int, MAX_DEPTH> ask_qty;
+    };
+
+    Runner& m_shadow;
+    std::shared_ptr<spdlog::logger> m_logger;
+    const int m_depth;
+
+    // Ring of events: [m_begin, m_end) are pending
+    std::mutex m_mutex;
+    std::condition_variable_any m_cv;
+    std::vector<Event> m_events;
+    size_t m_begin = 0;
+    size_t m_end = 0;
+    size_t m_n_dropped = 0;
+
+    std::jthread m_thread;
+
+   public:
+    ShadowFeed(Runner& shadow, int depth, std::shared_ptr<spdlog::logger> logger);
+
+    ShadowFeed(const ShadowFeed&) = delete;
+
+    ShadowFeed& operator=(const ShadowFeed&) = delete;
+
+    // Stop the thread: pending events are dropped
+    ~ShadowFeed();
+
+    // Called on the stream threads of the live runner
+    void PushOrderBook(TimeType receive_time, TimeType exchange_time, const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty);
+
+    void PushTrade(TimeType receive_time, TimeType exchange_time, Direction direction, int px, int qty);
+
+   private:
+    // Slot of the next event under the mutex: nullptr if the queue is full
+    Event* Reserve();
+
+    // Publish the reserved slot and release the mutex
+    void Commit(std::unique_lock<std::mutex>& lock);
+
+    void Loop(std::stop_token stop_token);
+};
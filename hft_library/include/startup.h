@@ -0,0 +1,64 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "clock.h"
+
+// Phases of the startup from the process start to the first order. Phases are recorded from any thread
+// (the startup requests run concurrently) and logged once as a timeline when the first order is posted
+class StartupTimeline {
+   private:
+    struct Phase {
+        std::string name;
+        TimeType begin;
+        TimeType end;  // begin for milestones
+    };
+
+    const TimeType m_process_start;  // from /proc/self/stat (10 ms resolution)
+    std::mutex m_mutex;
+    std::vector<Phase> m_phases;
+    std::atomic<bool> m_is_logged = false;  // written under m_mutex
+
+   public:
+    // Records the phase on destruction
+    class Scope {
+        StartupTimeline& m_timeline;
+        std::string m_name;
+        const TimeType m_begin;
+
+       public:
+        Scope(StartupTimeline& timeline, std::string name);
+
+        Scope(const Scope&) = delete;
+
+        Scope& operator=(const Scope&) = delete;
+
+        ~Scope();
+    };
+
+    StartupTimeline();
+
+    [[nodiscard]] Scope Measure(std::string name);
+
+    // Milestone (e.g. readiness of a connector)
+    void Mark(std::string name);
+
+    // Log the phases sorted by start: offset from the process start and duration. Only the first call logs
+    void Log(spdlog::logger& logger);
+
+    // Checked before the first order is logged: no lock
+    bool IsLogged() const {
+        return m_is_logged.load(std::memory_order_relaxed);
+    }
+
+    // Drop the phases without logging them (backtests do not start the connectors)
+    void Discard();
+
+   private:
+    void Record(std::string name, TimeType begin, TimeType end);
+};
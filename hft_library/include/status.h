@@ -0,0 +1,169 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include "clock.h"
+#include "config.h"
+#include "connector/market.h"
+#include "connector/sequencer.h"
+#include "connector/user.h"
+#include "risk.h"
+
+// Live state of the Runner in a shared memory page (runner.status.path, e.g. /dev/shm/hft_status)
+// Monitors map the file read-only and read it without broker calls (scripts/common/status_page.py).
+// The event thread is the only writer and copies raw values only: the reader computes the latency percentiles
+// from the samples. Seqlock: sequence is odd while the page is written; a reader copies the page and retries
+// if sequence was odd or changed during the copy. The payload is written with relaxed atomic stores.
+namespace status {
+
+constexpr char MAGIC[8] = "HFTST01";
+
+constexpr size_t MAX_ORDERS = 64;  // resting orders beyond it are counted in n_orders only
+
+constexpr size_t N_LATENCIES = 4;  // OrderBook, Trades, Ping, OrdersStream
+
+constexpr size_t LATENCY_WINDOW = LatencyTracker::WINDOW;
+
+struct Order {
+    int32_t px;         // real_px / px_step
+    int32_t qty;        // in lots
+    int32_t direction;  // 1 if Buy; -1 if Sell
+    int32_t status;     // OrderStatus
+};
+
+struct Latency {
+    int64_t count;  // 0 if there are no samples
+    int64_t last;   // in ns: receive_time - exchange_time without the clock offset correction
+    int64_t min;
+    int64_t samples[LATENCY_WINDOW];  // sample i is samples[i % LATENCY_WINDOW] for the last min(count, LATENCY_WINDOW) samples
+};
+
+// All fields are plain values: the layout is mirrored by the Python reader
+struct Page {
+    char magic[8];
+    std::atomic<uint64_t> sequence;
+    int64_t publish_time;  // ns since epoch
+    int64_t n_publishes;
+
+    // Instrument
+    char figi[16];
+    int32_t lot_size;
+    int32_t padding;
+    double px_step;
+
+    // Readiness
+    int32_t is_market_ready;
+    int32_t is_user_ready;
+    int32_t is_feed_stale;
+    int32_t pending_events;
+
+    // Market
+    int64_t order_book_time;
+    int32_t best_bid_px;
+    int32_t best_bid_qty;
+    int32_t best_ask_px;
+    int32_t best_ask_qty;
+
+    // Positions (money in px steps per lot)
+    int32_t qty;
+    int32_t money;
+    int32_t open_buy_qty;
+    int32_t open_sell_qty;
+    int64_t open_buy_notional;
+
+    // PnL
+    double realized;
+    double unrealized;
+    double fees;
+    double total;
+    double exposure;
+    double avg_px;
+    double mid_px;
+    int64_t turnover;
+    int64_t volume;
+    int64_t n_fills;
+
+    // Latency
+    int64_t clock_offset;
+    int64_t feed_latency;
+    Latency latencies[N_LATENCIES];
+
+    // Counters
+    int64_t n_events;
+    int64_t n_orderbooks;
+    int64_t n_orderbook_skips;
+    int64_t n_trades;
+    int64_t n_trade_skips;
+    int64_t n_risk_checks;
+    int64_t n_risk_rejects[static_cast<size_t>(RiskRule::Count)];
+    int64_t n_stream_anomalies[static_cast<size_t>(StreamAnomaly::Count)];
+    int64_t n_ladder_dropped_levels;  // levels of the book outside market.ladder_size
+
+    // Resting orders
+    int64_t n_orders;
+    Order orders[MAX_ORDERS];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+// Payload stores of the writer: the reader copies the page concurrently
+template <typename T>
+void Store(T& field, std::type_identity_t<T> value) {
+    std::atomic_ref<T>(field).store(value, std::memory_order_relaxed);
+}
+
+}  // namespace status
+
+// Publishes the page at the end of events under the event lock: no system calls, no allocations and no sorting.
+// Only the latency samples added since the previous publish are copied.
+// Config (section runner.status, optional):
+//   path: /dev/shm/hft_status  -- file of the page (created or truncated)
+//   period_ms: 100             -- min period between publishes (events in between are only counted)
+class StatusPublisher {
+   private:
+    std::shared_ptr<spdlog::logger> m_logger;
+    const Instrument& m_instrument;
+    const MarketConnector& m_mkt;
+    const UserConnector& m_usr;
+    const RiskGate& m_risk;
+    const StreamSequencer& m_sequencer;
+
+    // Parameters
+    const std::string m_path;
+    const TimeType m_period;  // in ns
+
+    status::Page* m_page = nullptr;
+    TimeType m_next_publish_time = 0;
+    int64_t m_n_events = 0;
+    std::array<size_t, status::N_LATENCIES> m_n_published_samples{};
+
+   public:
+    StatusPublisher(const ConfigType& config, const Instrument& instrument, const MarketConnector& mkt, const UserConnector& usr, const RiskGate& risk, const StreamSequencer& sequencer, std::shared_ptr<spdlog::logger> logger);
+
+    StatusPublisher(const StatusPublisher&) = delete;
+
+    StatusPublisher& operator=(const StatusPublisher&) = delete;
+
+    // Unmap the page (the file is kept for post-mortem reads)
+    ~StatusPublisher();
+
+    // Called at the end of each event on the event thread
+    void OnEvent(bool is_market_ready, bool is_user_ready, int pending_events) {
+        ++m_n_events;
+        const TimeType now = TscClock::Now();
+        if (now >= m_next_publish_time) {
+            Publish(now, is_market_ready, is_user_ready, pending_events);
+        }
+    }
+
+   private:
+    void Publish(TimeType now, bool is_market_ready, bool is_user_ready, int pending_events);
+
+    void PublishLatencies();
+};
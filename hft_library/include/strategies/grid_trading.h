@@ -0,0 +1,467 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "config_watcher.h"
+#include "coroutine.h"
+#include "pool_allocator.h"
+#include "runner.h"
+#include "strategy.h"
+
+struct GridTradingParameters {
+    int max_levels;
+    int order_size;
+    int spread;
+    bool debug;
+
+    // Throws on invalid parameters: reloaded configs are rejected instead of asserting on the event thread
+    static GridTradingParameters Parse(const ConfigType& config) {
+        GridTradingParameters parameters{
+            .max_levels = config["max_levels"].as<int>(),
+            .order_size = config["order_size"].as<int>(),
+            .spread = config["spread"].as<int>(),
+            .debug = config["debug"].as<bool>()};
+        if (parameters.max_levels < 1 || parameters.order_size < 1 || parameters.spread < 2) {
+            throw std::runtime_error(fmt::format("Invalid GridTrading parameters: max_levels={}; order_size={}; spread={}", parameters.max_levels, parameters.order_size, parameters.spread));
+        }
+        return parameters;
+    }
+};
+
+class GridTrading : public Strategy {
+   private:
+    // Parameters: copies of the snapshot that is applied on the event thread
+    int max_levels;
+    int order_size;
+    int spread;
+    bool debug;
+
+    // Snapshots of runner.config_reload are published by the watcher thread
+    AtomicSnapshot<GridTradingParameters> m_parameters;
+    const GridTradingParameters* m_applied_parameters = nullptr;
+    ConfigWatcher::Subscription m_parameters_subscription;  // destroyed before m_parameters
+
+    int m_first_bid_px = 0;   // first_ask = first_bid_px + spread + (first_bid_qty == order_size)
+    int m_first_bid_qty = 0;  // first_ask_qty = order_size - target_bid_qty + order_size * (first_bid_qty == order_size)
+
+    std::shared_ptr<spdlog::logger> m_first_quotes_logger;
+
+    // Buffers of a requote workflow: leased to its frame, they keep their capacity between workflows
+    struct RequoteBuffers {
+        std::vector<std::string> cancel_order_ids;
+        std::vector<std::exception_ptr> cancel_errors;
+        std::array<std::vector<std::pair<int, int>>, 2> posts;  // px, qty of (ask, bid)
+    };
+
+    class RequoteBuffersLease {
+        std::vector<std::unique_ptr<RequoteBuffers>>& m_free;
+        std::unique_ptr<RequoteBuffers> m_buffers;
+
+       public:
+        explicit RequoteBuffersLease(std::vector<std::unique_ptr<RequoteBuffers>>& free) : m_free(free) {
+            if (m_free.empty()) {
+                m_buffers = std::make_unique<RequoteBuffers>();
+            } else {
+                m_buffers = std::move(m_free.back());
+                m_free.pop_back();
+            }
+        }
+
+        RequoteBuffersLease(const RequoteBuffersLease&) = delete;
+
+        RequoteBuffersLease& operator=(const RequoteBuffersLease&) = delete;
+
+        ~RequoteBuffersLease() { m_free.push_back(std::move(m_buffers)); }
+
+        RequoteBuffers& operator*() const { return *m_buffers; }
+    };
+
+    std::vector<std::unique_ptr<RequoteBuffers>> m_free_requote_buffers;
+
+   public:
+    explicit GridTrading(Runner& runner, const ConfigType& config)
+        : Strategy(runner),
+          m_parameters(GridTradingParameters::Parse(config)),
+          m_first_quotes_logger(m_runner.GetLogger("first_bid_px_qty", true)) {
+        // Apply and log strategy parameters
+        ApplyParameters();
+        if (ConfigWatcher* watcher = m_runner.GetConfigWatcher()) {
+            m_parameters_subscription = watcher->Subscribe([this](const ConfigType& new_config) {
+                const ConfigType config = get_strategy_config(new_config, m_strategy_id);
+                m_parameters.Publish(GridTradingParameters::Parse(config));
+                // A reloaded version of the plugin starts with the accepted parameters
+                m_runner.SetStrategyConfig(m_strategy_id, config);
+            });
+        }
+        // log first quotes header
+        m_first_quotes_logger->info("strategy_time,first_bid_px,first_ask_px,first_bid_qty,first_ask_qty,max_bid_qty,max_ask_qty");
+    }
+
+   private:
+    // Parameters
+    // One atomic load per event: the new snapshot is applied between events
+    void ApplyParameters() {
+        const GridTradingParameters& parameters = m_parameters.Get();
+        if (&parameters == m_applied_parameters) {
+            return;
+        }
+        m_applied_parameters = &parameters;
+        max_levels = parameters.max_levels;
+        order_size = parameters.order_size;
+        spread = parameters.spread;
+        debug = parameters.debug;
+        m_first_bid_qty = std::min(m_first_bid_qty, order_size);
+        m_logger->info("spread = {}; order_size = {};  max_levels = {}; debug = {}", spread, order_size, max_levels, debug);
+    }
+
+    // Utils
+    template <bool IsBid>
+    static constexpr int Sign() {
+        if constexpr (IsBid) {
+            return 1;
+        } else {
+            return -1;
+        }
+    }
+
+    template <bool IsBid>
+    const OneSideMarketOrderBook<IsBid>& GetOb() const {
+        if constexpr (IsBid) {
+            return m_order_book.bid;
+        } else {
+            return m_order_book.ask;
+        }
+    }
+
+    bool CheckEventsPending(const char* msg) {
+        if (m_runner.GetPendingEvents() >= 1) {
+            m_logger->info("Break {}: {} events pending", msg, m_runner.GetPendingEvents());
+            return true;
+        }
+        return false;
+    }
+
+    template <bool IsBid>
+    int GetFirstPx() const {
+        assert(0 <= m_first_bid_qty);
+        assert(m_first_bid_qty <= order_size);
+        if constexpr (IsBid) {
+            return m_first_bid_px;
+        } else {
+            return m_first_bid_px + spread + (m_first_bid_qty == order_size);
+        }
+    }
+
+    template <bool IsBid>
+    int GetFirstQty() const {
+        assert(0 <= m_first_bid_qty);
+        assert(m_first_bid_qty <= order_size);
+        if constexpr (IsBid) {
+            assert(m_first_bid_qty <= GetMaxPostQty<true>());
+            return m_first_bid_qty;
+        } else {
+            int first_ask_qty = order_size - m_first_bid_qty + order_size * (m_first_bid_qty == order_size);
+            return std::min(first_ask_qty, GetMaxPostQty<IsBid>());
+        }
+    }
+
+    template <bool IsBid>
+    int GetMaxPostQty() const {
+        if constexpr (IsBid) {
+            return m_positions.money / (m_order_book.bid[0].px + 5) * (m_positions.money >= 0);
+        } else {
+            return m_positions.qty;
+        }
+    }
+
+    void LogCurrentQuotes() {
+        m_first_quotes_logger->info("{},{},{},{},{},{},{}", current_time(), GetFirstPx<true>(), GetFirstPx<false>(), GetFirstQty<true>(), GetFirstQty<false>(), GetMaxPostQty<true>(), GetMaxPostQty<false>());
+    }
+
+    // Quotes Updates
+    void InitializeFirstQuotes() {
+        // Calculate best_px
+        m_first_bid_px = (m_order_book.bid[0].px + m_order_book.ask[0].px) / 2 - spread / 2;
+
+        // Calculate first qty
+        m_first_bid_qty = std::min(GetMaxPostQty<true>(), order_size);
+
+        // Log initial quotes
+        m_logger->info("InitializeFirstQuotes: first_bid_px={}, fitst_bid_qty={}", m_first_bid_px, m_first_bid_qty);
+        LogCurrentQuotes();
+    }
+
+    void UpdateFirstQuotesOnPriceChange() {
+        int first_ask_qty = GetFirstQty<false>();
+        assert(m_first_bid_qty > 0 || first_ask_qty > 0);
+        int first_bid_px_old = m_first_bid_px;
+        if (m_first_bid_qty == 0) {
+            // No quotes on bid side
+            // We only have the asset -> decrease the m_first_bid_px
+            // ask = best_ask + spread
+            m_first_bid_px = std::min(m_first_bid_px, m_order_book.ask[0].px);
+        } else if (first_ask_qty == 0) {
+            // No quotes on ask side
+            // We only have money -> increase the m_first_bid_px
+            // bid = best_bid - spread
+            m_first_bid_px = std::max(m_first_bid_px, m_order_book.bid[0].px - spread);
+        } else {
+            // We have quotes on both sides
+        }
+        if (first_bid_px_old != m_first_bid_px) {
+            m_logger->info("first_bid_px: {} -> {}", first_bid_px_old, m_first_bid_px);
+            LogCurrentQuotes();
+        }
+    }
+
+    template <bool IsBid>
+    void UpdateFirstQuotesOnExecution(int executed_px, int executed_qty) {
+        // IsBid = true -> executed_qty from bids
+        int first_bid_px_old = m_first_bid_px;
+        int first_bid_qty_old = m_first_bid_qty;
+
+        if constexpr (IsBid) {
+            // Update best bid qty
+            m_first_bid_qty -= executed_qty;
+            if (m_first_bid_qty <= 0) {
+                // Update best bid price if the whole level on bids was executed
+                m_first_bid_qty += order_size;
+                --m_first_bid_px;
+            }
+            m_first_bid_qty = std::min(m_first_bid_qty, GetMaxPostQty<IsBid>());
+        } else {
+            // Update best bid qty
+            m_first_bid_qty += executed_qty;
+            if (m_first_bid_qty > order_size) {
+                // Update best bid price if the whole level on asks was executed
+                m_first_bid_qty -= order_size;
+                ++m_first_bid_px;
+            }
+        }
+        m_logger->info("UpdateFirstQuotesOnExecution({}; executed_px={}; executed_qty={}): first_bid_px: {} -> {}; first_bid_qty: {} -> {}", (IsBid ? "bid" : "ask"), executed_px, executed_qty, first_bid_px_old, m_first_bid_px, first_bid_qty_old, m_first_bid_qty);
+        LogCurrentQuotes();
+        assert(m_first_bid_qty >= 0);
+        assert(m_first_bid_qty <= order_size);
+    }
+
+    // Market depth at the target quotes: one ladder lookup per level.
+    // Market qty at our px is the queue ahead of a new order; a level that meets the opposite side would take liquidity instead of resting
+    template <bool IsBid>
+    void CheckGridDepth(const PoolMap<int, int>& new_qty_by_px) const {
+        int n_crossing = 0;
+        int crossed_qty = 0;
+        // Nothing to cross if the opposite side is empty
+        const int opposite_px = m_ladder.GetBestPx<!IsBid>();
+        for (const auto& [px, qty] : new_qty_by_px) {
+            if (opposite_px != 0 && Sign<IsBid>() * (px - opposite_px) >= 0) {
+                ++n_crossing;
+                crossed_qty += m_ladder.GetQty<!IsBid>(px);
+            }
+        }
+        if (n_crossing > 0) {
+            m_logger->info("{} of {} {} levels cross the book (best {} px={}): {} qty rests at their px", n_crossing, new_qty_by_px.size(), (IsBid ? "bid" : "ask"), (IsBid ? "ask" : "bid"), opposite_px, crossed_qty);
+        }
+        if (m_logger->should_log(spdlog::level::trace)) {
+            fmt::memory_buffer buf;
+            for (const auto& [px, qty] : new_qty_by_px) {
+                fmt::format_to(std::back_inserter(buf), " {}:{}", px, m_ladder.GetQty<IsBid>(px));
+            }
+            m_logger->trace("Market qty at {} levels (px:qty):{}", (IsBid ? "bid" : "ask"), std::string_view(buf.data(), buf.size()));
+        }
+    }
+
+    // Target quotes of one side: orders to cancel are appended to cancel_order_ids, missing qty to posts
+    // (bids from the lowest px, asks from the highest px)
+    template <bool IsBid>
+    void FindSideRequests(std::vector<std::string>& cancel_order_ids, std::vector<std::pair<int, int>>& posts) const {
+        // Calculate target quotes (map nodes are recycled between calls)
+        PoolMap<int, int> new_qty_by_px;
+        int max_post_qty = GetMaxPostQty<IsBid>();
+        int sign = Sign<IsBid>();
+        int first_qty = GetFirstQty<IsBid>();
+        int first_px = GetFirstPx<IsBid>();
+        if (first_qty > 0) {
+            // First quote
+            new_qty_by_px[first_px] = first_qty;
+            assert(first_qty <= max_post_qty);
+            max_post_qty -= first_qty;
+            // Other quotes
+            for (int i = 1; (i < max_levels) && (max_post_qty > 0); ++i) {
+                int new_qty = std::min(order_size, max_post_qty);
+                new_qty_by_px[first_px - sign * i] = new_qty;
+                max_post_qty -= new_qty;
+            }
+        }
+
+        CheckGridDepth<IsBid>(new_qty_by_px);
+
+        // Calculate old quotes
+        PoolMap<int, int> old_qty_by_px;
+        for (const auto& [order_id, order] : m_positions.orders) {
+            assert(order.qty > 0);
+            old_qty_by_px[order.px] += order.qty;
+        }
+        assert(new_qty_by_px.size() <= max_levels);
+
+        // Find orders to cancel
+        for (const auto& [order_id, order] : m_positions.orders) {
+            assert(order.qty != 0);
+            if (order.direction == Direction::Buy && IsBid || order.direction == Direction::Sell && !IsBid) {
+                if (!new_qty_by_px.contains(order.px) || new_qty_by_px[order.px] < old_qty_by_px[order.px]) {
+                    m_logger->info("CancelOrder(order_id={}); order={}", order_id, order);
+                    cancel_order_ids.push_back(order_id);
+                    old_qty_by_px[order.px] -= order.qty;
+                }
+            }
+        }
+
+        // Find orders to post
+        posts.clear();
+        auto add_post = [this, &posts, &old_qty_by_px](const auto& pair) {
+            const auto [px, qty] = pair;
+            const int place_qty = qty - old_qty_by_px[px];
+            assert(place_qty <= order_size);
+            if (place_qty > 0) {
+                posts.emplace_back(px, place_qty);
+            }
+        };
+        if constexpr (IsBid) {
+            std::for_each(new_qty_by_px.begin(), new_qty_by_px.end(), add_post);
+        } else {
+            std::for_each(new_qty_by_px.rbegin(), new_qty_by_px.rend(), add_post);
+        }
+    }
+
+    // Requote as an order workflow: the cancels of both sides are sent at once and complete before any post,
+    // so a new order never meets a resting order of the other side. Runner destroys the workflow if more events are pending
+    OrderTask Requote() {
+        RequoteBuffersLease lease(m_free_requote_buffers);
+        RequoteBuffers& buffers = *lease;
+        buffers.cancel_order_ids.clear();
+        FindSideRequests<true>(buffers.cancel_order_ids, buffers.posts[true]);
+        FindSideRequests<false>(buffers.cancel_order_ids, buffers.posts[false]);
+
+        // Cancel inappropriate orders
+        if (!debug) {
+            co_await m_runner.Cancel(buffers.cancel_order_ids, buffers.cancel_errors);
+            for (const std::exception_ptr& error : buffers.cancel_errors) {
+                if (error) {
+                    m_logger->warn("Could not cancel the order (possible execution). Break posting orders");
+                    co_return;
+                }
+            }
+        }
+
+        // Place new orders
+        for (const bool is_bid : {true, false}) {
+            const Direction direction = is_bid ? Direction::Buy : Direction::Sell;
+            for (const auto& [px, qty] : buffers.posts[is_bid]) {
+                bool is_posted = false;
+                try {
+                    m_logger->info("PostOrder(px={}, qty={}, direction={})", px, qty, direction);
+                    if (!debug) {
+                        co_await m_runner.Post(px, qty, direction);
+                    }
+                    is_posted = true;
+                } catch (const ServiceReply& reply) {
+                    m_logger->error("Could not post the order. Break posting orders");
+                } catch (const OrderRejected& rejected) {
+                    m_logger->warn("Order is rejected by RiskGate ({}). Break posting orders", RiskRuleName(rejected.rule));
+                } catch (const OrderRejectedByExchange& rejected) {
+                    m_logger->error("Order is rejected by the exchange ({}). Break posting orders", rejected.what());
+                }
+                if (!is_posted) {
+                    co_return;
+                }
+            }
+        }
+    }
+
+    void PostOrders() {
+        if (CheckEventsPending("PostOrders() start")) {
+            return;
+        }
+        if (m_runner.GetMarketConnector().IsFeedStale()) {
+            m_logger->info("Skip PostOrders: feed is stale (latency={} us; silence={} us)", m_runner.GetMarketConnector().GetFeedLatency() / 1000, m_runner.GetMarketConnector().GetFeedSilence() / 1000);
+            return;
+        }
+
+        // Update quotes on huge price change if necessary
+        UpdateFirstQuotesOnPriceChange();
+
+        m_runner.Spawn(Requote());
+    }
+
+    void OnConnectorsReadiness() override {
+        ApplyParameters();
+        m_logger->info("All connectors are ready");
+        m_logger->info("OrderBook:\n{}\nTrades: {}\nPositions:\n{}", m_order_book, m_trades, m_positions);
+        // Initialize first quotes for bid/ask
+        InitializeFirstQuotes();
+        // Post initial orders
+        PostOrders();
+    }
+
+    // First quotes are carried over on reload: resting orders keep their levels
+    std::string SaveState() const override {
+        return std::to_string(m_first_bid_px) + " " + std::to_string(m_first_bid_qty);
+    }
+
+    void LoadState(const std::string& state) override {
+        if (state.empty()) {
+            return;
+        }
+        std::istringstream stream(state);
+        stream >> m_first_bid_px >> m_first_bid_qty;
+        // order_size of the new version may be smaller
+        m_first_bid_qty = std::min(m_first_bid_qty, order_size);
+        m_logger->info("LoadState: first_bid_px={}; first_bid_qty={}", m_first_bid_px, m_first_bid_qty);
+    }
+
+    void OnStrategyReloaded() override {
+        ApplyParameters();
+        m_logger->info("Strategy is reloaded");
+        m_logger->info("OrderBook:\n{}\nTrades: {}\nPositions:\n{}", m_order_book, m_trades, m_positions);
+        PostOrders();
+    }
+
+    void OnOrderBookUpdate() override {
+        ApplyParameters();
+        // Log event
+        m_logger->trace("OrderBook update.\tbid_px={}; ask_px={}; first_bid_px={}; first_bid_qty={}", m_order_book.bid[0].px, m_order_book.ask[0].px, m_first_bid_px, m_first_bid_qty);
+
+        // Handle event
+        PostOrders();
+    }
+
+    void OnTradesUpdate() override {
+        ApplyParameters();
+        // Log event
+        m_logger->trace("OnTradesUpdate update.\tbid_px={}; ask_px={}; first_bid_px={}; first_bid_qty={}. Trade: {}", m_order_book.bid[0].px, m_order_book.ask[0].px, m_first_bid_px, m_first_bid_qty, m_trades);
+
+        // Handle event
+        PostOrders();
+    }
+
+    void OnOurTrade(const LimitOrder& order, int executed_qty) override {
+        ApplyParameters();
+        // Log event
+        m_logger->info("Execution: executed_qty={} on order={}", executed_qty, order);
+        m_logger->info("money={}; qty={}; n_orders={}", m_positions.money, m_positions.qty, m_positions.orders.size());
+
+        // Update quotes
+        if (order.direction == Direction::Buy) {
+            UpdateFirstQuotesOnExecution<true>(order.px, executed_qty);
+        } else {
+            UpdateFirstQuotesOnExecution<false>(order.px, executed_qty);
+        }
+
+        // Handdle event
+        PostOrders();
+    }
+};
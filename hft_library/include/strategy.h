@@ -7,6 +7,7 @@
 #include "connector/utils.h"
 #include "connector/user.h"
 #include "connector/market.h"
+#include "connector/sequencer.h"
 
 class Runner;
 
@@ -14,6 +15,7 @@ class Strategy {
 protected:
     // Runner and connectors
     Runner& m_runner;
+    const int m_strategy_id;  // index in the strategies of the runner
     std::shared_ptr<spdlog::logger> m_logger;
 
     // Config and instrument
@@ -22,10 +24,14 @@ protected:
 
     // Market data
     const MarketOrderBook& m_order_book;
+    const PriceLadder& m_ladder;  // the same book indexed by px: m_ladder.GetQty<IsBid>(px)
     const Trades& m_trades;
+    const std::vector<BarSeries>& m_bars;  // one series per market.bar_resolutions_s
+    const StreamSequencer& m_streams;      // last event of each stream: m_streams.IsBookBehindFills() after our trade
 
     // User data
-    const Positions& m_positions;
+    const Positions& m_positions;  // orders and positions of this strategy
+    const PnLTracker& m_pnl;  // of the account; m_pnl.GetPnL() is marked to the current order book
 
 public:
     Strategy(Runner& runner);
@@ -33,8 +39,6 @@ public:
 private:
     friend class Runner;
 
-    // TODO: OnPingUpdate()
-
     // Runner methods
     virtual void OnConnectorsReadiness() = 0;
 
@@ -43,6 +47,23 @@ private:
 
     virtual void OnTradesUpdate() = 0;
 
+    // Bar of the series is closed: bars[0]. Not skipped when events are pending
+    virtual void OnBarClosed(const BarSeries& bars) {}
+
+    // Market and User Connector methods: ping from the stream updates latency estimates
+    virtual void OnPingUpdate() {}
+
     // User Connector methods
     virtual void OnOurTrade(const LimitOrder& order, int executed_qty) = 0;
+
+    // Order status is changed by the exchange (acknowledgement, cancel or reject)
+    virtual void OnOrderUpdate(const LimitOrder& order) {}
+
+    // Hot reload (Runner::ReplaceStrategy): the old version saves its state, the new version loads it before any notification
+    virtual std::string SaveState() const { return {}; }
+
+    virtual void LoadState(const std::string& state) {}
+
+    // The new version replaced the old one while the connectors are ready: orders of the old version are still resting
+    virtual void OnStrategyReloaded() { OnConnectorsReadiness(); }
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "clock.h"
+#include "constants.h"
+
+enum class StreamType {
+    OrderBook,
+    Trades,
+    Orders
+};
+
+const char* StreamTypeName(StreamType type);
+
+// Watch streams for failures and silence. Reconnect them with exponential backoff.
+// Callbacks report messages and failures; reconnect functions run in the supervisor thread.
+class StreamSupervisor {
+   public:
+    using ReconnectFunction = std::function<void()>;  // throws on failure
+
+   private:
+    constexpr static int N_STREAMS = 3;
+
+    struct StreamState {
+        // Updated from stream callbacks
+        std::atomic<TimeType> last_message_time = 0;
+        std::atomic_bool is_failed = false;
+        // Updated from supervisor thread
+        ReconnectFunction reconnect;
+        TimeType outage_start = 0;  // 0 if the stream is healthy
+        TimeType reconnect_time = 0;
+        TimeType next_attempt_time = 0;
+        int n_attempts = 0;  // since the start of the outage
+    };
+
+    std::shared_ptr<spdlog::logger> m_logger;
+
+    // Parameters
+    const bool m_enabled;
+    const TimeType m_silence_timeout;  // in ns
+    const TimeType m_min_backoff;      // in ns
+    const TimeType m_max_backoff;      // in ns
+
+    std::array<StreamState, N_STREAMS> m_streams;
+
+    std::jthread m_thread;
+
+   public:
+    StreamSupervisor(const ConfigType& config, std::shared_ptr<spdlog::logger> logger);
+
+    void Register(StreamType type, ReconnectFunction reconnect);
+
+    void Start();
+
+    // Methods for stream callbacks
+    void OnMessage(StreamType type) {
+        m_streams[static_cast<int>(type)].last_message_time.store(TscClock::Now(), std::memory_order_relaxed);
+    }
+
+    void OnFailure(StreamType type);
+
+   private:
+    void Loop(std::stop_token stop_token);
+
+    void Check(StreamType type, TimeType now);
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <string>
+
+#include "constants.h"
+
+enum class ThreadRole {
+    MarketData,
+    Orders,
+    Strategy
+};
+
+const char* ThreadRoleName(ThreadRole role);
+
+// runner.threading section of the config (optional)
+class ThreadingConfig {
+   public:
+    // -1 => do not pin
+    int market_data_cpu = -1;
+    int orders_cpu = -1;
+    int strategy_cpu = -1;
+    // 0 => keep SCHED_OTHER; > 0 => SCHED_FIFO with this priority
+    int realtime_priority = 0;
+    bool lock_memory = false;
+    bool prefault = false;
+
+    ThreadingConfig() = default;
+
+    explicit ThreadingConfig(const ConfigType& config);
+
+    [[nodiscard]] int GetCpu(ThreadRole role) const;
+};
+
+// Pin the calling thread and set its scheduling policy. Log the resulting placement
+void ConfigureCurrentThread(const ThreadingConfig& config, ThreadRole role, std::shared_ptr<spdlog::logger> logger);
+
+// mlockall(MCL_CURRENT | MCL_FUTURE)
+void LockMemory(std::shared_ptr<spdlog::logger> logger);
+
+// Write every page of the range to take page faults at startup. Only before other threads access the range
+void Prefault(void* ptr, size_t size);
+
+// Touch the stack of the calling thread
+void PrefaultStack();
@@ -0,0 +1,4 @@
+#include "plugin.h"
+#include "strategies/grid_trading.h"
+
+HFT_STRATEGY_PLUGIN(GridTrading)
@@ -0,0 +1,67 @@
+#include "allocations.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Trivial type: no thread_local initialization inside operator new
+thread_local AllocationCounters t_counters;
+
+}  // namespace
+
+AllocationCounters GetThreadAllocations() {
+    return t_counters;
+}
+
+#ifdef HFT_TRACK_ALLOCATIONS
+
+namespace {
+
+void* Allocate(size_t size) {
+    ++t_counters.n_allocations;
+    t_counters.n_bytes += size;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* AllocateAligned(size_t size, std::align_val_t alignment) {
+    ++t_counters.n_allocations;
+    t_counters.n_bytes += size;
+    size_t align = static_cast<size_t>(alignment);
+    // aligned_alloc requires size to be a multiple of alignment
+    if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+}  // namespace
+
+void* operator new(size_t size) { return Allocate(size); }
+
+void* operator new[](size_t size) { return Allocate(size); }
+
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+#endif
@@ -0,0 +1,109 @@
+#include "backtest/load_generator.h"
+
+#include <thread>
+
+namespace {
+
+// Latencies kept per stream without a rate: the latest ones
+constexpr size_t MAX_UNPACED_LATENCIES = 1 << 20;
+
+double GetTicksPerSecond() {
+    return TscClock::GetFrequency() * 1e9;
+}
+
+}  // namespace
+
+LoadTestConfig::LoadTestConfig(const ConfigType& config)
+    : duration_s(config["duration_s"].as<double>(10)),
+      orderbook_rate(config["orderbook_rate"].as<double>(100'000)),
+      trade_rate(config["trade_rate"].as<double>(30'000)),
+      burst_size(config["burst_size"].as<size_t>(1)) {
+    assert(duration_s > 0);
+    assert(orderbook_rate >= 0 && trade_rate >= 0);
+    assert(burst_size >= 1);
+}
+
+LoadGenerator::LoadGenerator(Runner& runner, const ConfigType& config)
+    : m_runner(runner),
+      m_config(config),
+      m_load(config) {}
+
+LoadTestStats LoadGenerator::RunInProcess() {
+    assert(m_runner.GetMode() == RunnerMode::Backtest);
+    m_runner.StartBacktest();
+
+    // Both streams start at the same time after the threads are created
+    LoadTestStats stats;
+    const int depth = m_runner.GetMarketConnector().GetOrderBook().depth;
+    const ConfigType synthetic_config = m_config["synthetic"] ? m_config["synthetic"] : ConfigType();
+    SyntheticMarket orderbook_market(m_runner.GetInstrument(), depth, synthetic_config);
+    SyntheticMarket trades_market(m_runner.GetInstrument(), depth, synthetic_config);
+    const TscClock::TicksType start = TscClock::Ticks() + static_cast<TscClock::TicksType>(GetTicksPerSecond() / 100);
+    const TscClock::TicksType end = start + static_cast<TscClock::TicksType>(m_load.duration_s * GetTicksPerSecond());
+    {
+        std::jthread orderbooks([&]() { Produce(orderbook_market, false, m_load.orderbook_rate, start, end, stats.orderbook_latencies); });
+        std::jthread trades([&]() { Produce(trades_market, true, m_load.trade_rate, start, end, stats.trade_latencies); });
+    }
+    stats.seconds = TscClock::TicksToNanoseconds(TscClock::Ticks() - start) / 1e9;
+    const MarketConnector& mkt = m_runner.GetMarketConnector();
+    stats.notifications = mkt.GetNotificationStats();
+    stats.orderbook_connector_latency = mkt.GetOrderBookLatency();
+    stats.trade_connector_latency = mkt.GetTradesLatency();
+    return stats;
+}
+
+LoadTestStats LoadGenerator::RunEndToEnd() {
+    assert(m_runner.GetMode() == RunnerMode::Live);
+    MarketConnector& mkt = m_runner.GetMarketConnector();
+    const TscClock::TicksType start = TscClock::Ticks();
+    mkt.Start();
+    std::this_thread::sleep_for(std::chrono::duration<double>(m_load.duration_s));
+
+    LoadTestStats stats;
+    LockGuard lock = m_runner.GetEventLock();
+    stats.seconds = TscClock::TicksToNanoseconds(TscClock::Ticks() - start) / 1e9;
+    stats.notifications = mkt.GetNotificationStats();
+    stats.orderbook_connector_latency = mkt.GetOrderBookLatency();
+    stats.trade_connector_latency = mkt.GetTradesLatency();
+    return stats;
+}
+
+void LoadGenerator::Produce(SyntheticMarket& market, bool is_trades, double rate, TscClock::TicksType start, TscClock::TicksType end, std::vector<int64_t>& latencies) {
+    MarketConnector& mkt = m_runner.GetMarketConnector();
+    MarketDataResponse response;
+    // Bursts of burst_size messages keep the average rate
+    const double ticks_per_burst = rate > 0 ? m_load.burst_size / rate * GetTicksPerSecond() : 0;
+    // No reallocation while the stream runs: the rate bounds the number of messages (with the last burst)
+    const size_t capacity = rate > 0 ? static_cast<size_t>(rate * m_load.duration_s) + m_load.burst_size : MAX_UNPACED_LATENCIES;
+    latencies.reserve(capacity);
+
+    while (TscClock::Ticks() < start) {
+    }
+    for (size_t i = 0;; ++i) {
+        // Latency is measured from the scheduled time: delays of the previous messages are included
+        TscClock::TicksType scheduled = rate > 0 ? start + static_cast<TscClock::TicksType>(static_cast<double>(i / m_load.burst_size) * ticks_per_burst) : TscClock::Ticks();
+        if (scheduled >= end) {
+            break;
+        }
+        // Prepare the message before its send time
+        TimeType time = TscClock::TicksToTime(scheduled);
+        if (is_trades) {
+            market.FillTrade(response, time);
+        } else {
+            market.FillOrderBook(response, time);
+        }
+        while (TscClock::Ticks() < scheduled) {
+        }
+        if (is_trades) {
+            mkt.TradeStreamCallBack(&response, current_time());
+        } else {
+            mkt.OrderBookStreamCallBack(&response, current_time());
+        }
+        const int64_t latency = TscClock::TicksToNanoseconds(TscClock::Ticks() - scheduled);
+        if (latencies.size() < capacity) {
+            latencies.push_back(latency);
+        } else {
+            latencies[i % capacity] = latency;
+        }
+    }
+}
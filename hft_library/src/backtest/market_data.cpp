@@ -0,0 +1,157 @@
+#include "backtest/market_data.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> SplitLine(const std::string& line) {
+    std::vector<std::string> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+// Read lines of the log file with the CSV header
+class CsvReader {
+    std::ifstream m_file;
+    std::string m_line;
+
+   public:
+    std::vector<std::string> header;
+
+    explicit CsvReader(const std::string& path) : m_file(path) {
+        if (!m_file.is_open() || !std::getline(m_file, m_line)) {
+            throw std::runtime_error("Failed to read " + path);
+        }
+        header = SplitLine(m_line);
+    }
+
+    std::optional<std::vector<std::string>> Next() {
+        if (!std::getline(m_file, m_line) || m_line.empty()) {
+            return std::nullopt;
+        }
+        return SplitLine(m_line);
+    }
+};
+
+}  // namespace
+
+MarketDataFile::MarketDataFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error("Invalid market data file " + path);
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Failed to mmap " + path + ": " + std::strerror(errno));
+    }
+    m_header = static_cast<const Header*>(data);
+    m_records = static_cast<const char*>(data) + sizeof(Header);
+    m_record_size = GetRecordSize(m_header->depth);
+
+    // Validate the header
+    if (std::memcmp(m_header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        sizeof(Header) + Size() * m_record_size != m_size) {
+        munmap(data, m_size);
+        throw std::runtime_error("Invalid market data file " + path);
+    }
+}
+
+MarketDataFile::~MarketDataFile() {
+    munmap(const_cast<Header*>(m_header), m_size);
+}
+
+size_t MarketDataFile::GetRecordSize(int depth) {
+    return sizeof(Record) + 4 * static_cast<size_t>(depth) * sizeof(int32_t);
+}
+
+size_t MarketDataFile::Convert(const std::string& orderbook_path, const std::string& trades_path, const std::string& output_path) {
+    // orderbook.txt: strategy_time,exchange_time,bid_px_0,bid_qty_0,ask_px_0,ask_qty_0,...
+    CsvReader orderbook_reader(orderbook_path);
+    assert(orderbook_reader.header.size() > 2 && (orderbook_reader.header.size() - 2) % 4 == 0);
+    const int depth = static_cast<int>(orderbook_reader.header.size() - 2) / 4;
+    // trades.txt: strategy_time,exchange_time,direction,px,qty
+    CsvReader trades_reader(trades_path);
+    assert(trades_reader.header.size() == 5);
+
+    std::ofstream output(output_path, std::ios::binary);
+    if (!output.is_open()) {
+        throw std::runtime_error("Failed to create " + output_path);
+    }
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.depth = depth;
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<char> buffer(GetRecordSize(depth));
+    auto write_orderbook = [&](const std::vector<std::string>& fields) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        Record& record = *reinterpret_cast<Record*>(buffer.data());
+        record.receive_time = std::stoll(fields[0]);
+        record.exchange_time = std::stoll(fields[1]);
+        record.type = RecordType::OrderBook;
+        int32_t* levels = reinterpret_cast<int32_t*>(buffer.data() + sizeof(Record));
+        for (int i = 0; i < depth; ++i) {
+            levels[i] = std::stoi(fields[2 + 4 * i]);
+            levels[depth + i] = std::stoi(fields[3 + 4 * i]);
+            levels[2 * depth + i] = std::stoi(fields[4 + 4 * i]);
+            levels[3 * depth + i] = std::stoi(fields[5 + 4 * i]);
+        }
+        output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    };
+    auto write_trade = [&](const std::vector<std::string>& fields) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        Record& record = *reinterpret_cast<Record*>(buffer.data());
+        record.receive_time = std::stoll(fields[0]);
+        record.exchange_time = std::stoll(fields[1]);
+        record.type = RecordType::Trade;
+        assert(fields[2] == "Buy" || fields[2] == "Sell");
+        record.direction = fields[2] == "Buy" ? 1 : -1;
+        record.px = std::stoi(fields[3]);
+        record.qty = std::stoi(fields[4]);
+        output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    };
+
+    // Merge both logs by receive time
+    auto orderbook = orderbook_reader.Next();
+    auto trade = trades_reader.Next();
+    while (orderbook || trade) {
+        if (orderbook && (!trade || std::stoll((*orderbook)[0]) <= std::stoll((*trade)[0]))) {
+            write_orderbook(*orderbook);
+            orderbook = orderbook_reader.Next();
+        } else {
+            write_trade(*trade);
+            trade = trades_reader.Next();
+        }
+        ++header.n_records;
+    }
+
+    // Write the number of records
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!output.good()) {
+        throw std::runtime_error("Failed to write " + output_path);
+    }
+    return static_cast<size_t>(header.n_records);
+}
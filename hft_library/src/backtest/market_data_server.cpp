@@ -0,0 +1,182 @@
+#include "backtest/market_data_server.h"
+
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#include "backtest/load_generator.h"
+#include "backtest/synthetic_market.h"
+#include "instruments.grpc.pb.h"
+#include "marketdata.grpc.pb.h"
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+}  // namespace
+
+class MarketDataStreamServiceImpl final : public MarketDataStreamService::Service {
+   private:
+    const Instrument& m_instrument;
+    const LoadTestConfig m_load;
+    // YAML nodes are not thread-safe: the streams are served by different threads
+    std::mutex m_config_mutex;
+    const ConfigType m_synthetic_config;
+
+   public:
+    MarketDataStreamServiceImpl(const Instrument& instrument, const ConfigType& config)
+        : m_instrument(instrument),
+          m_load(config),
+          m_synthetic_config(config["synthetic"] ? config["synthetic"] : ConfigType()) {}
+
+    grpc::Status MarketDataStream(grpc::ServerContext* context, grpc::ServerReaderWriter<MarketDataResponse, MarketDataRequest>* stream) override {
+        // One subscription per stream
+        MarketDataRequest request;
+        if (!stream->Read(&request)) {
+            return grpc::Status::OK;
+        }
+        const bool is_trades = request.has_subscribe_trades_request();
+        if (!is_trades && !request.has_subscribe_order_book_request()) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "Only orderbook and trades subscriptions are supported");
+        }
+        const int depth = is_trades ? 1 : request.subscribe_order_book_request().instruments(0).depth();
+        std::unique_ptr<SyntheticMarket> market;
+        {
+            std::lock_guard lock(m_config_mutex);
+            market = std::make_unique<SyntheticMarket>(m_instrument, depth, m_synthetic_config);
+        }
+        std::cout << "Subscribe " << (is_trades ? "trades" : "orderbook") << " (depth=" << depth << ")" << std::endl;
+
+        MarketDataResponse response;
+        if (is_trades) {
+            market->FillTradesSubscription(response);
+        } else {
+            market->FillOrderBookSubscription(response);
+        }
+        if (!stream->Write(response)) {
+            return grpc::Status::OK;
+        }
+
+        // Messages at the rate in bursts of burst_size
+        const double rate = is_trades ? m_load.trade_rate : m_load.orderbook_rate;
+        const auto burst_period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(rate > 0 ? m_load.burst_size / rate : 0));
+        auto next_burst = std::chrono::steady_clock::now();
+        auto next_ping = next_burst;
+        MarketDataResponse ping;
+        while (!context->IsCancelled()) {
+            while (std::chrono::steady_clock::now() < next_burst) {
+            }
+            next_burst += burst_period;
+            for (size_t i = 0; i < m_load.burst_size; ++i) {
+                if (is_trades) {
+                    market->FillTrade(response, current_time());
+                } else {
+                    market->FillOrderBook(response, current_time());
+                }
+                if (!stream->Write(response)) {
+                    return grpc::Status::OK;
+                }
+            }
+            if (std::chrono::steady_clock::now() >= next_ping) {
+                next_ping += std::chrono::seconds(1);
+                SyntheticMarket::FillPing(ping, current_time());
+                if (!stream->Write(ping)) {
+                    return grpc::Status::OK;
+                }
+            }
+        }
+        return grpc::Status::OK;
+    }
+};
+
+class InstrumentsServiceImpl final : public InstrumentsService::Service {
+   private:
+    const Instrument& m_instrument;
+    const int m_lot_size;
+    const double m_px_step;
+    const int m_trading_status;
+    const bool m_is_api_trade_available;
+    std::atomic_size_t m_n_requests = 0;
+
+   public:
+    InstrumentsServiceImpl(const Instrument& instrument, const ConfigType& config)
+        : m_instrument(instrument),
+          m_lot_size(config["lot_size"].as<int>(instrument.lot_size)),
+          m_px_step(config["px_step"].as<double>(instrument.px_step)),
+          m_trading_status(config["trading_status"].as<int>(SecurityTradingStatus::SECURITY_TRADING_STATUS_NORMAL_TRADING)),
+          m_is_api_trade_available(config["api_trade_available"].as<bool>(true)) {}
+
+    grpc::Status GetInstrumentBy(grpc::ServerContext* /*context*/, const InstrumentRequest* request, InstrumentResponse* response) override {
+        if (request->id_type() != InstrumentIdType::INSTRUMENT_ID_TYPE_FIGI || request->id() != m_instrument.figi) {
+            return grpc::Status(grpc::StatusCode::NOT_FOUND, "Only runner.figi is known");
+        }
+        std::cout << "GetInstrumentBy " << request->id() << std::endl;
+        ++m_n_requests;
+        auto* instrument = response->mutable_instrument();
+        instrument->set_figi(m_instrument.figi);
+        instrument->set_ticker("STANDIN");
+        instrument->set_class_code("TQBR");
+        instrument->set_currency("rub");
+        instrument->set_lot(m_lot_size);
+        const int64_t px_step_nano = std::llround(m_px_step * 1e9);
+        instrument->mutable_min_price_increment()->set_units(px_step_nano / 1'000'000'000);
+        instrument->mutable_min_price_increment()->set_nano(static_cast<int32_t>(px_step_nano % 1'000'000'000));
+        instrument->set_trading_status(static_cast<SecurityTradingStatus>(m_trading_status));
+        instrument->set_api_trade_available_flag(m_is_api_trade_available);
+        return grpc::Status::OK;
+    }
+
+    [[nodiscard]] size_t GetRequests() const { return m_n_requests; }
+};
+
+MarketDataServer::MarketDataServer(const ConfigType& config)
+    : m_instrument(
+          config["runner"]["figi"].as<std::string>(),
+          config["runner"]["lot_size"].as<int>(),
+          config["runner"]["px_step"].as<double>()),
+      m_address(config["load_test"]["server"]["address"].as<std::string>("0.0.0.0:50051")),
+      m_market_data_service(std::make_unique<MarketDataStreamServiceImpl>(m_instrument, config["load_test"])),
+      m_instruments_service(std::make_unique<InstrumentsServiceImpl>(m_instrument, config["load_test"]["instrument"] ? config["load_test"]["instrument"] : ConfigType())) {
+    const ConfigType& server_config = config["load_test"]["server"];
+    grpc::SslServerCredentialsOptions ssl_options;
+    ssl_options.pem_key_cert_pairs.push_back({ReadFile(server_config["key"].as<std::string>("server.key")), ReadFile(server_config["cert"].as<std::string>("server.crt"))});
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort(m_address, grpc::SslServerCredentials(ssl_options));
+    builder.RegisterService(m_market_data_service.get());
+    builder.RegisterService(m_instruments_service.get());
+    m_server = builder.BuildAndStart();
+    if (!m_server) {
+        throw std::runtime_error("Could not start the server on " + m_address);
+    }
+}
+
+MarketDataServer::~MarketDataServer() {
+    // Market data streams end when their contexts are cancelled
+    m_server->Shutdown(std::chrono::system_clock::now());
+}
+
+const std::string& MarketDataServer::GetAddress() const {
+    return m_address;
+}
+
+void MarketDataServer::Wait() {
+    m_server->Wait();
+}
+
+size_t MarketDataServer::GetInstrumentRequests() const {
+    return m_instruments_service->GetRequests();
+}
@@ -0,0 +1,41 @@
+#include "backtest/sweep_results.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// The layout is read by scripts/research/sweep_results.py
+static_assert(sizeof(SweepResultsFile::Header) == 24 && sizeof(SweepResultsFile::Record) == 48);
+
+void SweepResultsFile::Write(const std::string& path, const std::vector<std::string>& names, const std::vector<std::vector<int>>& parameters, const std::vector<Record>& results) {
+    assert(parameters.size() == results.size());
+    std::ofstream output(path, std::ios::binary);
+    if (!output.is_open()) {
+        throw std::runtime_error("Failed to create " + path);
+    }
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.n_parameters = static_cast<int32_t>(names.size());
+    header.n_results = static_cast<int64_t>(results.size());
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const std::string& name : names) {
+        if (name.size() >= NAME_SIZE) {
+            throw std::runtime_error("Parameter name is too long: " + name);
+        }
+        char buffer[NAME_SIZE] = {};
+        std::memcpy(buffer, name.data(), name.size());
+        output.write(buffer, sizeof(buffer));
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+        assert(parameters[i].size() == names.size());
+        for (int value : parameters[i]) {
+            const int32_t value32 = value;
+            output.write(reinterpret_cast<const char*>(&value32), sizeof(value32));
+        }
+        output.write(reinterpret_cast<const char*>(&results[i]), sizeof(Record));
+    }
+    if (!output) {
+        throw std::runtime_error("Failed to write " + path);
+    }
+}
@@ -0,0 +1,83 @@
+#include "backtest/synthetic_market.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+SyntheticMarket::SyntheticMarket(const Instrument& instrument, int depth, const ConfigType& config)
+    : m_instrument(instrument),
+      m_depth(depth),
+      m_px_step_nano(std::llround(instrument.px_step * 1e9)),
+      m_move_probability(config["move_probability"].as<double>(0.1)),
+      m_rng(config["seed"].as<uint64_t>(0)),
+      m_qty(1, config["max_qty"].as<int>(50)),
+      m_ask_px(config["start_px"].as<int>(10000)) {
+    assert(m_depth >= 1);
+    assert(m_ask_px > m_depth);
+}
+
+void SyntheticMarket::FillOrderBook(MarketDataResponse& response, TimeType time) {
+    // Random walk of the spread
+    double move = m_uniform(m_rng);
+    if (move < m_move_probability / 2) {
+        --m_ask_px;
+    } else if (move < m_move_probability) {
+        ++m_ask_px;
+    }
+    m_ask_px = std::max(m_ask_px, m_depth + 1);
+
+    OrderBook& order_book = *response.mutable_orderbook();
+    order_book.set_figi(m_instrument.figi);
+    order_book.set_depth(m_depth);
+    order_book.set_is_consistent(true);
+    SetTime(*order_book.mutable_time(), time);
+    // Cleared elements are reused by Add()
+    order_book.mutable_bids()->Clear();
+    order_book.mutable_asks()->Clear();
+    for (int i = 0; i < m_depth; ++i) {
+        Order& bid = *order_book.add_bids();
+        SetPx(*bid.mutable_price(), m_ask_px - 1 - i);
+        bid.set_quantity(m_qty(m_rng) * m_instrument.lot_size);
+        Order& ask = *order_book.add_asks();
+        SetPx(*ask.mutable_price(), m_ask_px + i);
+        ask.set_quantity(m_qty(m_rng) * m_instrument.lot_size);
+    }
+}
+
+void SyntheticMarket::FillTrade(MarketDataResponse& response, TimeType time) {
+    bool is_buy = m_uniform(m_rng) < 0.5;
+    Trade& trade = *response.mutable_trade();
+    trade.set_figi(m_instrument.figi);
+    trade.set_direction(is_buy ? TradeDirection::TRADE_DIRECTION_BUY : TradeDirection::TRADE_DIRECTION_SELL);
+    SetPx(*trade.mutable_price(), is_buy ? m_ask_px : m_ask_px - 1);
+    trade.set_quantity(m_qty(m_rng));
+    SetTime(*trade.mutable_time(), time);
+}
+
+void SyntheticMarket::FillOrderBookSubscription(MarketDataResponse& response) const {
+    OrderBookSubscription& subscription = *response.mutable_subscribe_order_book_response()->add_order_book_subscriptions();
+    subscription.set_figi(m_instrument.figi);
+    subscription.set_depth(m_depth);
+    subscription.set_subscription_status(SubscriptionStatus::SUBSCRIPTION_STATUS_SUCCESS);
+}
+
+void SyntheticMarket::FillTradesSubscription(MarketDataResponse& response) const {
+    TradeSubscription& subscription = *response.mutable_subscribe_trades_response()->add_trade_subscriptions();
+    subscription.set_figi(m_instrument.figi);
+    subscription.set_subscription_status(SubscriptionStatus::SUBSCRIPTION_STATUS_SUCCESS);
+}
+
+void SyntheticMarket::FillPing(MarketDataResponse& response, TimeType time) {
+    SetTime(*response.mutable_ping()->mutable_time(), time);
+}
+
+void SyntheticMarket::SetTime(google::protobuf::Timestamp& timestamp, TimeType time) {
+    timestamp.set_seconds(time / 1'000'000'000);
+    timestamp.set_nanos(static_cast<int32_t>(time % 1'000'000'000));
+}
+
+void SyntheticMarket::SetPx(Quotation& quotation, int px) const {
+    int64_t nano = px * m_px_step_nano;
+    quotation.set_units(nano / 1'000'000'000);
+    quotation.set_nano(static_cast<int32_t>(nano % 1'000'000'000));
+}
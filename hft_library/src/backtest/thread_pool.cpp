@@ -0,0 +1,95 @@
+#include "backtest/thread_pool.h"
+
+#include <cassert>
+
+WorkStealingPool::WorkStealingPool(size_t n_threads) {
+    if (n_threads == 0) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < n_threads; ++i) {
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < n_threads; ++i) {
+        m_workers.emplace_back([this, i](std::stop_token stop_token) { WorkerLoop(stop_token, i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    for (std::jthread& worker : m_workers) {
+        worker.request_stop();
+    }
+    // jthread joins on destruction
+}
+
+size_t WorkStealingPool::GetThreadsCount() const {
+    return m_workers.size();
+}
+
+void WorkStealingPool::Submit(Task task) {
+    WorkerQueue& queue = *m_queues[m_next_queue++ % m_queues.size()];
+    {
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        ++m_n_queued;
+        ++m_n_unfinished;
+    }
+    m_has_tasks.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+    std::unique_lock lock(m_mutex);
+    m_all_done.wait(lock, [this] { return m_n_unfinished == 0; });
+}
+
+void WorkStealingPool::WorkerLoop(std::stop_token stop_token, size_t index) {
+    while (true) {
+        {
+            // Reserve one of the queued tasks
+            std::unique_lock lock(m_mutex);
+            if (!m_has_tasks.wait(lock, stop_token, [this] { return m_n_queued > 0; })) {
+                return;  // stop is requested
+            }
+            --m_n_queued;
+        }
+        Task task;
+        while (!TryPop(index, task)) {
+            // The reserved task is being pushed or taken by another reserved worker
+            std::this_thread::yield();
+        }
+        task();  // tasks must not throw
+        {
+            std::lock_guard lock(m_mutex);
+            assert(m_n_unfinished > 0);
+            if (--m_n_unfinished == 0) {
+                m_all_done.notify_all();
+            }
+        }
+    }
+}
+
+bool WorkStealingPool::TryPop(size_t index, Task& task) {
+    // Own queue: newest task
+    {
+        WorkerQueue& queue = *m_queues[index];
+        std::lock_guard lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+    // Steal the oldest task from the other queues
+    for (size_t i = 1; i < m_queues.size(); ++i) {
+        WorkerQueue& queue = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,165 @@
+#include "backtest/virtual_exchange.h"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+
+void VirtualExchange::EnableQueueModel(const MarketOrderBook& order_book) {
+    m_queue_book = &order_book;
+}
+
+std::string VirtualExchange::PostOrder(int px, int qty, Direction direction) {
+    assert(qty > 0);
+    // Short ids fit into the small string buffer: no allocations
+    char buffer[16] = "v";
+    std::string order_id(buffer, std::to_chars(buffer + 1, buffer + sizeof(buffer), m_next_order_id++).ptr);
+    // Join the end of the queue of the visible level
+    int queue_ahead = 0;
+    if (m_queue_book) {
+        const bool is_bid = direction == Direction::Buy;
+        const int depth = m_queue_book->depth;
+        const MarketLevel* levels = is_bid ? m_queue_book->bid.begin() : m_queue_book->ask.begin();
+        for (int i = 0; i < depth && (is_bid ? levels[i].px >= px : levels[i].px <= px); ++i) {
+            if (levels[i].px == px) {
+                queue_ahead = levels[i].qty;
+                break;
+            }
+        }
+    }
+    m_orders.push_back(RestingOrder{.order_id = order_id, .direction = direction, .px = px, .qty = qty, .queue_ahead = queue_ahead});
+    ++m_stats.n_posts;
+    return order_id;
+}
+
+bool VirtualExchange::CancelOrder(const std::string& order_id) {
+    auto it = std::find_if(m_orders.begin(), m_orders.end(), [&order_id](const RestingOrder& order) { return order.order_id == order_id; });
+    if (it == m_orders.end()) {
+        return false;
+    }
+    m_orders.erase(it);
+    ++m_stats.n_cancels;
+    return true;
+}
+
+void VirtualExchange::OnOrderBook(const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty, int depth) {
+    if (m_queue_book) {
+        // Cancels ahead of us: the queue ahead is at most the level qty
+        for (RestingOrder& order : m_orders) {
+            if (order.queue_ahead == 0) {
+                continue;
+            }
+            const bool is_bid = order.direction == Direction::Buy;
+            const int level_qty = is_bid ? GetLevelQty(bid_px, bid_qty, depth, order.px, true) : GetLevelQty(ask_px, ask_qty, depth, order.px, false);
+            if (level_qty != UNKNOWN_QTY) {
+                order.queue_ahead = std::min(order.queue_ahead, level_qty);
+            }
+        }
+    }
+    OnOrderBook(bid_px[0], ask_px[0]);
+}
+
+void VirtualExchange::OnOrderBook(int best_bid_px, int best_ask_px) {
+    m_best_bid_px = best_bid_px;
+    m_best_ask_px = best_ask_px;
+    m_trade_qty = 0;
+}
+
+void VirtualExchange::OnTrade(Direction direction, int px, int qty) {
+    m_trade_direction = direction;
+    m_trade_px = px;
+    m_trade_qty = qty;
+    if (m_queue_book) {
+        // The queue ahead of the passive orders at px is executed first
+        const Direction passive_direction = direction == Direction::Buy ? Direction::Sell : Direction::Buy;
+        for (RestingOrder& order : m_orders) {
+            if (order.direction != passive_direction || order.px != px) {
+                continue;
+            }
+            const int consumed = std::min(order.queue_ahead, qty);
+            order.queue_ahead -= consumed;
+            order.trade_fill_qty = qty - consumed;
+        }
+    }
+}
+
+bool VirtualExchange::NextFill(VirtualFill& fill) {
+    // Find the best priced executable order of the side of the earliest one: sides are matched in the order of posting
+    auto best = m_orders.end();
+    int best_qty = 0;
+    for (auto it = m_orders.begin(); it != m_orders.end(); ++it) {
+        int qty = GetExecutableQty(*it);
+        if (qty == 0) {
+            continue;
+        }
+        if (best == m_orders.end() || (it->direction == best->direction && static_cast<int>(it->direction) * (it->px - best->px) > 0)) {
+            best = it;
+            best_qty = qty;
+        }
+    }
+    if (best == m_orders.end()) {
+        return false;
+    }
+
+    // Consume the trade liquidity if the book does not cross the order
+    bool is_crossed = best->direction == Direction::Buy ? best->px >= m_best_ask_px : best->px <= m_best_bid_px;
+    if (!is_crossed) {
+        m_trade_qty -= best_qty;
+    }
+
+    fill = VirtualFill{.order_id = best->order_id, .direction = best->direction, .px = best->px, .qty = best_qty};
+    best->qty -= best_qty;
+    if (best->qty == 0) {
+        m_orders.erase(best);
+    }
+
+    // Update statistics
+    ++m_stats.n_fills;
+    m_stats.filled_qty += fill.qty;
+    m_stats.turnover += static_cast<int64_t>(fill.px) * fill.qty;
+    m_stats.inventory += static_cast<int>(fill.direction) * fill.qty;
+    m_stats.max_inventory = std::max(m_stats.max_inventory, std::abs(m_stats.inventory));
+    return true;
+}
+
+const VirtualExchangeStats& VirtualExchange::GetStats() const {
+    return m_stats;
+}
+
+int VirtualExchange::GetExecutableQty(const RestingOrder& order) const {
+    if (order.direction == Direction::Buy) {
+        if (order.px >= m_best_ask_px) {
+            return order.qty;
+        }
+        if (m_trade_qty > 0 && m_trade_direction == Direction::Sell && order.px >= m_trade_px) {
+            return std::min({order.qty, m_trade_qty, GetTradeFillQty(order)});
+        }
+    } else {
+        if (order.px <= m_best_bid_px) {
+            return order.qty;
+        }
+        if (m_trade_qty > 0 && m_trade_direction == Direction::Buy && order.px <= m_trade_px) {
+            return std::min({order.qty, m_trade_qty, GetTradeFillQty(order)});
+        }
+    }
+    return 0;
+}
+
+int VirtualExchange::GetTradeFillQty(const RestingOrder& order) const {
+    // A trade through our px has exhausted the queue of our level
+    if (!m_queue_book || order.px != m_trade_px) {
+        return order.qty;
+    }
+    return order.trade_fill_qty;
+}
+
+int VirtualExchange::GetLevelQty(const int* px, const int* qty, int depth, int target_px, bool is_bid) {
+    for (int i = 0; i < depth; ++i) {
+        if (px[i] == target_px) {
+            return qty[i];
+        }
+        if (is_bid ? px[i] < target_px : px[i] > target_px) {
+            return 0;
+        }
+    }
+    return UNKNOWN_QTY;
+}
@@ -0,0 +1,83 @@
+#include "backtest/wire_player.h"
+
+#include <thread>
+
+WirePlayer::WirePlayer(Runner& runner, const std::string& path, double speed)
+    : m_runner(runner),
+      m_reader(path),
+      m_speed(speed) {
+    assert(speed >= 0);
+}
+
+WirePlayerStats WirePlayer::Play() {
+    assert(m_runner.GetMode() == RunnerMode::Backtest);
+    m_runner.StartBacktest();
+    MarketConnector& mkt = m_runner.GetMarketConnector();
+
+    // Messages are reused
+    wire::RecordHeader header;
+    std::string payload;
+    MarketDataResponse market_data;
+
+    WirePlayerStats stats;
+    const auto start = std::chrono::steady_clock::now();
+    TimeType first_receive_time = 0;
+    while (m_reader.Next(header, payload)) {
+        if (m_speed > 0) {
+            // Keep the recorded intervals between the messages
+            if (first_receive_time == 0) {
+                first_receive_time = header.receive_time;
+            }
+            std::this_thread::sleep_until(start + std::chrono::nanoseconds(static_cast<int64_t>((header.receive_time - first_receive_time) / m_speed)));
+        }
+        bool is_parsed = true;
+        switch (header.stream) {
+            case WireStream::OrderBook:
+            case WireStream::Trades:
+                is_parsed = market_data.ParseFromString(payload);
+                if (!is_parsed) break;
+                MatchMarketData(market_data);
+                if (header.stream == WireStream::OrderBook) {
+                    mkt.OrderBookStreamCallBack(&market_data, header.receive_time);
+                } else {
+                    mkt.TradeStreamCallBack(&market_data, header.receive_time);
+                }
+                break;
+            case WireStream::Orders:
+            case WireStream::OrderState:
+                // Reports of the live orders: their ids are unknown to VirtualExchange, which reports our fills instead
+                ++stats.n_skipped;
+                continue;
+            default:
+                throw std::runtime_error(fmt::format("Unknown wire stream: {}", static_cast<int>(header.stream)));
+        }
+        if (!is_parsed) {
+            throw std::runtime_error(fmt::format("Corrupted {} message", WireStreamName(header.stream)));
+        }
+        // The strategy may post marketable orders
+        m_runner.ProcessVirtualFills();
+        ++stats.n_messages[static_cast<size_t>(header.stream)];
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+void WirePlayer::MatchMarketData(const MarketDataResponse& response) {
+    // Our resting orders are matched before the strategy sees the event
+    VirtualExchange& exchange = *m_runner.GetVirtualExchange();
+    const Instrument& instrument = m_runner.GetInstrument();
+    if (response.has_orderbook()) {
+        const OrderBook& order_book = response.orderbook();
+        if (order_book.bids_size() == 0 || order_book.asks_size() == 0) {
+            return;
+        }
+        exchange.OnOrderBook(instrument.QuotationToPx(order_book.bids(0).price()), instrument.QuotationToPx(order_book.asks(0).price()));
+    } else if (response.has_trade()) {
+        const Trade& trade = response.trade();
+        Direction direction = trade.direction() == TradeDirection::TRADE_DIRECTION_BUY ? Direction::Buy : Direction::Sell;
+        exchange.OnTrade(direction, instrument.QuotationToPx(trade.price()), static_cast<int>(trade.quantity()));
+    } else {
+        return;
+    }
+    m_runner.ProcessVirtualFills();
+}
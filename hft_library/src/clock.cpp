@@ -0,0 +1,113 @@
+#include "clock.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if HFT_HAS_TSC
+#include <cpuid.h>
+#endif
+
+namespace {
+
+struct ClockSample {
+    TscClock::TicksType ticks;
+    TimeType time;
+};
+
+TimeType SystemTime() {
+    auto duration_since_epoch = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration_since_epoch).count();
+}
+
+ClockSample TakeSample() {
+    // Take the pair with the smallest ticks window around system_clock::now()
+    constexpr int N_TRIES = 5;
+    ClockSample best{0, 0};
+    uint64_t best_window = UINT64_MAX;
+    for (int i = 0; i < N_TRIES; ++i) {
+        TscClock::TicksType before = TscClock::TicksOrdered();
+        TimeType time = SystemTime();
+        TscClock::TicksType after = TscClock::TicksOrdered();
+        if (after - before < best_window) {
+            best_window = after - before;
+            best = ClockSample{.ticks = before + (after - before) / 2, .time = time};
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+TscClock::TscClock() {
+    // Initial calibration: measure ticks frequency over a short period
+    ClockSample first = TakeSample();
+    std::this_thread::sleep_for(INITIAL_CALIBRATION_PERIOD);
+    ClockSample second = TakeSample();
+    double ns_per_tick = static_cast<double>(second.time - first.time) / static_cast<double>(second.ticks - first.ticks);
+    Publish(second.ticks, second.time, static_cast<uint64_t>(std::ldexp(ns_per_tick, MULT_SHIFT)));
+
+    // Recalibrate in background
+    m_thread = std::jthread([this](std::stop_token stop_token) { CalibrationLoop(stop_token); });
+}
+
+double TscClock::GetFrequency() {
+    return std::ldexp(1.0, MULT_SHIFT) / static_cast<double>(Instance().m_mult.load(std::memory_order_relaxed));
+}
+
+bool TscClock::IsInvariant() {
+#if HFT_HAS_TSC
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return edx & (1 << 8);
+#else
+    return false;
+#endif
+}
+
+void TscClock::Publish(TicksType base_ticks, TimeType base_time, uint64_t mult) {
+    // Single writer: the constructor and then the calibration thread
+    uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_base_ticks.store(base_ticks, std::memory_order_relaxed);
+    m_base_time.store(base_time, std::memory_order_relaxed);
+    m_mult.store(mult, std::memory_order_relaxed);
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void TscClock::CalibrationLoop(std::stop_token stop_token) {
+    ClockSample previous = TakeSample();
+    while (true) {
+        {
+            std::unique_lock lock(m_mutex);
+            if (m_cv.wait_for(lock, stop_token, CALIBRATION_PERIOD, [&stop_token] { return stop_token.stop_requested(); })) {
+                return;
+            }
+        }
+        ClockSample current = TakeSample();
+        if (current.ticks <= previous.ticks || current.time <= previous.time) {
+            // System clock was stepped back: keep the current calibration
+            previous = current;
+            continue;
+        }
+
+        // Ticks frequency over the last period
+        double ns_per_tick = static_cast<double>(current.time - previous.time) / static_cast<double>(current.ticks - previous.ticks);
+        previous = current;
+
+        // Continue from the current converted time to keep it monotonic
+        TimeType estimate = Convert(current.ticks);
+        TimeType error = current.time - estimate;
+        if (error > MAX_STEP) {
+            // Large positive error: step forward
+            Publish(current.ticks, current.time, static_cast<uint64_t>(std::ldexp(ns_per_tick, MULT_SHIFT)));
+            continue;
+        }
+        // Absorb the error over the next period by slewing the scale
+        double period_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(CALIBRATION_PERIOD).count());
+        double slew = std::clamp(static_cast<double>(error) / period_ns, -MAX_SLEW, MAX_SLEW);
+        Publish(current.ticks, estimate, static_cast<uint64_t>(std::ldexp(ns_per_tick * (1 + slew), MULT_SHIFT)));
+    }
+}
@@ -1,6 +1,7 @@
 #include "config.h"
 
 #include <yaml-cpp/yaml.h>
+#include <cassert>
 #include <iostream>
 #include <filesystem>
 
@@ -12,4 +13,12 @@ ConfigType read_config() {
         std::cout << "Current working directory: " << std::filesystem::current_path() << "\n";
         throw;
     }
+}
+
+ConfigType get_strategy_config(const ConfigType& config, int strategy_id) {
+    if (config["strategies"]) {
+        return config["strategies"][strategy_id];
+    }
+    assert(strategy_id == 0);
+    return config["strategy"];
 }
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "config_watcher.h"
+
+#include <yaml-cpp/yaml.h>
+
+#include <cassert>
+#include <utility>
+
+ConfigWatcher::Subscription::Subscription(ConfigWatcher* watcher, size_t id) : m_watcher(watcher), m_id(id) {}
+
+ConfigWatcher::Subscription::Subscription(Subscription&& other) noexcept : m_watcher(std::exchange(other.m_watcher, nullptr)), m_id(other.m_id) {}
+
+ConfigWatcher::Subscription& ConfigWatcher::Subscription::operator=(Subscription&& other) noexcept {
+    if (this != &other) {
+        if (m_watcher) {
+            m_watcher->Unsubscribe(m_id);
+        }
+        m_watcher = std::exchange(other.m_watcher, nullptr);
+        m_id = other.m_id;
+    }
+    return *this;
+}
+
+ConfigWatcher::Subscription::~Subscription() {
+    if (m_watcher) {
+        m_watcher->Unsubscribe(m_id);
+    }
+}
+
+ConfigWatcher::ConfigWatcher(const ConfigType& config, std::shared_ptr<spdlog::logger> logger)
+    : m_logger(std::move(logger)),
+      m_path(config["path"].as<std::string>(CONFIG_DIRECTORY)),
+      m_period(config["period_ms"].as<int>(1000)),
+      m_last_write_time(std::filesystem::last_write_time(m_path)) {
+    assert(m_period.count() > 0);
+}
+
+ConfigWatcher::Subscription ConfigWatcher::Subscribe(Callback callback) {
+    std::lock_guard lock(m_mutex);
+    m_callbacks[m_next_id] = std::move(callback);
+    return Subscription(this, m_next_id++);
+}
+
+void ConfigWatcher::Start() {
+    m_logger->info("Start ConfigWatcher: path={}; period={} ms; {} subscribers", m_path.string(), m_period.count(), m_callbacks.size());
+    m_thread = std::jthread([this](std::stop_token stop_token) { Loop(stop_token); });
+}
+
+void ConfigWatcher::Unsubscribe(size_t id) {
+    std::lock_guard lock(m_mutex);
+    m_callbacks.erase(id);
+}
+
+void ConfigWatcher::Loop(std::stop_token stop_token) {
+    while (true) {
+        {
+            // Nothing notifies the condition: the wait ends on the period or on stop
+            std::unique_lock lock(m_mutex);
+            m_stop_cv.wait_for(lock, stop_token, m_period, []() { return false; });
+        }
+        if (stop_token.stop_requested()) {
+            return;
+        }
+        std::error_code error;
+        std::filesystem::file_time_type write_time = std::filesystem::last_write_time(m_path, error);
+        if (error || write_time == m_last_write_time) {
+            // The file may be replaced by an editor right now
+            continue;
+        }
+        m_last_write_time = write_time;
+        Reload();
+    }
+}
+
+void ConfigWatcher::Reload() {
+    ConfigType config;
+    try {
+        config = YAML::LoadFile(m_path.string());
+    } catch (const YAML::Exception& e) {
+        m_logger->error("ConfigWatcher: could not parse {}: {}. Keep the current parameters", m_path.string(), e.what());
+        return;
+    }
+    ++m_n_reloads;
+    std::lock_guard lock(m_mutex);
+    int n_rejects = 0;
+    for (const auto& [id, callback] : m_callbacks) {
+        try {
+            callback(config);
+        } catch (const std::exception& e) {
+            m_logger->error("ConfigWatcher: subscriber {} rejected the config: {}", id, e.what());
+            ++n_rejects;
+        }
+    }
+    m_logger->info("ConfigWatcher: reload {} of {}: {} subscribers; {} rejects", m_n_reloads, m_path.string(), m_callbacks.size(), n_rejects);
+}
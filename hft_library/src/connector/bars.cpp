@@ -0,0 +1,53 @@
+#include "connector/bars.h"
+
+#include <algorithm>
+#include <cassert>
+
+BarSeries::BarSeries(TimeType resolution, size_t history) : resolution(resolution), m_closed(history) {
+    assert(resolution > 0);
+    assert(history > 0);
+}
+
+size_t BarSeries::Size() const {
+    return std::min(m_n_closed, m_closed.size());
+}
+
+const Bar& BarSeries::operator[](size_t i) const {
+    assert(i < Size());
+    return m_closed[(m_n_closed - 1 - i) % m_closed.size()];
+}
+
+const Bar* BarSeries::GetOpenBar() const {
+    return m_has_open_bar ? &m_open_bar : nullptr;
+}
+
+bool BarSeries::CloseBefore(TimeType time) {
+    if (!m_has_open_bar || time < m_open_bar.start_time + resolution) {
+        return false;
+    }
+    m_closed[m_n_closed % m_closed.size()] = m_open_bar;
+    ++m_n_closed;
+    m_has_open_bar = false;
+    return true;
+}
+
+void BarSeries::AddTrade(TimeType time, Direction direction, int px, int qty) {
+    if (!m_has_open_bar) {
+        TimeType start_time = time - time % resolution;
+        if (m_n_closed > 0) {
+            // Late trade after the close: the bars stay ordered
+            start_time = std::max(start_time, (*this)[0].start_time + resolution);
+        }
+        m_open_bar = Bar{.start_time = start_time, .open = px, .high = px, .low = px};
+        m_has_open_bar = true;
+    }
+    m_open_bar.high = std::max(m_open_bar.high, px);
+    m_open_bar.low = std::min(m_open_bar.low, px);
+    m_open_bar.close = px;
+    m_open_bar.volume += qty;
+    if (direction == Direction::Buy) {
+        m_open_bar.buy_volume += qty;
+    }
+    m_open_bar.turnover += static_cast<int64_t>(px) * qty;
+    ++m_open_bar.n_trades;
+}
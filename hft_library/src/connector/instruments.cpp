@@ -0,0 +1,173 @@
+#include "connector/instruments.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include "clock.h"
+#include "hft_library/third_party/TinkoffInvestSDK/services/instrumentsservice.h"
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = "HFTIN01";
+
+// Layout of the cache file
+struct CacheRecord {
+    char magic[8];
+    InstrumentMetadata metadata;
+};
+
+template <size_t N>
+void CopyString(char (&destination)[N], const std::string& source) {
+    std::memset(destination, 0, N);
+    std::strncpy(destination, source.c_str(), N - 1);
+}
+
+}  // namespace
+
+double InstrumentMetadata::GetPxStep() const {
+    return static_cast<double>(px_step_units) + px_step_nano / 1e9;
+}
+
+bool InstrumentMetadata::IsNormalTrading() const {
+    return trading_status == SecurityTradingStatus::SECURITY_TRADING_STATUS_NORMAL_TRADING;
+}
+
+std::ostream& operator<<(std::ostream& os, const InstrumentMetadata& metadata) {
+    os << "figi=" << metadata.figi << "; ticker=" << metadata.ticker << "; class_code=" << metadata.class_code << "; currency=" << metadata.currency
+       << "; lot_size=" << metadata.lot_size << "; px_step=" << metadata.GetPxStep() << "; trading_status=" << metadata.trading_status
+       << "; api_trade_available=" << metadata.is_api_trade_available << "; update_time=" << metadata.update_time;
+    return os;
+}
+
+InstrumentMetadataCache::InstrumentMetadataCache(const ConfigType& config, const std::string& figi, InvestApiClient* client, std::shared_ptr<spdlog::logger> logger)
+    : m_logger(std::move(logger)),
+      m_client(client),
+      m_path(std::filesystem::path(config["cache_directory"].as<std::string>("private/instruments")) / (figi + ".bin")),
+      m_max_age(static_cast<TimeType>(config["max_age_h"].as<int>(24)) * 3600 * 1'000'000'000),
+      m_fetch(config["fetch"].as<bool>(true) && client != nullptr) {
+    m_metadata = Load();
+    const bool is_fresh = m_metadata && current_time() - m_metadata->update_time <= m_max_age;
+    if (m_metadata) {
+        m_logger->info("InstrumentMetadataCache: loaded {} ({})", m_path.string(), is_fresh ? "fresh" : "old");
+    }
+    if (m_fetch && !is_fresh) {
+        // Cold start: the instrument is checked before any order
+        m_metadata = Fetch(figi);
+        Save(*m_metadata);
+        return;
+    }
+    m_is_from_cache = m_metadata.has_value();
+}
+
+void InstrumentMetadataCache::StartRefresh(const Instrument& instrument, std::function<void(const std::string& error)> on_mismatch) {
+    if (!m_fetch || !m_is_from_cache) {
+        return;
+    }
+    m_thread = std::jthread([this, instrument, on_mismatch = std::move(on_mismatch)]() {
+        InstrumentMetadata metadata;
+        try {
+            metadata = Fetch(instrument.figi);
+            Save(metadata);
+        } catch (const std::exception& e) {
+            m_logger->error("InstrumentMetadataCache: refresh failed: {}", e.what());
+            return;
+        } catch (const ServiceReply&) {
+            m_logger->error("InstrumentMetadataCache: refresh failed: InstrumentsService error");
+            return;
+        }
+        try {
+            CheckInstrument(instrument, metadata);
+        } catch (const std::runtime_error& e) {
+            m_logger->error("InstrumentMetadataCache: the cached metadata is out of date: {}", e.what());
+            on_mismatch(e.what());
+        }
+    });
+}
+
+void InstrumentMetadataCache::StopRefresh() {
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+std::optional<InstrumentMetadata> InstrumentMetadataCache::Load() const {
+    std::ifstream file(m_path, std::ios::binary);
+    CacheRecord record;
+    if (!file.read(reinterpret_cast<char*>(&record), sizeof(record)) || std::memcmp(record.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) {
+        return std::nullopt;
+    }
+    return record.metadata;
+}
+
+void InstrumentMetadataCache::Save(const InstrumentMetadata& metadata) const {
+    CacheRecord record{};
+    std::memcpy(record.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    record.metadata = metadata;
+    // Readers never see a partial file
+    std::filesystem::create_directories(m_path.parent_path());
+    std::filesystem::path tmp_path = m_path;
+    tmp_path += ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        if (!file) {
+            throw std::runtime_error("Could not write " + tmp_path.string());
+        }
+    }
+    std::filesystem::rename(tmp_path, m_path);
+}
+
+InstrumentMetadata InstrumentMetadataCache::Fetch(const std::string& figi) const {
+    TscClock::TicksType start_ticks = TscClock::Ticks();
+    auto instruments_service = std::dynamic_pointer_cast<Instruments>(m_client->service("instruments"));
+    ServiceReply reply = instruments_service->GetInstrumentBy(InstrumentIdType::INSTRUMENT_ID_TYPE_FIGI, "", figi);
+    const auto& instrument = ParseReply<InstrumentResponse>(reply, m_logger)->instrument();
+
+    InstrumentMetadata metadata{};
+    CopyString(metadata.figi, instrument.figi());
+    CopyString(metadata.ticker, instrument.ticker());
+    CopyString(metadata.class_code, instrument.class_code());
+    CopyString(metadata.currency, instrument.currency());
+    metadata.lot_size = instrument.lot();
+    metadata.trading_status = instrument.trading_status();
+    metadata.px_step_units = instrument.min_price_increment().units();
+    metadata.px_step_nano = instrument.min_price_increment().nano();
+    metadata.is_api_trade_available = instrument.api_trade_available_flag();
+    metadata.update_time = current_time();
+    m_logger->info("InstrumentMetadataCache: fetched in {} us: {}", TscClock::TicksToNanoseconds(TscClock::Ticks() - start_ticks) / 1000, metadata);
+    return metadata;
+}
+
+Instrument MakeInstrument(const ConfigType& config, const InstrumentMetadataCache* cache, const std::shared_ptr<spdlog::logger>& logger) {
+    const ConfigType& runner_config = config["runner"];
+    const std::optional<InstrumentMetadata> metadata = cache ? cache->Get() : std::nullopt;
+    if (!metadata && (!runner_config["lot_size"] || !runner_config["px_step"])) {
+        throw std::runtime_error("runner.lot_size and runner.px_step are required without instrument metadata");
+    }
+    Instrument instrument(
+        runner_config["figi"].as<std::string>(),
+        runner_config["lot_size"] ? runner_config["lot_size"].as<int>() : metadata->lot_size,
+        runner_config["px_step"] ? runner_config["px_step"].as<double>() : metadata->GetPxStep());
+    if (metadata) {
+        CheckInstrument(instrument, *metadata);
+        if (!metadata->IsNormalTrading() || !metadata->is_api_trade_available) {
+            logger->warn("Instrument {} is not available for trading: trading_status={}; api_trade_available={}", instrument.figi, metadata->trading_status, metadata->is_api_trade_available);
+        }
+    } else if (cache) {
+        logger->warn("Instrument {} is not checked: no metadata", instrument.figi);
+    }
+    return instrument;
+}
+
+void CheckInstrument(const Instrument& instrument, const InstrumentMetadata& metadata) {
+    if (instrument.figi != metadata.figi) {
+        throw std::runtime_error("Instrument metadata of figi " + std::string(metadata.figi) + " instead of " + instrument.figi);
+    }
+    if (instrument.lot_size != metadata.lot_size) {
+        throw std::runtime_error(fmt::format("runner.lot_size={} of {} differs from the lot of InstrumentsService: {}", instrument.lot_size, instrument.figi, metadata.lot_size));
+    }
+    if (std::abs(instrument.px_step - metadata.GetPxStep()) > 1e-9) {
+        throw std::runtime_error(fmt::format("runner.px_step={} of {} differs from min_price_increment of InstrumentsService: {}", instrument.px_step, instrument.figi, metadata.GetPxStep()));
+    }
+}
@@ -0,0 +1,70 @@
+#include "connector/ladder.h"
+
+namespace {
+
+// px of the first non-empty level (0 if the side is empty)
+int FindBestPx(const int* px, const int* qty, int depth) {
+    for (int i = 0; i < depth; ++i) {
+        if (qty[i] > 0) {
+            return px[i];
+        }
+    }
+    return 0;
+}
+
+}  // namespace
+
+PriceLadder::PriceLadder(int size, int depth)
+    : m_mask(size - 1),
+      m_bid_qty(size, 0),
+      m_ask_qty(size, 0) {
+    assert(size >= 2 && (size & m_mask) == 0 && "market.ladder_size must be a power of 2");
+    m_bid_pxs.reserve(depth);
+    m_ask_pxs.reserve(depth);
+}
+
+void PriceLadder::Update(const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty, int depth) {
+    assert(depth >= 1);
+    for (int px : m_bid_pxs) {
+        m_bid_qty[px & m_mask] = 0;
+    }
+    for (int px : m_ask_pxs) {
+        m_ask_qty[px & m_mask] = 0;
+    }
+    m_bid_pxs.clear();
+    m_ask_pxs.clear();
+
+    m_best_bid_px = FindBestPx(bid_px, bid_qty, depth);
+    m_best_ask_px = FindBestPx(ask_px, ask_qty, depth);
+    // Recenter the window when the best prices leave its middle half: O(1) as the cleared slots stay valid.
+    // A one-sided book is centered at its best px; an empty book keeps the window
+    if (m_best_bid_px != 0 || m_best_ask_px != 0) {
+        const int low_px = m_best_bid_px != 0 ? m_best_bid_px : m_best_ask_px;
+        const int high_px = m_best_ask_px != 0 ? m_best_ask_px : m_best_bid_px;
+        const int quarter = GetSize() / 4;
+        if (low_px - m_anchor < quarter || m_anchor + m_mask - high_px < quarter) {
+            m_anchor = (low_px + high_px) / 2 - GetSize() / 2;
+        }
+    }
+
+    SetLevels<true>(bid_px, bid_qty, depth);
+    SetLevels<false>(ask_px, ask_qty, depth);
+}
+
+template <bool IsBid>
+void PriceLadder::SetLevels(const int* px, const int* qty, int depth) {
+    std::vector<int>& slots = IsBid ? m_bid_qty : m_ask_qty;
+    std::vector<int>& pxs = IsBid ? m_bid_pxs : m_ask_pxs;
+    for (int i = 0; i < depth; ++i) {
+        // Empty levels of a thin book
+        if (qty[i] <= 0) {
+            continue;
+        }
+        if (!IsInWindow(px[i])) {
+            ++m_n_dropped_levels;
+            continue;
+        }
+        slots[px[i] & m_mask] = qty[i];
+        pxs.push_back(px[i]);
+    }
+}
@@ -0,0 +1,57 @@
+#include "connector/latency.h"
+
+#include <algorithm>
+#include <cassert>
+
+LatencyTracker::LatencyTracker() {
+    m_buffer.reserve(WINDOW);
+}
+
+void LatencyTracker::Add(TimeType exchange_time, TimeType receive_time) {
+    int64_t latency = receive_time - exchange_time;
+    size_t index = m_count++;
+    m_samples[index % WINDOW] = latency;
+
+    // Remove samples that left the window
+    if (m_min_queue_end > m_min_queue_begin && m_min_queue[m_min_queue_begin % WINDOW] + WINDOW <= index) {
+        ++m_min_queue_begin;
+    }
+    // Remove samples that are not smaller than the new one
+    while (m_min_queue_end > m_min_queue_begin && m_samples[m_min_queue[(m_min_queue_end - 1) % WINDOW] % WINDOW] >= latency) {
+        --m_min_queue_end;
+    }
+    m_min_queue[m_min_queue_end++ % WINDOW] = index;
+}
+
+bool LatencyTracker::Empty() const {
+    return m_count == 0;
+}
+
+size_t LatencyTracker::GetCount() const {
+    return m_count;
+}
+
+int64_t LatencyTracker::GetLast() const {
+    assert(!Empty());
+    return m_samples[(m_count - 1) % WINDOW];
+}
+
+int64_t LatencyTracker::GetMin() const {
+    assert(!Empty());
+    return m_samples[m_min_queue[m_min_queue_begin % WINDOW] % WINDOW];
+}
+
+int64_t LatencyTracker::GetPercentile(double q) const {
+    assert(!Empty());
+    assert(0 <= q && q <= 1);
+    size_t size = std::min(m_count, WINDOW);
+    m_buffer.assign(m_samples.begin(), m_samples.begin() + size);
+    auto nth = m_buffer.begin() + static_cast<size_t>(q * static_cast<double>(size - 1));
+    std::nth_element(m_buffer.begin(), nth, m_buffer.end());
+    return *nth;
+}
+
+int64_t LatencyTracker::GetSample(size_t index) const {
+    assert(index < m_count && index + WINDOW >= m_count);
+    return m_samples[index % WINDOW];
+}
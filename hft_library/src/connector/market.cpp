@@ -3,6 +3,7 @@
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 
 #include "connector/utils.h"
 #include "runner.h"
@@ -33,35 +34,16 @@ std::ostream& operator<<(std::ostream& os, const MarketOrderBook& ob) {
     os << "Asks\n";
     for (int i = 0; i < ob.depth; ++i) {
         os << '[' << std::setw(NUMBER_OF_SPACES_PER_NUMBER)
-           << ob.bid.px[i] << ' ' << std::setw(NUMBER_OF_SPACES_PER_NUMBER)
-           << ob.bid.qty[i] << "]  ";
+           << ob.bid[i].px << ' ' << std::setw(NUMBER_OF_SPACES_PER_NUMBER)
+           << ob.bid[i].qty << "]  ";
         os << '[' << std::setw(NUMBER_OF_SPACES_PER_NUMBER)
-           << ob.ask.px[i] << ' ' << std::setw(NUMBER_OF_SPACES_PER_NUMBER)
-           << ob.ask.qty[i] << "]\n";
+           << ob.ask[i].px << ' ' << std::setw(NUMBER_OF_SPACES_PER_NUMBER)
+           << ob.ask[i].qty << "]\n";
     }
     print_n_characters(os, '=', TOTAL_NUMBER_OF_SPACES_IN_LINE);
     return os;
 }
 
-template <bool IsBidParameter>
-OneSideMarketOrderBook<IsBidParameter>& MarketOrderBook::GetOneSideOrderBook() {
-    if constexpr (IsBidParameter) {
-        return bid;
-    } else {
-        return ask;
-    }
-}
-
-template <bool IsBidParameter>
-void MarketOrderBook::Update(const int* px, const int* qty) {
-    // TODO: Add OrderBook difference computation
-    OneSideMarketOrderBook<IsBidParameter>& order_book = GetOneSideOrderBook<IsBidParameter>();
-    for (int i = 0; i < depth; ++i) {
-        order_book.px[i] = px[i];
-        order_book.qty[i] = qty[i];  // already in lots
-    }
-}
-
 Trades::Trades(Instrument const& instrument) : m_instrument(instrument) {}
 
 std::ostream& operator<<(std::ostream& os, const Trades& trades) {
@@ -90,48 +72,165 @@ void Trades::Update(TimeType time, Direction direction, int px, int qty) {
 
 MarketConnector::MarketConnector(Runner& runner, const ConfigType& config)
     : m_runner(runner),
-      m_client(runner.GetClient()),
       m_logger(runner.GetLogger("market", false)),
       m_trades_logger(runner.GetLogger("trades", true)),
       m_orderbook_logger(runner.GetLogger("orderbook", true)),
+      m_bars_logger(runner.GetLogger("bars", true)),
       m_instrument(runner.GetInstrument()),
       m_order_book(m_instrument, config["market"]["depth"].as<int>()),
-      m_trades(m_instrument) {
+      m_ladder(config["market"]["ladder_size"].as<int>(DEFAULT_LADDER_SIZE), m_order_book.depth),
+      m_trades(m_instrument),
+      m_stale_latency(static_cast<TimeType>(config["market"]["stale_latency_ms"].as<int>(DEFAULT_STALE_LATENCY_MS)) * 1'000'000) {
+    InitOrderBook(OrderBookDepths{});
     m_trades_logger->info("strategy_time,exchange_time,direction,px,qty");
     std::string order_book_header = "strategy_time,exchange_time";
     for (size_t i = 0; i < m_order_book.depth; ++i) {
         order_book_header += fmt::format(",bid_px_{},bid_qty_{},ask_px_{},ask_qty_{}", i, i, i, i);
     }
     m_orderbook_logger->info(order_book_header);
+
+    // Bars: market.bar_resolutions_s (1s, 10s and 1m by default), market.bar_history closed bars of each
+    const std::vector<int> bar_resolutions = config["market"]["bar_resolutions_s"].as<std::vector<int>>(std::vector<int>{1, 10, 60});
+    const size_t bar_history = config["market"]["bar_history"].as<size_t>(DEFAULT_BAR_HISTORY);
+    m_bars.reserve(bar_resolutions.size());
+    for (int resolution : bar_resolutions) {
+        m_bars.emplace_back(static_cast<TimeType>(resolution) * 1'000'000'000, bar_history);
+    }
+    if (!config["market"]["bar_log"].as<bool>(false)) {
+        m_bars_logger->set_level(spdlog::level::off);
+    }
+    m_bars_logger->info("resolution_s,start_time,open,high,low,close,volume,buy_volume,turnover,n_trades");
 }
 
 const MarketOrderBook& MarketConnector::GetOrderBook() const { return m_order_book; }
 
+const PriceLadder& MarketConnector::GetLadder() const { return m_ladder; }
+
 const Trades& MarketConnector::GetTrades() const { return m_trades; }
 
+const std::vector<BarSeries>& MarketConnector::GetBars() const { return m_bars; }
+
+const LatencyTracker& MarketConnector::GetOrderBookLatency() const { return m_orderbook_latency; }
+
+const LatencyTracker& MarketConnector::GetTradesLatency() const { return m_trades_latency; }
+
+const LatencyTracker& MarketConnector::GetPingLatency() const { return m_ping_latency; }
+
+TimeType MarketConnector::GetClockOffset() const {
+    TimeType offset = std::numeric_limits<TimeType>::max();
+    for (const LatencyTracker* tracker : {&m_orderbook_latency, &m_trades_latency, &m_ping_latency}) {
+        if (!tracker->Empty()) {
+            offset = std::min(offset, tracker->GetMin());
+        }
+    }
+    return offset == std::numeric_limits<TimeType>::max() ? 0 : offset;
+}
+
+TimeType MarketConnector::GetFeedLatency() const {
+    return m_feed_latency;
+}
+
+TimeType MarketConnector::GetFeedSilence() const {
+    // Backtests replay the events without gaps in the strategy time
+    if (m_last_receive_time == 0 || m_runner.GetMode() == RunnerMode::Backtest) {
+        return 0;
+    }
+    return current_time() - m_last_receive_time;
+}
+
+bool MarketConnector::IsFeedStale() const {
+    // A silent feed has no sample to update m_is_feed_stale
+    return m_is_feed_stale || GetFeedSilence() > m_stale_latency;
+}
+
+const NotificationStats& MarketConnector::GetNotificationStats() const {
+    return m_notification_stats;
+}
+
 void MarketConnector::Start() {
     m_logger->info("Start MarketConnector");
 
+    StartupTimeline::Scope phase = m_runner.GetStartupTimeline().Measure("subscribe orderbook and trades");
     // Create MarketDataStream
-    m_market_data_stream = std::dynamic_pointer_cast<MarketDataStream>(m_client.service("marketdatastream"));
+    m_market_data_stream = std::dynamic_pointer_cast<MarketDataStream>(m_runner.GetClient().service("marketdatastream"));
+
+    SubscribeOrderBook();
+    SubscribeTrades();
+}
+
+void MarketConnector::StartBacktest() {
+    m_logger->info("Start MarketConnector (backtest)");
+    // Recorded data has no subscription responses: the connector is ready on the first orderbook
+    m_is_trade_stream_ready = true;
+}
 
-    // Subscribe OrderBookStream
+void MarketConnector::SubscribeOrderBook() {
+    // Messages from the previous subscriptions are ignored
+    int generation = ++m_orderbook_generation;
     m_market_data_stream->SubscribeOrderBookAsync(
         {m_instrument.figi},
         m_order_book.depth,
-        [this](ServiceReply reply) {
-            this->OrderBookStreamCallBack(ParseReply<MarketDataResponse>(reply, m_logger));
+        [this, generation](ServiceReply reply) {
+            if (generation != m_orderbook_generation) {
+                return;
+            }
+            TimeType receive_time = current_time();
+            m_runner.ConfigureStreamThread(ThreadRole::MarketData);
+            m_runner.GetSupervisor().OnMessage(StreamType::OrderBook);
+            try {
+                MarketDataResponse* response = ParseReply<MarketDataResponse>(reply, m_logger);
+                m_runner.ProcessStreamMessage(WireStream::OrderBook, receive_time, *response, [this, response, receive_time] {
+                    this->OrderBookStreamCallBack(response, receive_time);
+                });
+            } catch (const ServiceReply& failed_reply) {
+                m_runner.GetSupervisor().OnFailure(StreamType::OrderBook);
+            }
         });
+}
 
-    // Subscribe TradeStream
+void MarketConnector::SubscribeTrades() {
+    // Messages from the previous subscriptions are ignored
+    int generation = ++m_trades_generation;
     m_market_data_stream->SubscribeTradesAsync(
         {m_instrument.figi},
-        [this](ServiceReply reply) {
-            this->TradeStreamCallBack(ParseReply<MarketDataResponse>(reply, m_logger));
+        [this, generation](ServiceReply reply) {
+            if (generation != m_trades_generation) {
+                return;
+            }
+            TimeType receive_time = current_time();
+            m_runner.ConfigureStreamThread(ThreadRole::MarketData);
+            m_runner.GetSupervisor().OnMessage(StreamType::Trades);
+            try {
+                MarketDataResponse* response = ParseReply<MarketDataResponse>(reply, m_logger);
+                m_runner.ProcessStreamMessage(WireStream::Trades, receive_time, *response, [this, response, receive_time] {
+                    this->TradeStreamCallBack(response, receive_time);
+                });
+            } catch (const ServiceReply& failed_reply) {
+                m_runner.GetSupervisor().OnFailure(StreamType::Trades);
+            }
         });
 }
 
-void MarketConnector::OrderBookStreamCallBack(MarketDataResponse* response) {
+void MarketConnector::Reconnect(StreamType type) {
+    {
+        // Hold strategy notifications until the stream is ready again
+        LockGuard lock = m_runner.GetEventLock();
+        if (type == StreamType::OrderBook) {
+            m_is_order_book_stream_ready = false;
+        } else {
+            m_is_trade_stream_ready = false;
+        }
+        m_runner.OnMarketConnectorLost();
+    }
+    m_logger->warn("Resubscribe {}", StreamTypeName(type));
+    if (type == StreamType::OrderBook) {
+        SubscribeOrderBook();
+    } else {
+        SubscribeTrades();
+    }
+}
+
+void MarketConnector::OrderBookStreamCallBack(MarketDataResponse* response, TimeType receive_time) {
     if (response->has_subscribe_order_book_response()) {
         // Process Start of subscription
         const google::protobuf::RepeatedPtrField<OrderBookSubscription>& subscriptions = response->subscribe_order_book_response().order_book_subscriptions();
@@ -139,53 +238,28 @@ void MarketConnector::OrderBookStreamCallBack(MarketDataResponse* response) {
         assert(subscriptions[0].subscription_status() == SubscriptionStatus::SUBSCRIPTION_STATUS_SUCCESS);
         m_logger->info("OrderBookStream subscribe: success. depth={}", m_order_book.depth);
     } else if (response->has_orderbook()) {
-        LockGuard lock = m_runner.GetEventLock();
         // Process subscription message
         const OrderBook& order_book = response->orderbook();
         assert(order_book.depth() == m_order_book.depth);
         assert(order_book.figi() == m_instrument.figi);
-        // TODO: parse time
 
         // Parse bids and asks
-        int px[MAX_DEPTH];
-        int qty[MAX_DEPTH];
-        m_order_book.time = time_from_protobuf(order_book.time());
-
-        ParseLevels(order_book.bids(), px, qty);
-        m_order_book.Update<true>(px, qty);
-
-        ParseLevels(order_book.asks(), px, qty);
-        m_order_book.Update<false>(px, qty);
+        int bid_px[MAX_DEPTH];
+        int bid_qty[MAX_DEPTH];
+        int ask_px[MAX_DEPTH];
+        int ask_qty[MAX_DEPTH];
+        ParseLevels(order_book.bids(), bid_px, bid_qty);
+        ParseLevels(order_book.asks(), ask_px, ask_qty);
 
-        assert(m_order_book.bid.px[0] < m_order_book.ask.px[0]);
-
-        // Log the order book data
-        fmt::memory_buffer buf;
-        fmt::format_to(std::back_inserter(buf), "{},{}", current_time(), m_order_book.time);
-        for (size_t i = 0; i < m_order_book.depth; ++i) {
-            fmt::format_to(std::back_inserter(buf), ",{},{},{},{}", m_order_book.bid.px[i], m_order_book.bid.qty[i], m_order_book.ask.px[i], m_order_book.ask.qty[i]);
-        }
-        m_orderbook_logger->info("{}", fmt::to_string(buf));
-
-        if (!m_is_order_book_stream_ready) {
-            // Notify strategy about connector readiness
-            m_is_order_book_stream_ready = true;
-            if (this->IsReady()) m_runner.OnMarketConnectorReady();
-        } else {
-            // Notify strategy
-            if (lock.NotifyNow()) {
-                m_runner.OnOrderBookUpdate();
-            } else {
-                m_logger->info("Skip OrderBook notification: {} events pending", lock.GetNumberEventsPending());
-            }
-        }
+        m_runner.DispatchOrderBook(receive_time, time_from_protobuf(order_book.time()), bid_px, bid_qty, ask_px, ask_qty);
     } else {
         // Process ping
         assert(response->has_ping());
+        ProcessPing(response->ping(), receive_time);
     }
 }
 
-void MarketConnector::TradeStreamCallBack(MarketDataResponse* response) {
+void MarketConnector::TradeStreamCallBack(MarketDataResponse* response, TimeType receive_time) {
     if (response->has_subscribe_trades_response()) {
         // Process Start of subscription
         const google::protobuf::RepeatedPtrField<TradeSubscription>& subscriptions = response->subscribe_trades_response().trade_subscriptions();
@@ -193,34 +267,90 @@ void MarketConnector::TradeStreamCallBack(MarketDataResponse* response) {
         assert(subscriptions[0].subscription_status() == SubscriptionStatus::SUBSCRIPTION_STATUS_SUCCESS);
         m_logger->info("TradeStream subscribe: success");
         // Notify strategy about connector readiness
+        LockGuard lock = m_runner.GetEventLock();
         m_is_trade_stream_ready = true;
         if (this->IsReady()) m_runner.OnMarketConnectorReady();
     } else if (response->has_trade()) {
-        LockGuard lock = m_runner.GetEventLock();
         // Process subscription message
         const Trade& trade = response->trade();
         assert(trade.figi() == m_instrument.figi);
-        // TODO: parse time
 
         // Parse Trade
         const int direction = trade.direction();
         assert(direction == TradeDirection::TRADE_DIRECTION_BUY || direction == TradeDirection::TRADE_DIRECTION_SELL);
-        m_trades.Update(
+        m_runner.DispatchTrade(
+            receive_time,
             time_from_protobuf(trade.time()),
             direction == TradeDirection::TRADE_DIRECTION_BUY ? Direction::Buy : Direction::Sell,
             m_instrument.QuotationToPx(trade.price()),
             static_cast<int>(trade.quantity()));
-        m_trades_logger->info("{},{},{},{},{}", current_time(), m_trades.last_trade.time, m_trades.last_trade.direction, m_trades.last_trade.px, m_trades.last_trade.qty);
+    } else {
+        // Process ping
+        assert(response->has_ping());
+        ProcessPing(response->ping(), receive_time);
+    }
+}
+
+void MarketConnector::ProcessOrderBook(TimeType receive_time, TimeType exchange_time, const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty) {
+    LockGuard lock = m_runner.GetEventLock();
+    // Out-of-order and stale snapshots do not replace the book
+    if (!m_runner.GetSequencer().OnOrderBook(exchange_time, receive_time)) {
+        return;
+    }
+    m_order_book.time = exchange_time;
+    (this->*m_update_order_book)(bid_px, bid_qty, ask_px, ask_qty);
+    m_ladder.Update(bid_px, bid_qty, ask_px, ask_qty, m_order_book.depth);
+
+    assert(m_order_book.bid[0].px < m_order_book.ask[0].px);
+    OnLatencySample(m_orderbook_latency, m_order_book.time, receive_time);
+    // Bars close without waiting for the next trade
+    CloseBars(exchange_time);
+    m_runner.OnMarkToMarket(exchange_time);
 
+    // Log the order book data
+    if (m_orderbook_logger->should_log(spdlog::level::info)) {
+        fmt::memory_buffer buf;
+        fmt::format_to(std::back_inserter(buf), "{},{}", receive_time, m_order_book.time);
+        for (int i = 0; i < m_order_book.depth; ++i) {
+            fmt::format_to(std::back_inserter(buf), ",{},{},{},{}", m_order_book.bid[i].px, m_order_book.bid[i].qty, m_order_book.ask[i].px, m_order_book.ask[i].qty);
+        }
+        m_orderbook_logger->info("{}", std::string_view(buf.data(), buf.size()));
+    }
+
+    if (!m_is_order_book_stream_ready) {
+        // Notify strategy about connector readiness
+        m_is_order_book_stream_ready = true;
+        if (this->IsReady()) m_runner.OnMarketConnectorReady();
+    } else {
         // Notify strategy
+        ++m_notification_stats.n_orderbooks;
         if (lock.NotifyNow()) {
-            m_runner.OnTradesUpdate();
+            m_runner.OnOrderBookUpdate();
         } else {
-            m_logger->info("Skip Trades notification: {} events pending", lock.GetNumberEventsPending());
+            ++m_notification_stats.n_orderbook_skips;
+            m_logger->info("Skip OrderBook notification: {} events pending", lock.GetNumberEventsPending());
         }
+    }
+}
+
+void MarketConnector::ProcessTrade(TimeType receive_time, TimeType exchange_time, Direction direction, int px, int qty) {
+    LockGuard lock = m_runner.GetEventLock();
+    m_runner.GetSequencer().OnTrade(exchange_time, receive_time);
+    m_trades.Update(exchange_time, direction, px, qty);
+    CloseBars(exchange_time);
+    for (BarSeries& bars : m_bars) {
+        bars.AddTrade(exchange_time, direction, px, qty);
+    }
+    OnLatencySample(m_trades_latency, m_trades.last_trade.time, receive_time);
+    m_trades_logger->info("{},{},{},{},{}", receive_time, m_trades.last_trade.time, m_trades.last_trade.direction, m_trades.last_trade.px, m_trades.last_trade.qty);
+
+    // Notify strategy
+    ++m_notification_stats.n_trades;
+    if (lock.NotifyNow()) {
+        m_runner.OnTradesUpdate();
     } else {
-        // Process ping
-        assert(response->has_ping());
+        ++m_notification_stats.n_trade_skips;
+        m_logger->info("Skip Trades notification: {} events pending", lock.GetNumberEventsPending());
     }
 }
 
@@ -228,6 +358,61 @@ bool MarketConnector::IsReady() const {
     return m_is_order_book_stream_ready & m_is_trade_stream_ready;
 }
 
+void MarketConnector::ProcessPing(const Ping& ping, TimeType receive_time) {
+    LockGuard lock = m_runner.GetEventLock();
+    OnLatencySample(m_ping_latency, time_from_protobuf(ping.time()), receive_time);
+    m_runner.OnPingUpdate();
+}
+
+void MarketConnector::CloseBars(TimeType time) {
+    for (BarSeries& bars : m_bars) {
+        if (!bars.CloseBefore(time)) {
+            continue;
+        }
+        const Bar& bar = bars[0];
+        m_bars_logger->info("{},{},{},{},{},{},{},{},{},{}", bars.resolution / 1'000'000'000, bar.start_time, bar.open, bar.high, bar.low, bar.close, bar.volume, bar.buy_volume, bar.turnover, bar.n_trades);
+        m_runner.OnBarClosed(bars);
+    }
+}
+
+void MarketConnector::OnLatencySample(LatencyTracker& tracker, TimeType exchange_time, TimeType receive_time) {
+    tracker.Add(exchange_time, receive_time);
+    m_last_receive_time = receive_time;
+    m_feed_latency = tracker.GetLast() - GetClockOffset();
+
+    // Update feed state
+    bool is_feed_stale = m_feed_latency > m_stale_latency;
+    if (is_feed_stale != m_is_feed_stale) {
+        m_is_feed_stale = is_feed_stale;
+        if (is_feed_stale) {
+            m_logger->warn("Feed is stale: latency={} us > {} us", m_feed_latency / 1000, m_stale_latency / 1000);
+        } else {
+            m_logger->info("Feed is fresh: latency={} us", m_feed_latency / 1000);
+        }
+    }
+
+    if (++m_n_latency_samples % LATENCY_LOG_PERIOD == 0) {
+        LogLatency("periodic");
+    }
+}
+
+void MarketConnector::LogLatency(const char* reason) const {
+    // Skip formatting of the trackers if the logger is disabled
+    if (!m_logger->should_log(spdlog::level::info)) {
+        return;
+    }
+    auto format_tracker = [](const LatencyTracker& tracker) {
+        if (tracker.Empty()) {
+            return std::string("no samples");
+        }
+        return fmt::format("n={}; last={} us; min={} us; p50={} us; p99={} us", tracker.GetCount(), tracker.GetLast() / 1000, tracker.GetMin() / 1000, tracker.GetPercentile(0.5) / 1000, tracker.GetPercentile(0.99) / 1000);
+    };
+    m_logger->info("Latency ({}): clock_offset={} us; feed_latency={} us; stale={}", reason, GetClockOffset() / 1000, m_feed_latency / 1000, IsFeedStale());
+    m_logger->info("Latency OrderBook: {}", format_tracker(m_orderbook_latency));
+    m_logger->info("Latency Trades: {}", format_tracker(m_trades_latency));
+    m_logger->info("Latency Ping: {}", format_tracker(m_ping_latency));
+}
+
 void MarketConnector::ParseLevels(const google::protobuf::RepeatedPtrField<Order>& orders, int* px, int* qty) const {
     if (orders.size() == 0) {
         throw std::runtime_error("Empty orderbook. Probably, the trading session is closed");
@@ -238,4 +423,24 @@ void MarketConnector::ParseLevels(const google::protobuf::RepeatedPtrField<Order
         px[i] = m_instrument.QuotationToPx(order.price());
         qty[i] = static_cast<int>(order.quantity());
     }
-}
\ No newline at end of file
+}
+
+template <int... Depths>
+void MarketConnector::InitOrderBook(std::integer_sequence<int, Depths...>) {
+    bool is_supported = ((m_order_book.depth == Depths && (m_update_order_book = &MarketConnector::UpdateOrderBook<Depths>, true)) || ...);
+    if (!is_supported) {
+        throw std::runtime_error(fmt::format("Unsupported market.depth: {}", m_order_book.depth));
+    }
+    m_order_book.bid.m_levels = m_order_book_levels.bid.data();
+    m_order_book.ask.m_levels = m_order_book_levels.ask.data();
+}
+
+template <int Depth>
+void MarketConnector::UpdateOrderBook(const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty) {
+    // TODO: Add OrderBook difference computation
+    // Unrolled copy: qty is already in lots
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        ((m_order_book_levels.bid[I] = MarketLevel{bid_px[I], bid_qty[I]}), ...);
+        ((m_order_book_levels.ask[I] = MarketLevel{ask_px[I], ask_qty[I]}), ...);
+    }(std::make_index_sequence<Depth>{});
+}
@@ -0,0 +1,89 @@
+#include "connector/pnl.h"
+
+#include <cstdlib>
+
+PnLTracker::PnLTracker(const MarketOrderBook& order_book, std::shared_ptr<spdlog::logger> logger, const ConfigType& config)
+    : m_order_book(order_book),
+      m_logger(std::move(logger)),
+      m_fee_rate(config["fee_rate"].as<double>(0.0)),
+      m_sample_period(static_cast<TimeType>(config["sample_period_ms"].as<int>(1000)) * 1'000'000) {
+    assert(m_fee_rate >= 0);
+    assert(m_sample_period > 0);
+    m_logger->info("exchange_time,position,avg_px,mid_px,realized,unrealized,fees,total,turnover,volume,n_fills");
+}
+
+PnL PnLTracker::GetPnL() const {
+    PnL pnl{
+        .position = m_position,
+        .avg_px = m_position != m_unvalued_qty ? m_cost / (m_position - m_unvalued_qty) : 0,
+        .realized = m_realized,
+        .fees = m_fees,
+        .turnover = m_turnover,
+        .volume = m_volume,
+        .n_fills = m_n_fills};
+    if (HasMid()) {
+        pnl.mid_px = GetMid();
+        pnl.unrealized = (m_position - m_unvalued_qty) * pnl.mid_px - m_cost;
+        pnl.exposure = m_position * pnl.mid_px;
+    }
+    pnl.total = pnl.realized + pnl.unrealized - pnl.fees;
+    return pnl;
+}
+
+void PnLTracker::OnFill(Direction direction, int px, int qty) {
+    assert(qty > 0);
+    const int signed_qty = static_cast<int>(direction) * qty;
+    const int valued_position = m_position - m_unvalued_qty;
+    int opening_qty = qty;
+    if (static_cast<int64_t>(valued_position) * signed_qty < 0) {
+        // Close at the average cost
+        const int closing_qty = std::min(qty, std::abs(valued_position));
+        const double closed_cost = m_cost * closing_qty / std::abs(valued_position);
+        const int position_sign = valued_position > 0 ? 1 : -1;
+        m_realized += position_sign * static_cast<double>(closing_qty) * px - closed_cost;
+        m_cost -= closed_cost;
+        opening_qty -= closing_qty;
+    }
+    // Open (or flip) at the fill px
+    m_cost += static_cast<double>(direction) * opening_qty * px;
+    m_position += signed_qty;
+
+    m_fees += static_cast<double>(px) * qty * m_fee_rate;
+    m_turnover += static_cast<int64_t>(px) * qty;
+    m_volume += qty;
+    ++m_n_fills;
+}
+
+void PnLTracker::Reconcile(int qty) {
+    if (qty != m_position) {
+        m_unvalued_qty += qty - m_position;
+        m_position = qty;
+    }
+}
+
+void PnLTracker::OnOrderBook(TimeType time) {
+    if (m_unvalued_qty != 0 && HasMid()) {
+        m_cost += m_unvalued_qty * GetMid();
+        m_unvalued_qty = 0;
+    }
+    if (time >= m_next_sample_time) {
+        m_next_sample_time = time - time % m_sample_period + m_sample_period;
+        Log(time);
+    }
+}
+
+bool PnLTracker::HasMid() const {
+    return m_order_book.bid[0].px > 0 && m_order_book.ask[0].px > 0;
+}
+
+double PnLTracker::GetMid() const {
+    return (m_order_book.bid[0].px + m_order_book.ask[0].px) / 2.0;
+}
+
+void PnLTracker::Log(TimeType time) const {
+    if (!m_logger->should_log(spdlog::level::info)) {
+        return;
+    }
+    PnL pnl = GetPnL();
+    m_logger->info("{},{},{:.2f},{:.1f},{:.2f},{:.2f},{:.2f},{:.2f},{},{},{}", time, pnl.position, pnl.avg_px, pnl.mid_px, pnl.realized, pnl.unrealized, pnl.fees, pnl.total, pnl.turnover, pnl.volume, pnl.n_fills);
+}
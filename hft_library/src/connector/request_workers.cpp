@@ -0,0 +1,60 @@
+#include "connector/request_workers.h"
+
+#include <cassert>
+
+RequestWorkers::RequestWorkers(int n_threads) {
+    assert(n_threads >= 0);
+    m_threads.reserve(n_threads);
+    for (int i = 0; i < n_threads; ++i) {
+        m_threads.emplace_back([this](std::stop_token stop_token) { Loop(stop_token); });
+    }
+}
+
+RequestWorkers::~RequestWorkers() {
+    for (std::jthread& thread : m_threads) {
+        thread.request_stop();
+    }
+    m_threads.clear();
+}
+
+void RequestWorkers::RunBatch(size_t n, void (*call)(const void* job, size_t index), const void* job) {
+    std::unique_lock lock(m_mutex);
+    // A batch of another thread runs to completion first
+    m_done_cv.wait(lock, [this] { return !m_is_running; });
+    m_is_running = true;
+    m_call = call;
+    m_job = job;
+    m_n = n;
+    m_next = 0;
+    m_n_done = 0;
+    m_cv.notify_all();
+    // The calling thread takes its share
+    while (CallNext(lock)) {
+    }
+    m_done_cv.wait(lock, [this] { return m_n_done == m_n; });
+    m_is_running = false;
+    m_done_cv.notify_all();
+}
+
+bool RequestWorkers::CallNext(std::unique_lock<std::mutex>& lock) {
+    if (m_next == m_n) {
+        return false;
+    }
+    const size_t index = m_next++;
+    void (*call)(const void*, size_t) = m_call;
+    const void* job = m_job;
+    lock.unlock();
+    call(job, index);
+    lock.lock();
+    if (++m_n_done == m_n) {
+        m_done_cv.notify_all();
+    }
+    return true;
+}
+
+void RequestWorkers::Loop(std::stop_token stop_token) {
+    std::unique_lock lock(m_mutex);
+    while (m_cv.wait(lock, stop_token, [this] { return m_next < m_n; })) {
+        CallNext(lock);
+    }
+}
@@ -0,0 +1,104 @@
+#include "connector/sequencer.h"
+
+#include <algorithm>
+#include <iterator>
+
+const char* StreamAnomalyName(StreamAnomaly anomaly) {
+    switch (anomaly) {
+        case StreamAnomaly::OrderBookOutOfOrder:
+            return "OrderBookOutOfOrder";
+        case StreamAnomaly::OrderBookStale:
+            return "OrderBookStale";
+        case StreamAnomaly::TradeOutOfOrder:
+            return "TradeOutOfOrder";
+        case StreamAnomaly::FillDuplicate:
+            return "FillDuplicate";
+        case StreamAnomaly::BookBehindFill:
+            return "BookBehindFill";
+        case StreamAnomaly::Count:
+            break;
+    }
+    assert(false && "Unreachable");
+    return "";
+}
+
+StreamSequencer::StreamSequencer(const ConfigType& config, std::shared_ptr<spdlog::logger> logger)
+    : m_logger(std::move(logger)),
+      m_stale_book(static_cast<TimeType>(config["stale_book_ms"].as<int>(0)) * 1'000'000) {
+    assert(m_stale_book >= 0);
+}
+
+bool StreamSequencer::OnOrderBook(TimeType exchange_time, TimeType receive_time) {
+    const TimeType last_book_time = GetLast(StreamType::OrderBook).exchange_time;
+    if (exchange_time < last_book_time) {
+        Count(StreamAnomaly::OrderBookOutOfOrder, exchange_time, last_book_time);
+        return false;
+    }
+    if (m_stale_book > 0) {
+        const TimeType last_time = std::max(GetLast(StreamType::Trades).exchange_time, GetLast(StreamType::Orders).exchange_time);
+        if (exchange_time + m_stale_book < last_time) {
+            Count(StreamAnomaly::OrderBookStale, exchange_time, last_time);
+            return false;
+        }
+    }
+    Stamp(StreamType::OrderBook, exchange_time, receive_time);
+    return true;
+}
+
+void StreamSequencer::OnTrade(TimeType exchange_time, TimeType receive_time) {
+    const TimeType last_trade_time = GetLast(StreamType::Trades).exchange_time;
+    if (exchange_time < last_trade_time) {
+        Count(StreamAnomaly::TradeOutOfOrder, exchange_time, last_trade_time);
+    }
+    Stamp(StreamType::Trades, exchange_time, receive_time);
+}
+
+bool StreamSequencer::OnFill(std::string_view trade_id, TimeType exchange_time, TimeType receive_time) {
+    if (!MarkFill(trade_id)) {
+        Count(StreamAnomaly::FillDuplicate, exchange_time, GetLast(StreamType::Orders).exchange_time);
+        return false;
+    }
+    const TimeType book_time = GetLast(StreamType::OrderBook).exchange_time;
+    if (exchange_time > book_time) {
+        Count(StreamAnomaly::BookBehindFill, exchange_time, book_time);
+    }
+    Stamp(StreamType::Orders, exchange_time, receive_time);
+    return true;
+}
+
+bool StreamSequencer::MarkFill(std::string_view trade_id) {
+    if (trade_id.empty()) {
+        return true;
+    }
+    const size_t n_ids = std::min(m_n_fill_ids, FILL_IDS_CAPACITY);
+    if (std::find(m_fill_ids.begin(), m_fill_ids.begin() + n_ids, trade_id) != m_fill_ids.begin() + n_ids) {
+        return false;
+    }
+    m_fill_ids[m_n_fill_ids++ % FILL_IDS_CAPACITY] = trade_id;
+    return true;
+}
+
+void StreamSequencer::LogCounters() const {
+    std::string counters;
+    for (size_t i = 0; i < m_n_anomalies.size(); ++i) {
+        fmt::format_to(std::back_inserter(counters), "; {}={}", StreamAnomalyName(static_cast<StreamAnomaly>(i)), m_n_anomalies[i]);
+    }
+    m_logger->info("StreamSequencer: orderbooks={}; trades={}; fills={}{}", GetLast(StreamType::OrderBook).sequence, GetLast(StreamType::Trades).sequence, GetLast(StreamType::Orders).sequence, counters);
+}
+
+void StreamSequencer::Stamp(StreamType type, TimeType exchange_time, TimeType receive_time) {
+    StreamStamp& stamp = m_last[static_cast<size_t>(type)];
+    ++stamp.sequence;
+    stamp.merged_sequence = ++m_merged_sequence;
+    stamp.exchange_time = exchange_time;
+    stamp.receive_time = receive_time;
+}
+
+void StreamSequencer::Count(StreamAnomaly anomaly, TimeType exchange_time, TimeType last_time) {
+    ++m_n_anomalies[static_cast<size_t>(anomaly)];
+    // A fill usually arrives before the book that reflects it: counted only
+    if (anomaly == StreamAnomaly::BookBehindFill) {
+        return;
+    }
+    m_logger->info("StreamSequencer: {} (exchange_time={}; last_time={}; {} ms)", StreamAnomalyName(anomaly), exchange_time, last_time, (exchange_time - last_time) / 1'000'000);
+}
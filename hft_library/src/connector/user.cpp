@@ -1,17 +1,44 @@
 #include "connector/user.h"
 
+#include <future>
 #include <iomanip>
+#include <optional>
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
 
-#include "hft_library/third_party/TinkoffInvestSDK/services/operationsservice.h"
 #include "runner.h"
 
+std::ostream& operator<<(std::ostream& os, OrderStatus status) {
+    switch (status) {
+        case OrderStatus::PendingNew:
+            os << "PendingNew";
+            break;
+        case OrderStatus::Live:
+            os << "Live";
+            break;
+        case OrderStatus::PartiallyFilled:
+            os << "PartiallyFilled";
+            break;
+        case OrderStatus::PendingCancel:
+            os << "PendingCancel";
+            break;
+        case OrderStatus::Done:
+            os << "Done";
+            break;
+        default:
+            assert(false);
+    }
+    return os;
+}
+
 std::ostream& operator<<(std::ostream& os, const LimitOrder& order) {
     os << "Order "
        << order.order_id << ": "
        << order.direction << " ["
        << std::setw(NUMBER_OF_SPACES_PER_NUMBER) << order.qty
-       << std::setw(NUMBER_OF_SPACES_PER_NUMBER) << order.px << "]";
+       << std::setw(NUMBER_OF_SPACES_PER_NUMBER) << order.px << "] "
+       << order.status;
     return os;
 }
 
@@ -29,43 +56,88 @@ std::ostream& operator<<(std::ostream& os, const Positions& positions) {
     return os;
 }
 
-UserConnector::UserConnector(Runner& runner, const ConfigType& config)
+UserConnector::UserConnector(Runner& runner, const ConfigType& config, int n_strategies)
     : m_runner(runner),
-      m_client(runner.GetClient()),
       m_logger(runner.GetLogger("runner", false)),
       m_our_trades_logger(runner.GetLogger("our_trades", true)),
       m_positions_logger(runner.GetLogger("positions", true)),
       m_orders_logger(runner.GetLogger("orders", true)),
-      m_account_id(config["user"]["account_id"].as<std::string>()),
-      m_instrument(runner.GetInstrument()) {
+      m_account_id(runner.GetMode() == RunnerMode::Live ? config["user"]["account_id"].as<std::string>() : ""),
+      m_instrument(runner.GetInstrument()),
+      m_is_order_state_stream_enabled(runner.GetMode() == RunnerMode::Live && config["user"]["order_state_stream"].as<bool>(false)),
+      m_cancel_workers(runner.GetMode() == RunnerMode::Live ? std::make_unique<RequestWorkers>(config["user"]["cancel_threads"].as<int>(3)) : nullptr),
+      m_strategy_positions(n_strategies > 1 ? n_strategies : 0),
+      m_pnl(runner.GetMarketConnector().GetOrderBook(), runner.GetLogger("pnl", true), config["pnl"] ? config["pnl"] : ConfigType()) {
+    assert(n_strategies >= 1);
     m_our_trades_logger->info("internal_log_id,strategy_time,direction,order_id,executed_qty,px");
     m_positions_logger->info("internal_log_id,strategy_time,qty,money");
-    m_orders_logger->info("internal_log_id,strategy_time,order_id,direction,px,qty");
+    m_orders_logger->info("internal_log_id,strategy_time,event,order_id,direction,px,qty");
 }
 
 const Positions& UserConnector::GetPositions() const {
     return m_positions;
 }
 
+const Positions& UserConnector::GetPositions(int strategy_id) const {
+    return m_strategy_positions.empty() ? m_positions : m_strategy_positions[strategy_id];
+}
+
+int UserConnector::GetStrategyCount() const {
+    return m_strategy_positions.empty() ? 1 : static_cast<int>(m_strategy_positions.size());
+}
+
+size_t UserConnector::GetOrderCount() const {
+    size_t n_orders = 0;
+    for (int strategy_id = 0; strategy_id < GetStrategyCount(); ++strategy_id) {
+        n_orders += GetPositions(strategy_id).orders.size();
+    }
+    return n_orders;
+}
+
+const LatencyTracker& UserConnector::GetOrdersStreamLatency() const {
+    return m_orders_stream_latency;
+}
+
+const PnLTracker& UserConnector::GetPnL() const {
+    return m_pnl;
+}
+
+void UserConnector::MarkToMarket(TimeType exchange_time) {
+    m_pnl.OnOrderBook(exchange_time);
+}
+
 void UserConnector::Start() {
     m_logger->info("Start UserConnector");
+    StartupTimeline& startup = m_runner.GetStartupTimeline();
+
+    // Resolve services before the first request
+    m_operations_service = std::dynamic_pointer_cast<Operations>(m_runner.GetClient().service("operations"));
+    m_orders_stream = std::dynamic_pointer_cast<OrdersStream>(m_runner.GetClient().service("ordersstream"));
+    m_orders_service = std::dynamic_pointer_cast<Orders>(m_runner.GetClient().service("orders"));
+
+    // Subscribe OrderStream: it connects while the positions are fetched.
+    // No order rests at the start (checked below), so no trade precedes the positions
+    m_logger->info("Subscribe OrderStream");
+    {
+        StartupTimeline::Scope phase = startup.Measure("subscribe OrderStream");
+        SubscribeOrderStream();
+    }
+
+    // Warm up Orders with a read-only request concurrently with the positions: the first PostOrder does not pay for the setup of its calls
+    auto orders_reply_future = std::async(std::launch::async, [this, &startup] {
+        StartupTimeline::Scope phase = startup.Measure("warm up Orders (GetOrders)");
+        return m_orders_service->GetOrders(m_account_id);
+    });
 
     // Get Initial Positions
     m_logger->info("Get Positions");
-    auto operations = std::dynamic_pointer_cast<Operations>(m_client.service("operations"));
-    ServiceReply positions_reply = operations->GetPositions(m_account_id);
+    ServiceReply positions_reply = [this, &startup] {
+        StartupTimeline::Scope phase = startup.Measure("get positions");
+        return m_operations_service->GetPositions(m_account_id);
+    }();
     auto positions = ParseReply<PositionsResponse>(positions_reply, m_logger);
 
-    // Parse Money positions
-    const auto& money_positions = positions->money();
-    assert(money_positions.size() <= 1 && "Found multiple currency positions");
-    if (money_positions.empty()) {
-        m_positions.money = 0;
-    } else {
-        m_positions.money = m_instrument.MoneyValueToPx(money_positions[0]);
-    }
-
-    // Parse Money blocked positions
+    // Check Money blocked positions
     // TODO: add cancel orders
     if (!positions->blocked().empty()) {
         m_logger->error("Blocked money positions ({}): ", positions->blocked().size());
@@ -75,35 +147,312 @@ void UserConnector::Start() {
         assert(false && "Cancel Buy orders!");
     }
 
-    // Parse Securities positions
-    const auto& securities_positions = positions->securities();
-    for (const PositionsSecurities& security_position : securities_positions) {
+    // Check Securities blocked positions
+    for (const PositionsSecurities& security_position : positions->securities()) {
         assert(security_position.blocked() == 0 && "Cancel Sell orders!");
-        if (security_position.figi() == m_instrument.figi) {
-            m_positions.qty = static_cast<int>(security_position.balance());
+    }
+
+    // The warm-up only saves time of the first PostOrder: its failure does not stop the startup
+    ServiceReply orders_reply = orders_reply_future.get();
+    try {
+        auto orders = ParseReply<GetOrdersResponse>(orders_reply, m_logger);
+        if (!orders->orders().empty()) {
+            m_logger->warn("Orders at the start ({}) are not managed", orders->orders().size());
         }
+    } catch (const ServiceReply&) {
+        m_logger->warn("Warm up of Orders failed: orders at the start are not checked");
     }
 
-    m_logger->info("Subscribe OrderStream");
-    // Subscribe OrderStream
-    m_orders_stream = std::dynamic_pointer_cast<OrdersStream>(m_client.service("ordersstream"));
+    // OrderStream callbacks may already run
+    LockGuard lock = m_runner.GetEventLock();
+    ParsePositions(*positions);
+    AllocatePositions();
+
+    // TODO: check that stream is open
+    m_is_order_stream_ready = true;
+    m_runner.OnUserConnectorReady();
+}
+
+void UserConnector::StartBacktest(int money, int qty) {
+    m_logger->info("Start UserConnector (backtest): money={}; qty={}", money, qty);
+    m_positions.money = money;
+    m_positions.qty = qty;
+    m_pnl.Reconcile(qty);
+    AllocatePositions();
+
+    m_is_order_stream_ready = true;
+    m_runner.OnUserConnectorReady();
+}
+
+void UserConnector::SubscribeOrderStream() {
+    // Messages from the previous subscriptions are ignored
+    int generation = ++m_orders_stream_generation;
     m_orders_stream->TradesStreamAsync(
         {m_account_id},
-        [this](ServiceReply reply) { OrderStreamCallback(ParseReply<TradesStreamResponse>(reply, m_logger)); });
+        [this, generation](ServiceReply reply) {
+            if (generation != m_orders_stream_generation) {
+                return;
+            }
+            TimeType receive_time = current_time();
+            m_runner.ConfigureStreamThread(ThreadRole::Orders);
+            m_runner.GetSupervisor().OnMessage(StreamType::Orders);
+            try {
+                TradesStreamResponse* response = ParseReply<TradesStreamResponse>(reply, m_logger);
+                m_runner.ProcessStreamMessage(WireStream::Orders, receive_time, *response, [this, response, receive_time] {
+                    OrderStreamCallback(response, receive_time);
+                });
+            } catch (const ServiceReply& failed_reply) {
+                m_runner.GetSupervisor().OnFailure(StreamType::Orders);
+            }
+        });
+    if (!m_is_order_state_stream_enabled) {
+        return;
+    }
+    // Order states usually arrive before TradesStream reports
+    m_orders_stream->OrderStateStreamAsync(
+        {m_account_id},
+        [this, generation](ServiceReply reply) {
+            if (generation != m_orders_stream_generation) {
+                return;
+            }
+            TimeType receive_time = current_time();
+            m_runner.ConfigureStreamThread(ThreadRole::Orders);
+            m_runner.GetSupervisor().OnMessage(StreamType::Orders);
+            try {
+                OrderStateStreamResponse* response = ParseReply<OrderStateStreamResponse>(reply, m_logger);
+                m_runner.ProcessStreamMessage(WireStream::OrderState, receive_time, *response, [this, response, receive_time] {
+                    OrderStateStreamCallback(response, receive_time);
+                });
+            } catch (const ServiceReply& failed_reply) {
+                m_runner.GetSupervisor().OnFailure(StreamType::Orders);
+            }
+        });
+}
 
-    // Create orders service
-    m_orders_service = std::dynamic_pointer_cast<Orders>(m_client.service("orders"));
+template <typename Process>
+void UserConnector::ProcessMissedFills(const OrderState& order_state, Process process) {
+    LimitOrder* order = FindOrder(order_state.order_id());
+    // Qty that is not processed: bounds the trade ids that left the ring of the sequencer
+    int missed_qty = order ? static_cast<int>(order_state.lots_executed()) - order->executed_qty : 0;
+    StreamSequencer& sequencer = m_runner.GetSequencer();
+    for (const OrderStage& stage : order_state.stages()) {
+        // Known from now on: a redelivery by the stream is suppressed
+        if (!sequencer.MarkFill(stage.trade_id()) || missed_qty <= 0) {
+            continue;
+        }
+        const int qty = std::min(static_cast<int>(stage.quantity()), missed_qty);  // in lots
+        missed_qty -= qty;
+        process(*FindOrder(order_state.order_id()), m_instrument.MoneyValueToPx(stage.price()), qty);
+    }
+}
 
-    // TODO: check that stream is open
+void UserConnector::Reconnect() {
+    {
+        // Hold strategy notifications until orders and positions are resynchronized
+        LockGuard lock = m_runner.GetEventLock();
+        m_is_order_stream_ready = false;
+        // Unsubscribe: messages of the old subscription are ignored from here, the snapshot covers them
+        ++m_orders_stream_generation;
+        m_runner.OnUserConnectorLost();
+    }
+    Resync();
+    m_logger->warn("Resubscribe OrderStream");
+    SubscribeOrderStream();
+    ReconcileFills();
+
+    LockGuard lock = m_runner.GetEventLock();
     m_is_order_stream_ready = true;
     m_runner.OnUserConnectorReady();
 }
 
-const LimitOrder& UserConnector::PostOrder(int px, int qty, Direction direction) {
+void UserConnector::Resync() {
+    // Query orders and positions concurrently
+    m_logger->info("Resync orders and positions");
+    auto orders_reply_future = std::async(std::launch::async, [this] { return m_orders_service->GetOrders(m_account_id); });
+    ServiceReply positions_reply = m_operations_service->GetPositions(m_account_id);
+    ServiceReply orders_reply = orders_reply_future.get();
+    auto positions = ParseReply<PositionsResponse>(positions_reply, m_logger);
+    auto orders = ParseReply<GetOrdersResponse>(orders_reply, m_logger);
+    const std::vector<OrderState> done_order_states = FetchDoneOrderStates(*orders);
+
+    LockGuard lock = m_runner.GetEventLock();
+    int qty_old = m_positions.qty;
+    int money_old = m_positions.money;
+    size_t n_orders_old = GetOrderCount();
+
+    // The snapshot positions include the fills of the outage: only the owners, PnL and the strategies learn about them
+    int missed_qty = 0;
+    int missed_money = 0;
+    auto process_missed_fill = [this, &missed_qty, &missed_money](LimitOrder& order, int px, int qty) {
+        const int signed_qty = qty * (order.direction == Direction::Buy ? 1 : -1);
+        order.executed_qty += qty;
+        order.reported_qty += qty;
+        m_logger->warn("Fill during the outage: {} qty={}, px={}; {}", order.direction, qty, px, order);
+        m_our_trades_logger->info("{},{},{},{},{},{}", internal_log_id, current_time(), order.direction, order.order_id, qty, px);
+        if (!m_strategy_positions.empty()) {
+            m_strategy_positions[order.strategy_id].qty += signed_qty;
+            m_strategy_positions[order.strategy_id].money -= signed_qty * px;
+        }
+        m_pnl.OnFill(order.direction, px, qty);
+        missed_qty += signed_qty;
+        missed_money -= signed_qty * px;
+        // Delivered on readiness
+        m_runner.OnOurTrade(LimitOrder{.order_id = order.order_id, .direction = order.direction, .px = order.px, .qty = std::max(order.qty - qty, 0), .status = order.status, .strategy_id = order.strategy_id}, qty);
+    };
+    for (const OrderState& order_state : orders->orders()) {
+        ProcessMissedFills(order_state, process_missed_fill);
+    }
+    for (const OrderState& order_state : done_order_states) {
+        ProcessMissedFills(order_state, process_missed_fill);
+    }
+
+    ParsePositions(*positions);
+    ParseOrders(*orders);
+    ReconcileStrategyPositions(qty_old + missed_qty, money_old + missed_money);
+    m_logger->info("Resync: qty: {} -> {}; money: {} -> {}; orders: {} -> {}", qty_old, m_positions.qty, money_old, m_positions.money, n_orders_old, GetOrderCount());
+
+    // Log positions and orders after resync: the order set is replaced
+    m_positions_logger->info("{},{},{},{}", internal_log_id, current_time(), m_positions.qty, m_positions.money);
+    LogOrdersSnapshot();
+    FinishLogEvent();
+}
+
+void UserConnector::ReconcileFills() {
+    // The new stream may already deliver some of them: the trade ids decide
+    ServiceReply orders_reply = m_orders_service->GetOrders(m_account_id);
+    auto orders = ParseReply<GetOrdersResponse>(orders_reply, m_logger);
+    const std::vector<OrderState> done_order_states = FetchDoneOrderStates(*orders);
+
+    LockGuard lock = m_runner.GetEventLock();
+    auto process_missed_fill = [this, &lock](const LimitOrder& order, int px, int qty) {
+        m_logger->warn("Fill before the resubscribe: {} qty={}, px={}; {}", order.direction, qty, px, order);
+        ProcessExecution(lock, order.order_id, px, qty, order.direction);
+    };
+    for (const OrderState& order_state : orders->orders()) {
+        ProcessMissedFills(order_state, process_missed_fill);
+    }
+    for (const OrderState& order_state : done_order_states) {
+        ProcessMissedFills(order_state, process_missed_fill);
+    }
+}
+
+std::vector<OrderState> UserConnector::FetchDoneOrderStates(const GetOrdersResponse& orders) {
+    std::vector<std::string> done_order_ids;
+    {
+        LockGuard lock = m_runner.GetEventLock();
+        std::unordered_set<std::string> active_order_ids;
+        for (const OrderState& order_state : orders.orders()) {
+            active_order_ids.insert(order_state.order_id());
+        }
+        for (int strategy_id = 0; strategy_id < GetStrategyCount(); ++strategy_id) {
+            for (const auto& [order_id, order] : GetOwnerPositions(strategy_id).orders) {
+                if (!active_order_ids.contains(order_id)) {
+                    done_order_ids.push_back(order_id);
+                }
+            }
+        }
+    }
+    std::vector<OrderState> order_states;
+    for (const std::string& order_id : done_order_ids) {
+        try {
+            ServiceReply reply = m_orders_service->GetOrderState(m_account_id, order_id);
+            order_states.push_back(*ParseReply<OrderState>(reply, m_logger));
+        } catch (const ServiceReply& failed_reply) {
+            m_logger->warn("Could not get the state of the done order {}: its fills of the outage are only in the positions", order_id);
+        }
+    }
+    return order_states;
+}
+
+void UserConnector::ParsePositions(const PositionsResponse& positions) {
+    // Parse Money positions (blocked money belongs to our buy orders)
+    const auto& money_positions = positions.money();
+    assert(money_positions.size() <= 1 && "Found multiple currency positions");
+    m_positions.money = money_positions.empty() ? 0 : m_instrument.MoneyValueToPx(money_positions[0]);
+    for (const MoneyValue& blocked_positions : positions.blocked()) {
+        m_positions.money += m_instrument.MoneyValueToPx(blocked_positions);
+    }
+
+    // Parse Securities positions (blocked securities belong to our sell orders)
+    m_positions.qty = 0;
+    for (const PositionsSecurities& security_position : positions.securities()) {
+        if (security_position.figi() == m_instrument.figi) {
+            m_positions.qty = static_cast<int>(security_position.balance() + security_position.blocked());
+        }
+    }
+    m_pnl.Reconcile(m_positions.qty);
+}
+
+void UserConnector::ParseOrders(const GetOrdersResponse& orders) {
+    // Orders keep their owners across the resync; unknown orders belong to the first strategy
+    std::unordered_set<std::string> active_order_ids;
+    for (const OrderState& order_state : orders.orders()) {
+        active_order_ids.insert(order_state.order_id());
+    }
+    std::unordered_map<std::string, int> owners;
+    for (int strategy_id = 0; strategy_id < GetStrategyCount(); ++strategy_id) {
+        Positions& positions = GetOwnerPositions(strategy_id);
+        for (auto it = positions.orders.begin(); it != positions.orders.end();) {
+            auto next = std::next(it);
+            if (active_order_ids.contains(it->first)) {
+                owners.emplace(it->first, strategy_id);
+            } else {
+                // Done during the outage: late reports still find the order
+                RemoveOrder(positions, it);
+            }
+            it = next;
+        }
+        positions.orders.clear();
+        positions.open_buy_qty = 0;
+        positions.open_buy_notional = 0;
+        positions.open_sell_qty = 0;
+        positions.open_buy_qty_by_px.clear();
+        positions.open_sell_qty_by_px.clear();
+    }
+    m_positions.open_buy_qty = 0;
+    m_positions.open_buy_notional = 0;
+    m_positions.open_sell_qty = 0;
+    m_positions.open_buy_qty_by_px.clear();
+    m_positions.open_sell_qty_by_px.clear();
+    for (const OrderState& order_state : orders.orders()) {
+        if (order_state.figi() != m_instrument.figi) {
+            continue;
+        }
+        OrderExecutionReportStatus status = order_state.execution_report_status();
+        if (status != OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_NEW && status != OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_PARTIALLYFILL) {
+            continue;
+        }
+        assert(order_state.order_type() == OrderType::ORDER_TYPE_LIMIT);
+        auto owner_it = owners.find(order_state.order_id());
+        const int strategy_id = owner_it == owners.end() ? 0 : owner_it->second;
+        auto it = GetOwnerPositions(strategy_id).orders.emplace(
+            order_state.order_id(),
+            LimitOrder{
+                .order_id = order_state.order_id(),
+                .direction = order_state.direction() == OrderDirection::ORDER_DIRECTION_BUY ? Direction::Buy : Direction::Sell,
+                .px = m_instrument.MoneyValueToPx(order_state.initial_security_price()),
+                .qty = static_cast<int>(order_state.lots_requested() - order_state.lots_executed()),
+                .status = status == OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_NEW ? OrderStatus::Live : OrderStatus::PartiallyFilled,
+                // Executions before the resync are already in positions
+                .executed_qty = static_cast<int>(order_state.lots_executed()),
+                .reported_qty = static_cast<int>(order_state.lots_executed()),
+                .strategy_id = strategy_id});
+        UpdateOpenOrders(it.first->second, it.first->second.qty);
+    }
+}
+
+const LimitOrder& UserConnector::PostOrder(int px, int qty, Direction direction, int strategy_id) {
+    assert(0 <= strategy_id && strategy_id < GetStrategyCount());
+    if (VirtualExchange* virtual_exchange = m_runner.GetVirtualExchange()) {
+        // Executions are delivered by Runner::ProcessVirtualFills()
+        m_logger->info("PostOrder (virtual): {} qty={}, px={}", direction, qty, px);
+        return ProcessNewPostOrder(virtual_exchange->PostOrder(px, qty, direction), px, qty, direction, OrderStatus::Live, strategy_id);
+    }
     // Convert px to Tinkoff API px
     auto [units, nano] = m_instrument.PxToQuotation(px);
     // Send request
     m_logger->info("PostOrder: {} qty={}, px={}.{} ({})", direction, qty, units, nano, px);
+    TscClock::TicksType start_ticks = TscClock::Ticks();
     ServiceReply reply = m_orders_service->PostOrder(
         m_instrument.figi,
         qty,
@@ -115,7 +464,7 @@ const LimitOrder& UserConnector::PostOrder(int px, int qty, Direction direction)
         ""                            // empty idempotency key
     );
     auto response = ParseReply<PostOrderResponse>(reply, m_logger);
-    m_logger->info("PostOrder success");
+    m_logger->info("PostOrder success: {} us", TscClock::TicksToNanoseconds(TscClock::Ticks() - start_ticks) / 1000);
 
     // Do sanity check for response
     assert(response->lots_requested() == qty);
@@ -128,15 +477,29 @@ const LimitOrder& UserConnector::PostOrder(int px, int qty, Direction direction)
     const std::string& order_id = response->order_id();
     OrderExecutionReportStatus status = response->execution_report_status();
     if (status == OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_NEW) {
-        return ProcessNewPostOrder(order_id, px, qty, direction);
-    } else if (status == OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_PARTIALLYFILL) {
-        // TODO: implement market execution (it seems that this branch never happens)
-        assert(false && "Not implemented");
+        // With OrderStateStream the order waits for the exchange acknowledgement
+        return ProcessNewPostOrder(order_id, px, qty, direction, m_is_order_state_stream_enabled ? OrderStatus::PendingNew : OrderStatus::Live, strategy_id);
+    } else if (status == OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_PARTIALLYFILL ||
+               status == OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_FILL) {
+        // Lots executed on post are booked at the executed price: only the rest of the order rests.
+        // The trades of the streams that report them are not booked again
+        const int executed_qty = static_cast<int>(response->lots_executed());
+        const int executed_px = m_instrument.MoneyValueToPx(response->executed_order_price());
+        m_logger->info("Order {} is executed on post: lots_executed={}; px={}", order_id, executed_qty, executed_px);
+        ProcessNewPostOrder(order_id, px, qty, direction, OrderStatus::PartiallyFilled, strategy_id);
+        if (executed_qty > 0) {
+            FindOrder(order_id)->executed_qty = executed_qty;
+            // The owner learns about the fill after the notification that posts the order
+            m_runner.OnOurTrade(BookOurTrade(order_id, executed_px, executed_qty, direction), executed_qty);
+        }
+        // Done orders are kept: a filled order is returned as well
+        return *FindOrder(order_id);
     } else if (status == OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_REJECTED) {
-        // TODO: process errors (it seems that this branch never happens)
-        assert(false && "Not implemented");
+        m_logger->error("PostOrder rejected: {}", response->message());
+        throw OrderRejectedByExchange(response->message());
     } else {
         assert(false && "Unreachable");
+        throw OrderRejectedByExchange("Unexpected execution report status of PostOrder");
     }
 }
 
@@ -144,26 +507,139 @@ const LimitOrder& UserConnector::PostOrder(int px, int qty, Direction direction)
 
 void UserConnector::CancelOrder(const std::string& order_id) {
     // Check order existence
-    auto it = m_positions.orders.find(order_id);
-    assert(it != m_positions.orders.end());
+    Positions* owner = nullptr;
+    auto it = FindRestingOrder(order_id, owner);
+    assert(owner);
     // Send request
     m_logger->info("CancelOrder order_id={} {} qty={}, px={}", order_id, it->second.direction, it->second.qty, it->second.px * m_instrument.px_step);
+    if (VirtualExchange* virtual_exchange = m_runner.GetVirtualExchange()) {
+        // Executions are delivered immediately: the resting order is always on the exchange
+        [[maybe_unused]] bool is_cancelled = virtual_exchange->CancelOrder(order_id);
+        assert(is_cancelled);
+        RemoveOrder(*owner, it);
+        FinishLogEvent();
+        return;
+    }
+    OrderStatus status = it->second.status;
+    it->second.status = OrderStatus::PendingCancel;
+    TscClock::TicksType start_ticks = TscClock::Ticks();
     ServiceReply reply = m_orders_service->CancelOrder(
         m_account_id,
         order_id);
     // Check for errors
-    auto response = ParseReply<CancelOrderResponse>(reply, m_logger);
+    try {
+        ParseReply<CancelOrderResponse>(reply, m_logger);
+    } catch (const ServiceReply& failed_reply) {
+        it->second.status = status;
+        throw;
+    }
 
     // Remove the order if no errors occured
-    m_positions.orders.erase(it);
+    RemoveOrder(*owner, it);
 
     // TODO: parse response->time()
     // Log Orders
-    LogOrders();
-    m_logger->info("CancelOrder success");
+    FinishLogEvent();
+    m_logger->info("CancelOrder success: {} us", TscClock::TicksToNanoseconds(TscClock::Ticks() - start_ticks) / 1000);
 }
 
-void UserConnector::OrderStreamCallback(TradesStreamResponse* response) {
+void UserConnector::CancelOrders(const std::vector<std::string>& order_ids, std::vector<std::exception_ptr>& errors) {
+    assert(order_ids.size() == errors.size());
+    if (m_runner.GetVirtualExchange()) {
+        for (size_t i = 0; i < order_ids.size(); ++i) {
+            try {
+                CancelOrder(order_ids[i]);
+            } catch (const ServiceReply& reply) {
+                errors[i] = std::current_exception();
+            }
+        }
+        return;
+    }
+    m_logger->info("CancelOrders: {} orders", order_ids.size());
+    TscClock::TicksType start_ticks = TscClock::Ticks();
+    std::vector<OrderStatus> statuses = MarkPendingCancel(order_ids);
+    std::vector<std::optional<ServiceReply>> replies(order_ids.size());
+    m_runner.RunWithoutEventLock([&] { SendCancels(order_ids, replies, errors); });
+    ProcessCancelReplies(order_ids, statuses, replies, errors);
+    m_logger->info("CancelOrders success: {} orders in {} us", order_ids.size(), TscClock::TicksToNanoseconds(TscClock::Ticks() - start_ticks) / 1000);
+}
+
+void UserConnector::CancelAllOrders(std::vector<std::string>& order_ids, std::vector<std::exception_ptr>& errors) {
+    std::vector<OrderStatus> statuses;
+    {
+        LockGuard lock = m_runner.GetEventLock();
+        order_ids.clear();
+        for (int strategy_id = 0; strategy_id < GetStrategyCount(); ++strategy_id) {
+            for (const auto& [order_id, order] : GetPositions(strategy_id).orders) {
+                order_ids.push_back(order_id);
+            }
+        }
+        errors.assign(order_ids.size(), nullptr);
+        m_logger->info("CancelAllOrders: {} orders", order_ids.size());
+        if (m_runner.GetVirtualExchange()) {
+            CancelOrders(order_ids, errors);
+            return;
+        }
+        statuses = MarkPendingCancel(order_ids);
+    }
+    // The events are processed while the requests are in flight
+    std::vector<std::optional<ServiceReply>> replies(order_ids.size());
+    SendCancels(order_ids, replies, errors);
+    LockGuard lock = m_runner.GetEventLock();
+    ProcessCancelReplies(order_ids, statuses, replies, errors);
+}
+
+std::vector<OrderStatus> UserConnector::MarkPendingCancel(const std::vector<std::string>& order_ids) {
+    std::vector<OrderStatus> statuses;
+    statuses.reserve(order_ids.size());
+    for (const std::string& order_id : order_ids) {
+        Positions* owner = nullptr;
+        auto it = FindRestingOrder(order_id, owner);
+        assert(owner);
+        m_logger->info("CancelOrder order_id={} {} qty={}, px={}", order_id, it->second.direction, it->second.qty, it->second.px * m_instrument.px_step);
+        statuses.push_back(it->second.status);
+        it->second.status = OrderStatus::PendingCancel;
+    }
+    return statuses;
+}
+
+void UserConnector::SendCancels(const std::vector<std::string>& order_ids, std::vector<std::optional<ServiceReply>>& replies, std::vector<std::exception_ptr>& errors) {
+    // The job of the workers must not throw: a request without a reply keeps its exception
+    m_cancel_workers->Run(order_ids.size(), [&](size_t i) {
+        try {
+            replies[i] = m_orders_service->CancelOrder(m_account_id, order_ids[i]);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    });
+}
+
+void UserConnector::ProcessCancelReplies(const std::vector<std::string>& order_ids, const std::vector<OrderStatus>& statuses, std::vector<std::optional<ServiceReply>>& replies, std::vector<std::exception_ptr>& errors) {
+    // The orders may have been filled or resynced while the requests were in flight
+    for (size_t i = 0; i < order_ids.size(); ++i) {
+        Positions* owner = nullptr;
+        auto it = FindRestingOrder(order_ids[i], owner);
+        if (!errors[i]) {
+            try {
+                ParseReply<CancelOrderResponse>(*replies[i], m_logger);
+            } catch (const ServiceReply& failed_reply) {
+                errors[i] = std::current_exception();
+            }
+        }
+        if (errors[i]) {
+            if (owner) {
+                it->second.status = statuses[i];
+            }
+            continue;
+        }
+        if (owner) {
+            RemoveOrder(*owner, it);
+        }
+    }
+    FinishLogEvent();
+}
+
+void UserConnector::OrderStreamCallback(TradesStreamResponse* response, TimeType receive_time) {
     if (response->has_order_trades()) {
         LockGuard lock = m_runner.GetEventLock();
         // Process our trades
@@ -177,38 +653,143 @@ void UserConnector::OrderStreamCallback(TradesStreamResponse* response) {
         const int direction = order_trades.direction();
         assert(direction == OrderDirection::ORDER_DIRECTION_BUY || direction == OrderDirection::ORDER_DIRECTION_SELL);
 
-        // Calculate total executed qty
         const google::protobuf::RepeatedPtrField<OrderTrade>& trades = order_trades.trades();
         assert(!trades.empty());
-        const int px = m_instrument.QuotationToPx(trades[0].price());
-        int executed_qty = 0;
-        for (const OrderTrade& trade : trades) {
-            // TODO: parse time and trade_id
-            assert(m_instrument.QuotationToPx(trade.price()) == px);
-            assert(trade.quantity() % m_instrument.lot_size == 0);
-            executed_qty += m_instrument.QtyToLots(trade.quantity());  // convert to lots
-        }
-
-        ProcessOurTrade(lock, order_id, px, executed_qty, direction == OrderDirection::ORDER_DIRECTION_BUY ? Direction::Buy : Direction::Sell);
+        m_orders_stream_latency.Add(time_from_protobuf(trades[trades.size() - 1].date_time()), receive_time);
+        ProcessOrderTrades(lock, order_id, direction == OrderDirection::ORDER_DIRECTION_BUY ? Direction::Buy : Direction::Sell, trades, receive_time);
     } else {
         // Process ping
         assert(response->has_ping());
+        LockGuard lock = m_runner.GetEventLock();
+        m_orders_stream_latency.Add(time_from_protobuf(response->ping().time()), receive_time);
+        m_logger->info("OrdersStream ping: latency={} us; min={} us", m_orders_stream_latency.GetLast() / 1000, m_orders_stream_latency.GetMin() / 1000);
+        m_runner.OnPingUpdate();
+    }
+}
+
+void UserConnector::OrderStateStreamCallback(OrderStateStreamResponse* response, TimeType receive_time) {
+    if (response->has_order_state()) {
+        LockGuard lock = m_runner.GetEventLock();
+        const OrderStateStreamResponse::OrderState& order_state = response->order_state();
+        assert(order_state.account_id() == m_account_id && "Got unexpected order state for different account");
+
+        const std::string& order_id = order_state.order_id();
+        LimitOrder* order = FindOrder(order_id);
+        if (!order) {
+            m_logger->warn("OrderState of the unknown order: {}", order_id);
+            return;
+        }
+        OrderExecutionReportStatus status = order_state.execution_report_status();
+        m_logger->info("OrderState: order_id={}; status={}; lots_executed={}", order_id, static_cast<int>(status), order_state.lots_executed());
+
+        // Process executions before the status change: TradesStream reports the same trade ids
+        if (!order_state.trades().empty()) {
+            ProcessOrderTrades(lock, order_id, order->direction, order_state.trades(), receive_time);
+            order = FindOrder(order_id);
+        }
+
+        OrderStatus old_status = order->status;
+        if (status == OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_NEW) {
+            // Exchange acknowledgement
+            if (order->status == OrderStatus::PendingNew) {
+                order->status = OrderStatus::Live;
+            }
+        } else if (status == OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_CANCELLED ||
+                   status == OrderExecutionReportStatus::EXECUTION_REPORT_STATUS_REJECTED) {
+            // Cancelled by us, by the broker or rejected by the exchange
+            Positions* owner = nullptr;
+            auto it = FindRestingOrder(order_id, owner);
+            if (owner) {
+                RemoveOrder(*owner, it);
+                FinishLogEvent();
+                order = FindOrder(order_id);
+            }
+        }
+        if (order->status != old_status) {
+            m_logger->info("Order status: {} -> {}; {}", old_status, order->status, *order);
+            m_runner.OnOrderUpdate(*order);
+        }
+    } else if (response->has_ping()) {
+        m_logger->info("OrderStateStream ping");
+    } else {
+        // Process start of subscription
+        assert(response->has_subscription());
+        m_logger->info("OrderStateStream subscribe: success");
+    }
+}
+
+void UserConnector::ProcessOrderTrades(const LockGuard& lock, const std::string& order_id, Direction direction, const google::protobuf::RepeatedPtrField<OrderTrade>& trades, TimeType receive_time) {
+    // Trades with known ids were delivered by the other stream or before the resubscribe.
+    // Consecutive trades at one px are booked together
+    StreamSequencer& sequencer = m_runner.GetSequencer();
+    int px = 0;
+    int executed_qty = 0;
+    bool is_new = false;
+    for (const OrderTrade& trade : trades) {
+        assert(trade.quantity() % m_instrument.lot_size == 0);
+        if (!sequencer.OnFill(trade.trade_id(), time_from_protobuf(trade.date_time()), receive_time)) {
+            continue;
+        }
+        is_new = true;
+        const int trade_px = m_instrument.QuotationToPx(trade.price());
+        if (executed_qty > 0 && trade_px != px) {
+            ProcessExecution(lock, order_id, px, executed_qty, direction);
+            executed_qty = 0;
+        }
+        px = trade_px;
+        executed_qty += m_instrument.QtyToLots(trade.quantity());  // convert to lots
+    }
+    if (!is_new) {
+        m_logger->info("Known trades of order_id={} are suppressed", order_id);
+        return;
+    }
+    ProcessExecution(lock, order_id, px, executed_qty, direction);
+}
+
+void UserConnector::ProcessExecution(const LockGuard& lock, const std::string& order_id, int px, int reported_qty, Direction direction) {
+    LimitOrder* order = FindOrder(order_id);
+    if (!order) {
+        ProcessOurTrade(lock, order_id, px, reported_qty, direction);
+        return;
+    }
+    // Lots executed on post are booked already
+    order->reported_qty += reported_qty;
+    const int new_executed_qty = order->reported_qty - order->executed_qty;
+    if (new_executed_qty > 0) {
+        order->executed_qty = order->reported_qty;
+        ProcessOurTrade(lock, order_id, px, new_executed_qty, direction);
+    } else {
+        m_logger->info("Execution is already processed: order_id={}; qty={}", order_id, reported_qty);
     }
 }
 
 void UserConnector::ProcessOurTrade(const LockGuard& lock, const std::string& order_id, int px, int executed_qty, Direction direction) {
+    const LimitOrder order = BookOurTrade(order_id, px, executed_qty, direction);
+    // Notify strategy (lock all other events)
+    m_runner.OnOurTrade(order, executed_qty);
+}
+
+LimitOrder UserConnector::BookOurTrade(const std::string& order_id, int px, int executed_qty, Direction direction) {
     // Log OurTrade
     TimeType t = current_time();
     m_our_trades_logger->info("{},{},{},{},{},{}", internal_log_id, t, direction, order_id, executed_qty, px);
     m_logger->info("OurTrade: {} order_id={}, qty={}, px={}", direction, order_id, executed_qty, px);
     // Find order
-    auto it = m_positions.orders.find(order_id);
-    bool order_exists = (it != m_positions.orders.end());
+    Positions* owner = nullptr;
+    auto it = FindRestingOrder(order_id, owner);
+    bool order_exists = owner != nullptr;
+    int strategy_id = 0;
     if (!order_exists) {
-        m_logger->error("Execution of the cancelled order: {}", order_id);
-        // TODO: add storage with cancelled and executed orders
+        auto done_it = m_done_orders.find(order_id);
+        if (done_it != m_done_orders.end()) {
+            m_logger->warn("Execution of the done order: {}", done_it->second);
+            strategy_id = done_it->second.strategy_id;
+        } else {
+            m_logger->error("Execution of the unknown order: {}", order_id);
+        }
     } else {
         LimitOrder& order = it->second;
+        strategy_id = order.strategy_id;
         // Do sanity check
         if (order.px != px) {
             m_logger->error("Order: {}. Price mismatch: px = {}", order, px);
@@ -217,56 +798,187 @@ void UserConnector::ProcessOurTrade(const LockGuard& lock, const std::string& or
         assert(order.direction == direction && "Direction mismatch");
         assert(executed_qty <= order.qty && "More qty was executed than order contains");
         // Remove qty
-        order.qty -= executed_qty;
+        ReduceOrder(order, executed_qty);
     }
     // Update positions
     int signed_qty = executed_qty * (direction == Direction::Buy ? 1 : -1);
-    m_positions.qty += signed_qty;
-    m_positions.money -= signed_qty * px;
+    UpdatePositions(strategy_id, signed_qty, px);
+    m_pnl.OnFill(direction, px, executed_qty);
 
     // Copy order information
-    LimitOrder order = order_exists ? it->second : LimitOrder{.order_id = order_id, .direction = direction, .px = px, .qty = 0};
+    LimitOrder order = order_exists ? it->second : LimitOrder{.order_id = order_id, .direction = direction, .px = px, .qty = 0, .status = OrderStatus::Done, .strategy_id = strategy_id};
 
     // Remove empty order before strategy notification
-    if (it != m_positions.orders.end() && it->second.qty == 0) {
-        m_positions.orders.erase(it);
+    if (order_exists && it->second.qty == 0) {
+        RemoveOrder(*owner, it);
     }
 
     // Log positions after update
-    m_positions_logger->info("{},{},{},{}", internal_log_id, current_time(), m_positions.qty, m_positions.money);
+    m_positions_logger->info("{},{},{},{}", internal_log_id, t, m_positions.qty, m_positions.money);
     // Log Orders
-    LogOrders();
-
-    // Notify strategy (lock all other events)
-    m_runner.OnOurTrade(order, executed_qty);
+    FinishLogEvent();
+    return order;
 }
 
-const LimitOrder& UserConnector::ProcessNewPostOrder(const std::string& order_id, int px, int qty, Direction direction) {
-    assert(!m_positions.orders.contains(order_id));
+const LimitOrder& UserConnector::ProcessNewPostOrder(const std::string& order_id, int px, int qty, Direction direction, OrderStatus status, int strategy_id) {
+    Positions& owner = GetOwnerPositions(strategy_id);
+    assert(!owner.orders.contains(order_id));
     // Add order to current orders
-    auto it = m_positions.orders.emplace(
+    auto it = owner.orders.emplace(
         order_id,
         LimitOrder{
             .order_id = order_id,
             .direction = direction,
             .px = px,
-            .qty = qty});
+            .qty = qty,
+            .status = status,
+            .strategy_id = strategy_id});
     const LimitOrder& new_order = it.first->second;
+    UpdateOpenOrders(new_order, qty);
     // Log Orders
-    LogOrders();
+    LogOrderEvent("add", new_order);
+    FinishLogEvent();
     m_logger->info("New order is placed: {}", new_order);
     return new_order;
 }
 
+Positions& UserConnector::GetOwnerPositions(int strategy_id) {
+    return m_strategy_positions.empty() ? m_positions : m_strategy_positions[strategy_id];
+}
+
+OrdersMap::iterator UserConnector::FindRestingOrder(const std::string& order_id, Positions*& owner) {
+    for (int strategy_id = 0; strategy_id < GetStrategyCount(); ++strategy_id) {
+        Positions& positions = GetOwnerPositions(strategy_id);
+        auto it = positions.orders.find(order_id);
+        if (it != positions.orders.end()) {
+            owner = &positions;
+            return it;
+        }
+    }
+    owner = nullptr;
+    return {};
+}
+
+LimitOrder* UserConnector::FindOrder(const std::string& order_id) {
+    Positions* owner = nullptr;
+    auto it = FindRestingOrder(order_id, owner);
+    if (owner) {
+        return &it->second;
+    }
+    auto done_it = m_done_orders.find(order_id);
+    if (done_it != m_done_orders.end()) {
+        return &done_it->second;
+    }
+    return nullptr;
+}
+
+void UserConnector::ReduceOrder(LimitOrder& order, int qty) {
+    UpdateOpenOrders(order, -qty);
+    order.qty -= qty;
+    order.status = order.qty == 0 ? OrderStatus::Done : OrderStatus::PartiallyFilled;
+    LogOrderEvent("reduce", order);
+}
+
+void UserConnector::RemoveOrder(Positions& owner, OrdersMap::iterator it) {
+    it->second.status = OrderStatus::Done;
+    UpdateOpenOrders(it->second, -it->second.qty);
+    LogOrderEvent("remove", it->second);
+    // Keep only recent orders: replace the oldest one in the ring
+    std::string& oldest_order_id = m_done_order_ids[m_n_done_orders++ % DONE_ORDERS_CAPACITY];
+    if (m_n_done_orders > DONE_ORDERS_CAPACITY) {
+        m_done_orders.erase(oldest_order_id);
+    }
+    oldest_order_id = it->first;
+    m_done_orders.insert(owner.orders.extract(it));
+}
+
+void UserConnector::UpdateOpenOrders(const LimitOrder& order, int qty) {
+    auto update = [&order, qty](Positions& positions) {
+        PoolMap<int, int>* qty_by_px;
+        if (order.direction == Direction::Buy) {
+            positions.open_buy_qty += qty;
+            positions.open_buy_notional += static_cast<int64_t>(order.px) * qty;
+            qty_by_px = &positions.open_buy_qty_by_px;
+        } else {
+            positions.open_sell_qty += qty;
+            qty_by_px = &positions.open_sell_qty_by_px;
+        }
+        auto it = qty_by_px->try_emplace(order.px, 0).first;
+        it->second += qty;
+        if (it->second == 0) {
+            qty_by_px->erase(it);
+        }
+    };
+    update(m_positions);
+    if (!m_strategy_positions.empty()) {
+        update(m_strategy_positions[order.strategy_id]);
+    }
+}
+
+void UserConnector::UpdatePositions(int strategy_id, int signed_qty, int px) {
+    m_positions.qty += signed_qty;
+    m_positions.money -= signed_qty * px;
+    if (!m_strategy_positions.empty()) {
+        Positions& owner = m_strategy_positions[strategy_id];
+        owner.qty += signed_qty;
+        owner.money -= signed_qty * px;
+    }
+}
+
+void UserConnector::AllocatePositions() {
+    if (m_strategy_positions.empty()) {
+        return;
+    }
+    const int n_strategies = GetStrategyCount();
+    int money_left = m_positions.money;
+    int qty_left = m_positions.qty;
+    for (int strategy_id = n_strategies - 1; strategy_id >= 0; --strategy_id) {
+        const ConfigType& config = m_runner.GetStrategyConfig(strategy_id);
+        Positions& positions = m_strategy_positions[strategy_id];
+        // The first strategy gets the rest of the account
+        positions.money = strategy_id > 0 ? config["money"].as<int>(m_positions.money / n_strategies) : money_left;
+        positions.qty = strategy_id > 0 ? config["qty"].as<int>(m_positions.qty / n_strategies) : qty_left;
+        money_left -= positions.money;
+        qty_left -= positions.qty;
+        m_logger->info("Positions of strategy {}: money={}; qty={}", strategy_id, positions.money, positions.qty);
+    }
+}
+
+void UserConnector::ReconcileStrategyPositions(int qty_old, int money_old) {
+    if (m_strategy_positions.empty() || (m_positions.qty == qty_old && m_positions.money == money_old)) {
+        return;
+    }
+    // Owners of the executions during the outage are unknown
+    m_logger->warn("Resync: change of the account positions is attributed to strategy 0: qty {:+}; money {:+}", m_positions.qty - qty_old, m_positions.money - money_old);
+    m_strategy_positions[0].qty += m_positions.qty - qty_old;
+    m_strategy_positions[0].money += m_positions.money - money_old;
+}
+
 bool UserConnector::IsReady() const {
     // TODO: remove
     return m_is_order_stream_ready;
 }
 
-void UserConnector::LogOrders() {
-    for (const auto& [order_id, limit_order] : m_positions.orders) {
-        assert(order_id == limit_order.order_id);
-        m_orders_logger->info("{},{},{},{},{},{}", internal_log_id, current_time(), order_id, limit_order.direction, limit_order.px, limit_order.qty);
+void UserConnector::LogOrderEvent(const char* event, const LimitOrder& order) {
+    m_orders_logger->info("{},{},{},{},{},{},{}", internal_log_id, current_time(), event, order.order_id, order.direction, order.px, order.qty);
+}
+
+void UserConnector::LogOrdersSnapshot() {
+    // Header row contains the number of orders
+    TimeType t = current_time();
+    m_orders_logger->info("{},{},snapshot,,,0,{}", internal_log_id, t, GetOrderCount());
+    for (int strategy_id = 0; strategy_id < GetStrategyCount(); ++strategy_id) {
+        for (const auto& [order_id, limit_order] : GetOwnerPositions(strategy_id).orders) {
+            assert(order_id == limit_order.order_id);
+            m_orders_logger->info("{},{},snapshot_order,{},{},{},{}", internal_log_id, t, order_id, limit_order.direction, limit_order.px, limit_order.qty);
+        }
+    }
+}
+
+void UserConnector::FinishLogEvent() {
+    // Snapshot bounds the replay of the journal
+    if (++m_n_log_events % ORDERS_SNAPSHOT_PERIOD == 0) {
+        LogOrdersSnapshot();
     }
-    ++internal_log_id; // increment internal log id
+    ++internal_log_id;  // increment internal log id
 }
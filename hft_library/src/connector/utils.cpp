@@ -72,7 +72,3 @@ TimeType time_from_protobuf(const google::protobuf::Timestamp& timestamp) {
     return std::chrono::duration_cast<std::chrono::nanoseconds>(duration_since_epoch).count();
 }
 
-TimeType current_time() {
-    auto duration_since_epoch = std::chrono::system_clock::now().time_since_epoch();
-    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration_since_epoch).count();
-}
@@ -0,0 +1,159 @@
+#include "connector/wire.h"
+
+#include <zlib.h>
+
+#include <cstring>
+#include <stdexcept>
+
+const char* WireStreamName(WireStream stream) {
+    switch (stream) {
+        case WireStream::OrderBook:
+            return "OrderBook";
+        case WireStream::Trades:
+            return "Trades";
+        case WireStream::Orders:
+            return "Orders";
+        case WireStream::OrderState:
+            return "OrderState";
+    }
+    return "Unknown";
+}
+
+WireRecorder::WireRecorder(const std::string& path, std::shared_ptr<spdlog::logger> logger)
+    : m_logger(std::move(logger)),
+      m_file(gzopen(path.c_str(), "wb1")) {  // fastest compression: the writer must keep up with the streams
+    if (!m_file) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    Write(std::string(wire::MAGIC, sizeof(wire::MAGIC)));
+    m_logger->info("Record stream messages to {}", path);
+    m_thread = std::jthread([this](std::stop_token stop_token) { WriteLoop(stop_token); });
+}
+
+WireRecorder::~WireRecorder() {
+    m_thread.request_stop();
+    m_thread.join();
+    if (m_n_dropped > 0) {
+        m_logger->warn("Wire recorder dropped {} messages", m_n_dropped);
+    }
+    gzclose(m_file);
+}
+
+void WireRecorder::Stage(WireStream stream, TimeType receive_time, const google::protobuf::MessageLite& message) {
+    t_staged = StagedMessage{.recorder = this, .stream = stream, .receive_time = receive_time, .message = &message};
+}
+
+void WireRecorder::RecordStaged() {
+    // Shadow runners may record too: each recorder takes only its own messages
+    if (t_staged.recorder != this) {
+        return;
+    }
+    Record(t_staged.stream, t_staged.receive_time, *t_staged.message);
+    t_staged = StagedMessage{};
+}
+
+bool WireRecorder::HasStaged() const {
+    return t_staged.recorder == this;
+}
+
+void WireRecorder::Record(WireStream stream, TimeType receive_time, const google::protobuf::MessageLite& message) {
+    std::lock_guard lock(m_mutex);
+    if (m_pending.size() >= MAX_PENDING_MESSAGES) {
+        ++m_n_dropped;
+        return;
+    }
+    // Copy into a recycled message: its fields keep their capacity
+    std::vector<std::unique_ptr<google::protobuf::MessageLite>>& free_messages = m_free_messages[static_cast<size_t>(stream)];
+    std::unique_ptr<google::protobuf::MessageLite> copy;
+    if (free_messages.empty()) {
+        copy.reset(message.New());
+    } else {
+        copy = std::move(free_messages.back());
+        free_messages.pop_back();
+        copy->Clear();
+    }
+    copy->CheckTypeAndMergeFrom(message);
+    m_pending.push_back(PendingRecord{.header = {.receive_time = receive_time, .stream = stream, .size = 0}, .message = std::move(copy)});
+    if (m_pending.size() == 1) {
+        m_cv.notify_one();
+    }
+}
+
+void WireRecorder::WriteLoop(std::stop_token stop_token) {
+    std::vector<PendingRecord> records;
+    std::string buffer;
+    auto next_flush = std::chrono::steady_clock::now() + FLUSH_PERIOD;
+    while (true) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait_until(lock, stop_token, next_flush, [this] { return !m_pending.empty(); });
+            records.swap(m_pending);
+        }
+        if (records.empty() && stop_token.stop_requested()) {
+            return;
+        }
+        Serialize(records, buffer);
+        {
+            // Recycle the messages
+            std::lock_guard lock(m_mutex);
+            for (PendingRecord& record : records) {
+                m_free_messages[static_cast<size_t>(record.header.stream)].push_back(std::move(record.message));
+            }
+        }
+        records.clear();
+        Write(buffer);
+        buffer.clear();
+        // Flush periodically: a crash loses at most the last period
+        if (std::chrono::steady_clock::now() >= next_flush) {
+            gzflush(m_file, Z_SYNC_FLUSH);
+            next_flush = std::chrono::steady_clock::now() + FLUSH_PERIOD;
+        }
+    }
+}
+
+void WireRecorder::Serialize(std::vector<PendingRecord>& records, std::string& buffer) {
+    for (PendingRecord& record : records) {
+        const size_t size = record.message->ByteSizeLong();
+        const size_t offset = buffer.size();
+        // Serialize in place: the buffer keeps its capacity between batches
+        buffer.resize(offset + sizeof(wire::RecordHeader) + size);
+        record.header.size = static_cast<uint32_t>(size);
+        std::memcpy(buffer.data() + offset, &record.header, sizeof(record.header));
+        record.message->SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(buffer.data() + offset + sizeof(record.header)));
+    }
+}
+
+void WireRecorder::Write(const std::string& buffer) {
+    if (!buffer.empty() && gzwrite(m_file, buffer.data(), static_cast<unsigned>(buffer.size())) == 0) {
+        int error;
+        m_logger->error("Wire recorder write failed: {}", gzerror(m_file, &error));
+    }
+}
+
+WireReader::WireReader(const std::string& path) : m_file(gzopen(path.c_str(), "rb")) {
+    if (!m_file) {
+        throw std::runtime_error("Could not open " + path);
+    }
+    char magic[sizeof(wire::MAGIC)];
+    if (gzread(m_file, magic, sizeof(magic)) != sizeof(magic) || std::memcmp(magic, wire::MAGIC, sizeof(magic)) != 0) {
+        gzclose(m_file);
+        throw std::runtime_error("Not a wire record: " + path);
+    }
+}
+
+WireReader::~WireReader() {
+    gzclose(m_file);
+}
+
+bool WireReader::Next(wire::RecordHeader& header, std::string& payload) {
+    int n_read = gzread(m_file, &header, sizeof(header));
+    if (n_read == 0) {
+        return false;
+    }
+    payload.resize(header.size);
+    // The last record may be cut by a crash of the recording process
+    if (n_read != sizeof(header) || gzread(m_file, payload.data(), header.size) != static_cast<int>(header.size)) {
+        return false;
+    }
+    return true;
+}
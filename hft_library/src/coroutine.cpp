@@ -0,0 +1,15 @@
+#include "coroutine.h"
+
+#include "runner.h"
+
+void PostAwaitable::await_suspend(std::coroutine_handle<> handle) {
+    m_runner.SuspendOrderTask(m_request);
+}
+
+void CancelAwaitable::await_suspend(std::coroutine_handle<> handle) {
+    m_runner.SuspendOrderTask(m_request);
+}
+
+void CancelBatchAwaitable::await_suspend(std::coroutine_handle<> handle) {
+    m_runner.SuspendOrderTask(m_request);
+}
@@ -0,0 +1,101 @@
+#include "plugin.h"
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+template <typename Function>
+Function LoadSymbol(void* handle, const char* name, const std::string& path) {
+    void* symbol = dlsym(handle, name);
+    if (!symbol) {
+        throw std::runtime_error("Plugin " + path + " has no " + name);
+    }
+    return reinterpret_cast<Function>(symbol);
+}
+
+// Copy of the plugin that is unique for this process and version
+std::string MakePrivateCopy(const std::string& path) {
+    static int n_copies = 0;
+    std::filesystem::path copy = std::filesystem::temp_directory_path() / (std::filesystem::path(path).stem().string() + "." + std::to_string(getpid()) + "." + std::to_string(n_copies++) + ".so");
+    std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing);
+    return copy.string();
+}
+
+template <typename T>
+bool ReadAt(std::ifstream& file, uint64_t offset, T& value) {
+    file.seekg(static_cast<std::streamoff>(offset));
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+}  // namespace
+
+std::optional<PluginAbi> StrategyPlugin::ReadAbi(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    Elf64_Ehdr header;
+    if (!ReadAt(file, 0, header) || std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 || header.e_ident[EI_CLASS] != ELFCLASS64 || header.e_shentsize != sizeof(Elf64_Shdr)) {
+        return std::nullopt;
+    }
+    // Section names are in the section of index e_shstrndx
+    Elf64_Shdr names;
+    if (!ReadAt(file, header.e_shoff + header.e_shstrndx * sizeof(Elf64_Shdr), names)) {
+        return std::nullopt;
+    }
+    for (uint16_t i = 0; i < header.e_shnum; ++i) {
+        Elf64_Shdr section;
+        if (!ReadAt(file, header.e_shoff + i * sizeof(Elf64_Shdr), section)) {
+            return std::nullopt;
+        }
+        char name[sizeof(PLUGIN_ABI_SECTION)];
+        if (!ReadAt(file, names.sh_offset + section.sh_name, name) || std::memcmp(name, PLUGIN_ABI_SECTION, sizeof(name)) != 0) {
+            continue;
+        }
+        PluginAbi abi;
+        if (section.sh_size != sizeof(PluginAbi) || !ReadAt(file, section.sh_offset, abi)) {
+            return std::nullopt;
+        }
+        return abi;
+    }
+    return std::nullopt;
+}
+
+std::shared_ptr<StrategyPlugin> StrategyPlugin::Load(const std::string& path) {
+    const std::string copy = MakePrivateCopy(path);
+    // Checked before dlopen: static initializers of a mismatching plugin would run against other layouts
+    const std::optional<PluginAbi> abi = ReadAbi(copy);
+    if (!abi || *abi != MakePluginAbi()) {
+        std::filesystem::remove(copy);
+        throw std::runtime_error("Plugin " + path + (abi ? " is built with different headers or compiler" : " has no ABI record") + ": rebuild it with the host");
+    }
+    void* handle = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+    // The mapping outlives the file
+    std::filesystem::remove(copy);
+    if (!handle) {
+        throw std::runtime_error("Could not load plugin " + path + ": " + dlerror());
+    }
+    std::shared_ptr<StrategyPlugin> plugin(new StrategyPlugin(handle, path));
+    plugin->m_create = LoadSymbol<CreateStrategyFunction>(handle, "hft_create_strategy", path);
+    plugin->m_destroy = LoadSymbol<DestroyStrategyFunction>(handle, "hft_destroy_strategy", path);
+    return plugin;
+}
+
+StrategyPlugin::StrategyPlugin(void* handle, std::string path) : m_handle(handle), m_path(std::move(path)) {}
+
+StrategyPlugin::~StrategyPlugin() {
+    dlclose(m_handle);
+}
+
+Runner::StrategyGetter StrategyPlugin::GetStrategyGetter() {
+    return [plugin = shared_from_this()](Runner& runner) {
+        const ConfigType config = runner.GetStrategyConfig();
+        // The deleter keeps the code of the strategy loaded
+        return std::shared_ptr<Strategy>(plugin->m_create(&runner, &config), [plugin](Strategy* strategy) { plugin->m_destroy(strategy); });
+    };
+}
@@ -0,0 +1,130 @@
+#include "risk.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <iterator>
+
+const char* RiskRuleName(RiskRule rule) {
+    switch (rule) {
+        case RiskRule::OrderQty:
+            return "OrderQty";
+        case RiskRule::OrderNotional:
+            return "OrderNotional";
+        case RiskRule::Position:
+            return "Position";
+        case RiskRule::Money:
+            return "Money";
+        case RiskRule::Short:
+            return "Short";
+        case RiskRule::OrderRate:
+            return "OrderRate";
+        case RiskRule::Collar:
+            return "Collar";
+        case RiskRule::Distance:
+            return "Distance";
+        case RiskRule::Loss:
+            return "Loss";
+        case RiskRule::SelfMatch:
+            return "SelfMatch";
+        case RiskRule::Count:
+            break;
+    }
+    assert(false && "Unreachable");
+    return "";
+}
+
+OrderRejected::OrderRejected(RiskRule rule, const std::string& message) : std::runtime_error(message), rule(rule) {}
+
+RiskGate::RiskGate(const ConfigType& config, const Positions& positions, const MarketOrderBook& order_book, const PnLTracker& pnl, std::shared_ptr<spdlog::logger> logger)
+    : m_logger(std::move(logger)),
+      m_positions(positions),
+      m_order_book(order_book),
+      m_pnl(pnl),
+      m_max_order_qty(config["max_order_qty"].as<int>(0)),
+      m_max_order_notional(config["max_order_notional"].as<int64_t>(0)),
+      m_max_position(config["max_position"].as<int>(0)),
+      m_check_money(config["check_money"].as<bool>(false)),
+      m_allow_short(config["allow_short"].as<bool>(true)),
+      m_collar_ticks(config["collar_ticks"].as<int>(-1)),
+      m_max_distance_ticks(config["max_distance_ticks"].as<int>(0)),
+      m_max_loss(config["max_loss"].as<double>(0)),
+      m_prevent_self_match(config["prevent_self_match"].as<bool>(true)),
+      m_order_times(config["max_orders_per_second"].as<size_t>(0)) {
+    assert(m_max_order_qty >= 0 && m_max_order_notional >= 0 && m_max_position >= 0 && m_max_distance_ticks >= 0 && m_max_loss >= 0);
+}
+
+void RiskGate::Check(int px, int qty, Direction direction, TimeType now) {
+    ++m_n_checks;
+    RiskRule rule = Evaluate(px, qty, direction, now);
+    if (rule != RiskRule::Count) {
+        ++m_n_rejects[static_cast<size_t>(rule)];
+        std::string message = fmt::format("{} rule: {} qty={}, px={}; position={}; open_buy_qty={}; open_sell_qty={}; best=[{}, {}]", RiskRuleName(rule), direction, qty, px, m_positions.qty, m_positions.open_buy_qty, m_positions.open_sell_qty, m_order_book.bid[0].px, m_order_book.ask[0].px);
+        m_logger->warn("Order is rejected by {}", message);
+        throw OrderRejected(rule, message);
+    }
+}
+
+void RiskGate::OnOrderPosted(TimeType now) {
+    if (!m_order_times.empty()) {
+        m_order_times[m_n_orders++ % m_order_times.size()] = now;
+    }
+}
+
+RiskRule RiskGate::Evaluate(int px, int qty, Direction direction, TimeType now) const {
+    assert(qty > 0);
+    const bool is_buy = direction == Direction::Buy;
+    const int64_t notional = static_cast<int64_t>(px) * qty;
+    // Fat finger
+    if (m_max_order_qty > 0 && qty > m_max_order_qty) {
+        return RiskRule::OrderQty;
+    }
+    if (m_max_order_notional > 0 && notional > m_max_order_notional) {
+        return RiskRule::OrderNotional;
+    }
+    // Exposure of the resting orders
+    if (m_max_position > 0) {
+        int worst_position = is_buy ? m_positions.qty + m_positions.open_buy_qty + qty : m_positions.qty - m_positions.open_sell_qty - qty;
+        if (std::abs(worst_position) > m_max_position) {
+            return RiskRule::Position;
+        }
+    }
+    if (m_check_money && is_buy && m_positions.open_buy_notional + notional > m_positions.money) {
+        return RiskRule::Money;
+    }
+    if (!m_allow_short && !is_buy && m_positions.open_sell_qty + qty > m_positions.qty) {
+        return RiskRule::Short;
+    }
+    // Self-match: the order would trade with a resting order of the account (the best resting px are kept in Positions)
+    if (m_prevent_self_match) {
+        const PoolMap<int, int>& opposite = is_buy ? m_positions.open_sell_qty_by_px : m_positions.open_buy_qty_by_px;
+        if (!opposite.empty() && (is_buy ? px >= opposite.begin()->first : px <= opposite.rbegin()->first)) {
+            return RiskRule::SelfMatch;
+        }
+    }
+    // Order rate: the oldest of the last max_orders_per_second orders is within the last second
+    if (!m_order_times.empty() && m_n_orders >= m_order_times.size() && now - m_order_times[m_n_orders % m_order_times.size()] < 1'000'000'000) {
+        return RiskRule::OrderRate;
+    }
+    // Price collars
+    const int best_bid_px = m_order_book.bid[0].px;
+    const int best_ask_px = m_order_book.ask[0].px;
+    if (m_collar_ticks >= 0 && (is_buy ? px > best_ask_px + m_collar_ticks : px < best_bid_px - m_collar_ticks)) {
+        return RiskRule::Collar;
+    }
+    if (m_max_distance_ticks > 0 && (is_buy ? px < best_bid_px - m_max_distance_ticks : px > best_ask_px + m_max_distance_ticks)) {
+        return RiskRule::Distance;
+    }
+    // Loss limit
+    if (m_max_loss > 0 && m_pnl.GetPnL().total < -m_max_loss) {
+        return RiskRule::Loss;
+    }
+    return RiskRule::Count;
+}
+
+void RiskGate::LogCounters() const {
+    std::string counters;
+    for (size_t i = 0; i < m_n_rejects.size(); ++i) {
+        fmt::format_to(std::back_inserter(counters), "; {}={}", RiskRuleName(static_cast<RiskRule>(i)), m_n_rejects[i]);
+    }
+    m_logger->info("RiskGate: checks={}{}", m_n_checks, counters);
+}
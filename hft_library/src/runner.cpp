@@ -4,33 +4,298 @@
 #include <spdlog/sinks/stdout_sinks.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
+#include <thread>
+
+#include <spdlog/sinks/null_sink.h>
 
 #include "constants.h"
 
+namespace {
+
+// Capacity of the order workflow buffers reserved at startup: a round of requests does not allocate
+constexpr size_t STARTUP_ORDER_TASKS = 64;
+
+// Ids of the runners: a thread remembers the last runner that configured it (runners may reuse an address)
+std::atomic<uint64_t> g_next_runner_id = 1;
+
+// Nodes of the order maps recycled by each event thread (runner.threading.prefault)
+constexpr size_t PREFAULT_POOL_NODES = 256;
+
+// Order map nodes of the calling thread: orders are posted and removed on the thread that notifies the strategy
+void PrefaultOrderPools() {
+    PrefaultPool<OrdersMap>(PREFAULT_POOL_NODES, [](size_t i) {
+        return std::pair<const std::string, LimitOrder>(std::to_string(i), LimitOrder{.order_id = std::to_string(i), .direction = Direction::Buy, .px = 0, .qty = 0});
+    });
+    PrefaultPool<PoolMap<int, int>>(PREFAULT_POOL_NODES, [](size_t i) { return std::pair<const int, int>(static_cast<int>(i), 0); });
+}
+
+RunnerMode ParseRunnerMode(const ConfigType& config) {
+    std::string mode = config["runner"]["mode"].as<std::string>("live");
+    if (mode == "live") {
+        return RunnerMode::Live;
+    } else if (mode == "backtest") {
+        return RunnerMode::Backtest;
+    } else if (mode == "paper") {
+        return RunnerMode::Paper;
+    }
+    throw std::runtime_error("Unknown runner.mode: " + mode);
+}
+
+std::unique_ptr<WireRecorder> MakeWireRecorder(const ConfigType& config, std::shared_ptr<spdlog::logger> logger) {
+    if (!config["runner"]["wire_record"].as<bool>(false)) {
+        return nullptr;
+    }
+    if (!config["runner"]["log_directory"]) {
+        throw std::runtime_error("runner.wire_record requires runner.log_directory");
+    }
+    return std::make_unique<WireRecorder>(std::filesystem::path(config["runner"]["log_directory"].as<std::string>()) / "wire.gz", logger);
+}
+
+std::unique_ptr<ConfigWatcher> MakeConfigWatcher(const ConfigType& config, RunnerMode mode, std::shared_ptr<spdlog::logger> logger) {
+    if (!config["runner"]["config_reload"] || mode == RunnerMode::Backtest) {
+        return nullptr;
+    }
+    return std::make_unique<ConfigWatcher>(config["runner"]["config_reload"], logger);
+}
+
+std::unique_ptr<StatusPublisher> MakeStatusPublisher(const ConfigType& config, const Instrument& instrument, const MarketConnector& mkt, const UserConnector& usr, const RiskGate& risk, const StreamSequencer& sequencer, std::shared_ptr<spdlog::logger> logger) {
+    if (!config["runner"]["status"]) {
+        return nullptr;
+    }
+    return std::make_unique<StatusPublisher>(config["runner"]["status"], instrument, mkt, usr, risk, sequencer, logger);
+}
+
+}  // namespace
+
 Runner::Runner(const ConfigType& config, const StrategyGetter& strategy_getter)
-    : m_config(config),
+    : Runner(config, std::vector<StrategyGetter>{strategy_getter}) {}
+
+Runner::Runner(const ConfigType& config, const std::vector<StrategyGetter>& strategy_getters)
+    : Runner(config, strategy_getters, nullptr) {}
+
+Runner::Runner(const ConfigType& config, const StrategyGetter& strategy_getter, Runner& primary)
+    : Runner(config, std::vector<StrategyGetter>{strategy_getter}, &primary) {
+    primary.AttachShadow(*this);
+}
+
+Runner::Runner(const ConfigType& config, const std::vector<StrategyGetter>& strategy_getters, Runner* primary)
+    : m_id(g_next_runner_id.fetch_add(1, std::memory_order_relaxed)),
+      m_config(config),
+      m_mode(ParseRunnerMode(config)),
+      m_threading(config["runner"]["threading"] ? ThreadingConfig(config["runner"]["threading"]) : ThreadingConfig()),
       m_runner_logger(GetLogger("runner", false)),
-      m_client(ENDPOINT, config["runner"]["token"].as<std::string>()),
-      // TODO: Get/Check instrument information in RunTime
-      m_instrument(
-          config["runner"]["figi"].as<std::string>(),
-          config["runner"]["lot_size"].as<int>(),
-          config["runner"]["px_step"].as<double>()),
+      m_wire_recorder(!primary ? MakeWireRecorder(config, m_runner_logger) : nullptr),
+      m_client(m_mode != RunnerMode::Backtest && !primary ? std::make_unique<InvestApiClient>(config["runner"]["endpoint"].as<std::string>(ENDPOINT), config["runner"]["token"].as<std::string>()) : nullptr),
+      m_virtual_exchange(m_mode != RunnerMode::Live ? std::make_unique<VirtualExchange>() : nullptr),
+      m_instrument_cache(!primary && m_mode != RunnerMode::Backtest ? std::make_unique<InstrumentMetadataCache>(config["runner"]["instrument"] ? config["runner"]["instrument"] : ConfigType(), config["runner"]["figi"].as<std::string>(), m_client.get(), m_runner_logger) : nullptr),
+      m_instrument(!primary ? MakeInstrument(config, m_instrument_cache.get(), m_runner_logger) : primary->m_instrument),
+      m_sequencer(config["market"]["sequencing"] ? config["market"]["sequencing"] : ConfigType(), m_runner_logger),
       m_mkt(*this, config),
-      m_usr(*this, config),
-      m_strategy(strategy_getter(*this)) {}
+      m_usr(*this, config, static_cast<int>(strategy_getters.size())),
+      m_risk(config["risk"] ? config["risk"] : ConfigType(), m_usr.GetPositions(), m_mkt.GetOrderBook(), m_usr.GetPnL(), m_runner_logger),
+      m_status(!primary ? MakeStatusPublisher(config, m_instrument, m_mkt, m_usr, m_risk, m_sequencer, m_runner_logger) : nullptr),
+      m_supervisor(!primary ? std::make_unique<StreamSupervisor>(config["runner"]["supervisor"] ? config["runner"]["supervisor"] : ConfigType(), m_runner_logger) : nullptr),
+      m_config_watcher(!primary ? MakeConfigWatcher(config, m_mode, m_runner_logger) : nullptr) {
+    assert(!strategy_getters.empty());
+    assert((strategy_getters.size() == 1 || config["strategies"].size() == strategy_getters.size()) && "strategies must configure each strategy");
+    for (size_t i = 0; i < strategy_getters.size(); ++i) {
+        m_strategy_configs.push_back(get_strategy_config(m_config, static_cast<int>(i)));
+    }
+    for (size_t i = 0; i < strategy_getters.size(); ++i) {
+        m_active_strategy = static_cast<int>(i);
+        m_strategies.push_back(strategy_getters[i](*this));
+    }
+    m_active_strategy = 0;
+    m_startup.Mark("runner constructed (client, instrument, connectors, strategies)");
+    // Backtests post orders without a startup to log
+    if (m_mode == RunnerMode::Backtest) {
+        m_startup.Discard();
+    }
+    // Backtests keep the optimistic fills of the recorded results by default
+    if (m_virtual_exchange && config["runner"]["queue_position"].as<bool>(m_mode == RunnerMode::Paper)) {
+        m_virtual_exchange->EnableQueueModel(m_mkt.GetOrderBook());
+    }
+}
 
 void Runner::Start() {
+    assert(m_mode != RunnerMode::Backtest && m_supervisor && "backtests and shadows are not started");
     m_runner_logger->info(std::string(50, '='));
+    m_runner_logger->info("TscClock: frequency={:.3f} GHz; invariant={}", TscClock::GetFrequency(), TscClock::IsInvariant());
+    if (!TscClock::IsInvariant()) m_runner_logger->warn("TSC is not invariant: timestamps may be inconsistent across cores");
+
+    // Configure memory and the main thread (strategy is notified from it on readiness)
+    {
+        StartupTimeline::Scope phase = m_startup.Measure("configure memory and threads, pre-touch");
+        if (m_threading.lock_memory) {
+            LockMemory(m_runner_logger);
+        }
+        ConfigureCurrentThread(m_threading, ThreadRole::Strategy, m_runner_logger);
+        if (m_threading.prefault) {
+            // Streams are not started yet: the hot data is written by this thread only
+            Prefault(&m_mkt.m_order_book_levels, sizeof(m_mkt.m_order_book_levels));
+            Prefault(&m_usr.m_positions, sizeof(Positions));
+            for (Positions& positions : m_usr.m_strategy_positions) {
+                Prefault(&positions, sizeof(Positions));
+            }
+            Prefault(m_usr.m_done_order_ids.data(), sizeof(m_usr.m_done_order_ids));
+            PrefaultOrderPools();
+        }
+        // Buffers of the first requotes
+        m_order_tasks.reserve(STARTUP_ORDER_TASKS);
+        m_cancel_order_ids.reserve(STARTUP_ORDER_TASKS);
+        m_cancel_errors.reserve(STARTUP_ORDER_TASKS);
+    }
+
+    // Subscriptions are asynchronous: the streams connect while the positions are fetched
     m_mkt.Start();
-    m_usr.Start();
+    if (m_mode == RunnerMode::Paper) {
+        m_usr.StartBacktest(m_config["paper"]["money"].as<int>(), m_config["paper"]["qty"].as<int>(0));
+    } else {
+        m_usr.Start();
+    }
+
+    // Supervise streams
+    m_supervisor->Register(StreamType::OrderBook, [this]() { m_mkt.Reconnect(StreamType::OrderBook); });
+    m_supervisor->Register(StreamType::Trades, [this]() { m_mkt.Reconnect(StreamType::Trades); });
+    if (m_mode == RunnerMode::Live) {
+        m_supervisor->Register(StreamType::Orders, [this]() { m_usr.Reconnect(); });
+    }
+    m_supervisor->Start();
+
+    if (m_config_watcher) {
+        m_config_watcher->Start();
+    }
+    m_instrument_cache->StartRefresh(m_instrument, [this](const std::string& error) { HaltOnInstrumentMismatch(error); });
+}
+
+Runner::~Runner() {
+    // The refresh may halt the runner
+    if (m_instrument_cache) {
+        m_instrument_cache->StopRefresh();
+    }
+}
+
+void Runner::AttachShadow(Runner& shadow) {
+    assert(shadow.m_mode == RunnerMode::Paper && &shadow != this);
+    assert(shadow.m_mkt.GetOrderBook().depth == m_mkt.GetOrderBook().depth && "market.depth of the shadow differs");
+    assert(shadow.m_instrument.figi == m_instrument.figi);
+    // Without own streams: the shadow is ready on the first forwarded orderbook
+    shadow.m_mkt.StartBacktest();
+    shadow.m_usr.StartBacktest(shadow.m_config["paper"]["money"].as<int>(), shadow.m_config["paper"]["qty"].as<int>(0));
+    m_shadows.push_back(std::make_unique<ShadowFeed>(shadow, m_mkt.GetOrderBook().depth, m_runner_logger));
+    m_runner_logger->info("Attach shadow paper runner: {} shadows", m_shadows.size());
+}
+
+void Runner::ReplaceStrategy(int strategy_id, const StrategyGetter& strategy_getter) {
+    assert(0 <= strategy_id && strategy_id < GetStrategyCount());
+    // No event is processed while the lock is held
+    LockGuard lock = GetEventLock();
+    // Workflows of the strategy may wait for their cancels without the lock
+    WaitForRequests();
+    m_active_strategy = strategy_id;
+    std::shared_ptr<Strategy>& strategy = m_strategies[strategy_id];
+    const std::string state = strategy->SaveState();
+    // The old strategy stays if the new one throws
+    std::shared_ptr<Strategy> new_strategy = strategy_getter(*this);
+    new_strategy->LoadState(state);
+    strategy = std::move(new_strategy);
+    m_runner_logger->info("Strategy {} is replaced: state of {} bytes", strategy_id, state.size());
+    if (IsReady()) {
+        NotifyStrategy(strategy_id, [](Strategy& strategy) { strategy.OnStrategyReloaded(); });
+    }
+}
+
+void Runner::Backtest(const MarketDataFile& data) {
+    StartBacktest();
+    Replay(data, 0, data.Size());
+}
+
+void Runner::StartBacktest() {
+    assert(m_mode == RunnerMode::Backtest);
+    m_mkt.StartBacktest();
+    m_usr.StartBacktest(m_config["backtest"]["money"].as<int>(), m_config["backtest"]["qty"].as<int>(0));
+}
+
+void Runner::Replay(const MarketDataFile& data, size_t begin, size_t end) {
+    assert(m_mode == RunnerMode::Backtest);
+    const int depth = data.GetDepth();
+    assert(depth == m_mkt.GetOrderBook().depth && "market.depth differs from the recorded depth");
+    assert(begin <= end && end <= data.Size());
+
+    for (size_t i = begin; i < end; ++i) {
+        const MarketDataFile::Record& record = data.GetRecord(i);
+        const size_t n_allocations = GetThreadAllocations().n_allocations;
+        size_t n_fill_allocations = 0;
+        // Our resting orders are matched before the strategy sees the event
+        if (record.type == MarketDataFile::RecordType::OrderBook) {
+            const int32_t* levels = data.GetLevels(i);
+            m_virtual_exchange->OnOrderBook(levels, levels + depth, levels + 2 * depth, levels + 3 * depth, depth);
+            n_fill_allocations += ProcessVirtualFills();
+            m_mkt.ProcessOrderBook(record.receive_time, record.exchange_time, levels, levels + depth, levels + 2 * depth, levels + 3 * depth);
+        } else {
+            Direction direction = record.direction == 1 ? Direction::Buy : Direction::Sell;
+            m_virtual_exchange->OnTrade(direction, record.px, record.qty);
+            n_fill_allocations += ProcessVirtualFills();
+            m_mkt.ProcessTrade(record.receive_time, record.exchange_time, direction, record.px, record.qty);
+        }
+        // The strategy may post marketable orders
+        n_fill_allocations += ProcessVirtualFills();
+        if constexpr (TRACK_ALLOCATIONS) {
+            ReplayEvent event = record.type == MarketDataFile::RecordType::OrderBook ? ReplayEvent::OrderBook : ReplayEvent::Trade;
+            m_replay_allocations[static_cast<size_t>(event)].Add(GetThreadAllocations().n_allocations - n_allocations - n_fill_allocations);
+        }
+    }
 }
 
 const ConfigType& Runner::GetConfig() const {
     return m_config;
 }
 
+ConfigType Runner::GetStrategyConfig(int strategy_id) const {
+    std::lock_guard lock(m_strategy_configs_mutex);
+    return m_strategy_configs[strategy_id];
+}
+
+void Runner::SetStrategyConfig(int strategy_id, const ConfigType& config) {
+    assert(0 <= strategy_id && strategy_id < GetStrategyCount());
+    // Not shared with the config of the watcher
+    ConfigType copy = YAML::Clone(config);
+    std::lock_guard lock(m_strategy_configs_mutex);
+    m_strategy_configs[strategy_id] = std::move(copy);
+}
+
+ConfigType Runner::GetStrategyConfig() const {
+    return GetStrategyConfig(m_active_strategy);
+}
+
+int Runner::GetActiveStrategyId() const {
+    return m_active_strategy;
+}
+
+int Runner::GetStrategyCount() const {
+    return m_usr.GetStrategyCount();
+}
+
+RunnerMode Runner::GetMode() const {
+    return m_mode;
+}
+
+const VirtualExchangeStats& Runner::GetBacktestStats() const {
+    assert(m_virtual_exchange);
+    return m_virtual_exchange->GetStats();
+}
+
+const EventAllocations& Runner::GetReplayAllocations(ReplayEvent event) const {
+    return m_replay_allocations[static_cast<size_t>(event)];
+}
+
+void Runner::ResetReplayAllocations() {
+    m_replay_allocations.fill(EventAllocations());
+}
+
 const Instrument& Runner::GetInstrument() const {
     return m_instrument;
 }
@@ -43,8 +308,37 @@ UserConnector& Runner::GetUserConnector() {
     return m_usr;
 }
 
+ConfigWatcher* Runner::GetConfigWatcher() {
+    return m_config_watcher.get();
+}
+
+const RiskGate& Runner::GetRiskGate() const {
+    return m_risk;
+}
+
 InvestApiClient& Runner::GetClient() {
-    return m_client;
+    assert(m_client);
+    return *m_client;
+}
+
+StartupTimeline& Runner::GetStartupTimeline() {
+    return m_startup;
+}
+
+StreamSequencer& Runner::GetSequencer() {
+    return m_sequencer;
+}
+
+const StreamSequencer& Runner::GetSequencer() const {
+    return m_sequencer;
+}
+
+StreamSupervisor& Runner::GetSupervisor() {
+    return *m_supervisor;
+}
+
+VirtualExchange* Runner::GetVirtualExchange() {
+    return m_virtual_exchange.get();
 }
 
 std::shared_ptr<spdlog::logger> Runner::GetLogger(const std::string& name, bool only_text) {
@@ -53,6 +347,13 @@ std::shared_ptr<spdlog::logger> Runner::GetLogger(const std::string& name, bool
         // Logger exists
         return it->second;
     }
+    if (!m_config["runner"]["log_directory"]) {
+        // Backtests run without logs: disabled loggers skip formatting
+        auto logger = std::make_shared<spdlog::logger>(name, std::make_shared<spdlog::sinks::null_sink_st>());
+        logger->set_level(spdlog::level::off);
+        m_loggers[name] = logger;
+        return logger;
+    }
     // Create file
     auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(std::filesystem::path(m_config["runner"]["log_directory"].as<std::string>()) / (name + ".txt"), false);
     if (only_text) {
@@ -63,7 +364,10 @@ std::shared_ptr<spdlog::logger> Runner::GetLogger(const std::string& name, bool
     // Configure logger
     logger->set_level(spdlog::level::trace);
     logger->flush_on(spdlog::level::trace);
-    spdlog::register_logger(logger);
+    // Several runners in one process (shadows) have loggers with the same names: the first one is registered
+    if (!spdlog::get(name)) {
+        spdlog::register_logger(logger);
+    }
     // Store logger
     m_loggers[name] = logger;
     // Return logger
@@ -75,49 +379,439 @@ int Runner::GetPendingEvents() const {
 }
 
 const LimitOrder& Runner::PostOrder(int px, int qty, Direction direction) {
-    return m_usr.PostOrder(px, qty, direction);
+    // Backtests are faster than real time: the order rate is measured in exchange time
+    const TimeType now = m_mode == RunnerMode::Backtest ? m_mkt.GetOrderBook().time : current_time();
+    m_risk.Check(px, qty, direction, now);
+    const LimitOrder& order = m_usr.PostOrder(px, qty, direction, m_active_strategy);
+    // Failed and rejected posts do not count for the order rate
+    m_risk.OnOrderPosted(now);
+    if (m_outage_start != 0 && IsReady()) {
+        // First quote after the outage
+        m_runner_logger->info("Time to quote after outage: {} ms", (current_time() - m_outage_start) / 1'000'000);
+        m_outage_start = 0;
+    }
+    if (!m_startup.IsLogged()) {
+        m_startup.Mark("first order");
+        m_startup.Log(*m_runner_logger);
+    }
+    return order;
 }
 
 void Runner::CancelOrder(const std::string& order_id) {
     m_usr.CancelOrder(order_id);
 }
 
+void Runner::Spawn(OrderTask task) {
+    m_order_tasks.push_back(OrderTaskSlot{.task = std::move(task), .strategy_id = m_active_strategy});
+    // Runs to its first request
+    const size_t index = m_order_tasks.size() - 1;
+    ResumeOrderTask(index);
+    if (const std::exception_ptr error = m_order_tasks[index].task.GetError()) {
+        m_order_tasks.erase(m_order_tasks.begin() + static_cast<std::ptrdiff_t>(index));
+        std::rethrow_exception(error);
+    }
+}
+
+PostAwaitable Runner::Post(int px, int qty, Direction direction) {
+    return PostAwaitable(*this, px, qty, direction);
+}
+
+CancelAwaitable Runner::Cancel(const std::string& order_id) {
+    return CancelAwaitable(*this, order_id);
+}
+
+CancelBatchAwaitable Runner::Cancel(const std::vector<std::string>& order_ids, std::vector<std::exception_ptr>& errors) {
+    return CancelBatchAwaitable(*this, order_ids, errors);
+}
+
+void Runner::DispatchOrderBook(TimeType receive_time, TimeType exchange_time, const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty) {
+    if (m_mode == RunnerMode::Paper) {
+        ProcessPaperOrderBook(receive_time, exchange_time, bid_px, bid_qty, ask_px, ask_qty);
+    } else {
+        m_mkt.ProcessOrderBook(receive_time, exchange_time, bid_px, bid_qty, ask_px, ask_qty);
+    }
+    for (const std::unique_ptr<ShadowFeed>& shadow : m_shadows) {
+        shadow->PushOrderBook(receive_time, exchange_time, bid_px, bid_qty, ask_px, ask_qty);
+    }
+}
+
+void Runner::DispatchTrade(TimeType receive_time, TimeType exchange_time, Direction direction, int px, int qty) {
+    if (m_mode == RunnerMode::Paper) {
+        ProcessPaperTrade(receive_time, exchange_time, direction, px, qty);
+    } else {
+        m_mkt.ProcessTrade(receive_time, exchange_time, direction, px, qty);
+    }
+    for (const std::unique_ptr<ShadowFeed>& shadow : m_shadows) {
+        shadow->PushTrade(receive_time, exchange_time, direction, px, qty);
+    }
+}
+
 void Runner::OnMarketConnectorReady() {
     m_is_mkt_ready = true;
     m_runner_logger->info("MarketConnector is Ready");
-    if (IsReady()) m_strategy->OnConnectorsReadiness();
+    m_startup.Mark("MarketConnector ready");
+    if (IsReady()) OnConnectorsReadiness();
+}
+
+void Runner::OnMarketConnectorLost() {
+    if (m_outage_start == 0) m_outage_start = current_time();
+    m_is_mkt_ready = false;
+    m_runner_logger->warn("MarketConnector is Lost");
 }
 
 void Runner::OnOrderBookUpdate() {
+    if (m_is_requesting) {
+        m_deferred.order_book = true;
+        return;
+    }
     // Notify only if all connectors are ready
-    if (IsReady()) m_strategy->OnOrderBookUpdate();
+    if (IsReady()) NotifyStrategies([](Strategy& strategy) { strategy.OnOrderBookUpdate(); });
 }
 
 void Runner::OnTradesUpdate() {
+    if (m_is_requesting) {
+        m_deferred.trades = true;
+        return;
+    }
+    // Notify only if all connectors are ready
+    if (IsReady()) NotifyStrategies([](Strategy& strategy) { strategy.OnTradesUpdate(); });
+}
+
+void Runner::OnBarClosed(const BarSeries& bars) {
+    if (m_is_requesting) {
+        m_deferred.bars.push_back(&bars);
+        return;
+    }
     // Notify only if all connectors are ready
-    if (IsReady()) m_strategy->OnTradesUpdate();
+    if (IsReady()) NotifyStrategies([&bars](Strategy& strategy) { strategy.OnBarClosed(bars); });
+}
+
+void Runner::OnMarkToMarket(TimeType exchange_time) {
+    m_usr.MarkToMarket(exchange_time);
+}
+
+void Runner::OnPingUpdate() {
+    if (m_is_requesting) {
+        m_deferred.ping = true;
+        return;
+    }
+    // Notify only if all connectors are ready
+    if (IsReady()) NotifyStrategies([](Strategy& strategy) { strategy.OnPingUpdate(); });
 }
 
 void Runner::OnUserConnectorReady() {
     m_is_usr_ready = true;
     m_runner_logger->info("UserConnector is Ready");
-    if (IsReady()) m_strategy->OnConnectorsReadiness();
+    m_startup.Mark("UserConnector ready");
+    if (IsReady()) OnConnectorsReadiness();
+}
+
+void Runner::OnUserConnectorLost() {
+    if (m_outage_start == 0) m_outage_start = current_time();
+    m_is_usr_ready = false;
+    m_runner_logger->warn("UserConnector is Lost");
 }
 
 void Runner::OnOurTrade(const LimitOrder& order, int executed_qty) {
-    // Always notify
-    assert(IsReady() && "Connectors should be ready before order processing");
-    m_strategy->OnOurTrade(order, executed_qty);
+    // Fills are not dropped: without readiness they wait for it. Fills on post wait for the end of the notification that posts
+    if (IsReady() && !m_is_notifying) {
+        NotifyStrategy(order.strategy_id, [&order, executed_qty](Strategy& strategy) { strategy.OnOurTrade(order, executed_qty); });
+    } else {
+        m_runner_logger->info("Our trade is delivered on readiness: executed_qty={}; {}", executed_qty, order);
+        m_pending_our_trades.push_back(PendingOurTrade{.order = order, .executed_qty = executed_qty});
+    }
+}
+
+void Runner::OnOrderUpdate(const LimitOrder& order) {
+    if (m_is_requesting) {
+        m_deferred.AddOrderUpdate(order.order_id);
+        return;
+    }
+    // Notify only if all connectors are ready
+    if (IsReady()) NotifyStrategy(order.strategy_id, [&order](Strategy& strategy) { strategy.OnOrderUpdate(order); });
 }
 
 bool Runner::IsReady() {
-    return m_is_mkt_ready & m_is_usr_ready;
+    return m_is_mkt_ready & m_is_usr_ready & !m_is_halted;
+}
+
+void Runner::WaitForRequests() {
+    while (m_is_requesting) {
+        m_mutex.unlock();
+        std::this_thread::yield();
+        m_mutex.lock();
+    }
+}
+
+void Runner::HaltOnInstrumentMismatch(const std::string& error) {
+    {
+        LockGuard lock = GetEventLock();
+        WaitForRequests();
+        m_is_halted = true;
+        m_runner_logger->error("Stop quoting: {}", error);
+    }
+    // px and qty of the resting orders are in the units of the old metadata. Halted strategies post no orders,
+    // and the events are processed while the cancels are in flight
+    std::vector<std::string> order_ids;
+    std::vector<std::exception_ptr> errors;
+    try {
+        m_usr.CancelAllOrders(order_ids, errors);
+    } catch (const std::exception& e) {
+        m_runner_logger->error("Could not cancel the resting orders: {}", e.what());
+        return;
+    } catch (const ServiceReply&) {
+        m_runner_logger->error("Could not cancel the resting orders: OrdersService error");
+        return;
+    }
+    for (size_t i = 0; i < order_ids.size(); ++i) {
+        if (errors[i]) {
+            m_runner_logger->error("Could not cancel order {} (possible execution)", order_ids[i]);
+        }
+    }
+}
+
+void Runner::OnConnectorsReadiness() {
+    if (m_is_requesting) {
+        m_deferred.readiness = true;
+        return;
+    }
+    if (m_outage_start != 0) {
+        m_runner_logger->info("Connectors are ready after outage of {} ms", (current_time() - m_outage_start) / 1'000'000);
+    }
+    // Fills of the outage reach their strategies before the readiness
+    DeliverPendingOurTrades();
+    NotifyStrategies([](Strategy& strategy) { strategy.OnConnectorsReadiness(); });
+}
+
+void Runner::DeliverPendingOurTrades() {
+    std::vector<PendingOurTrade> our_trades;
+    our_trades.swap(m_pending_our_trades);
+    for (const PendingOurTrade& our_trade : our_trades) {
+        NotifyStrategy(our_trade.order.strategy_id, [&our_trade](Strategy& strategy) { strategy.OnOurTrade(our_trade.order, our_trade.executed_qty); });
+    }
+}
+
+void Runner::DeliverDeferredNotifications() {
+    // The delivered notifications may open another request window: its notifications go to the other buffer
+    // and are delivered by the next iteration, not by the nested notification
+    if (m_is_delivering) {
+        return;
+    }
+    m_is_delivering = true;
+    try {
+        DeliverDeferredRounds();
+    } catch (...) {
+        m_is_delivering = false;
+        m_delivering.Clear();
+        throw;
+    }
+    m_is_delivering = false;
+}
+
+void Runner::DeliverDeferredRounds() {
+    while (m_deferred.Any()) {
+        std::swap(m_delivering, m_deferred);
+        const DeferredNotifications& deferred = m_delivering;
+        m_runner_logger->info("Deliver the notifications of the events processed while the cancels were in flight");
+        // Readiness delivers the fills of the outage first
+        if (deferred.readiness) {
+            OnConnectorsReadiness();
+        }
+        for (size_t i = 0; i < deferred.n_order_updates; ++i) {
+            if (const LimitOrder* order = m_usr.FindOrder(deferred.order_ids[i])) {
+                OnOrderUpdate(*order);
+            }
+        }
+        for (const BarSeries* bars : deferred.bars) {
+            OnBarClosed(*bars);
+        }
+        if (deferred.order_book) {
+            OnOrderBookUpdate();
+        }
+        if (deferred.trades) {
+            OnTradesUpdate();
+        }
+        if (deferred.ping) {
+            OnPingUpdate();
+        }
+        m_delivering.Clear();
+    }
+}
+
+void Runner::SuspendOrderTask(OrderRequest& request) {
+    assert(m_current_task >= 0 && "Post and Cancel are awaited in workflows started by Runner::Spawn");
+    m_order_tasks[m_current_task].request = &request;
+}
+
+void Runner::ResumeOrderTask(size_t index) {
+    // Workflows may spawn workflows. Exceptions of the workflow are kept in its frame
+    const int previous_task = std::exchange(m_current_task, static_cast<int>(index));
+    m_active_strategy = m_order_tasks[index].strategy_id;
+    m_order_tasks[index].request = nullptr;
+    m_order_tasks[index].task.Resume();
+    m_current_task = previous_task;
+}
+
+void Runner::RunOrderTasks() {
+    try {
+        while (true) {
+            std::erase_if(m_order_tasks, [](const OrderTaskSlot& slot) { return slot.task.IsDone(); });
+            if (m_order_tasks.empty()) {
+                return;
+            }
+            if (GetPendingEvents() >= 1) {
+                // The market moved: the next notification spawns new workflows
+                m_runner_logger->info("Cancel {} order workflows: {} events pending", m_order_tasks.size(), GetPendingEvents());
+                m_order_tasks.clear();
+                return;
+            }
+
+            // Cancels of all workflows at once
+            m_cancel_order_ids.clear();
+            for (const OrderTaskSlot& slot : m_order_tasks) {
+                assert(slot.request);
+                if (slot.request->type == OrderRequest::Type::Cancel) {
+                    m_cancel_order_ids.push_back(slot.request->order_id);
+                } else if (slot.request->type == OrderRequest::Type::CancelBatch) {
+                    m_cancel_order_ids.insert(m_cancel_order_ids.end(), slot.request->order_ids->begin(), slot.request->order_ids->end());
+                }
+            }
+            if (!m_cancel_order_ids.empty()) {
+                m_cancel_errors.assign(m_cancel_order_ids.size(), nullptr);
+                m_usr.CancelOrders(m_cancel_order_ids, m_cancel_errors);
+                size_t i = 0;
+                for (OrderTaskSlot& slot : m_order_tasks) {
+                    if (slot.request->type == OrderRequest::Type::Cancel) {
+                        slot.request->error = m_cancel_errors[i++];
+                    } else if (slot.request->type == OrderRequest::Type::CancelBatch) {
+                        std::vector<std::exception_ptr>& errors = *slot.request->errors;
+                        std::copy_n(m_cancel_errors.begin() + i, errors.size(), errors.begin());
+                        i += errors.size();
+                    }
+                }
+                if (m_deferred.Any()) {
+                    // Events were processed while the cancels were in flight: the posts are computed for the old market
+                    m_runner_logger->info("Cancel {} order workflows: events arrived during their cancels", m_order_tasks.size());
+                    m_order_tasks.clear();
+                    return;
+                }
+            }
+
+            // Posts one by one: RiskGate sees the orders posted before
+            for (OrderTaskSlot& slot : m_order_tasks) {
+                OrderRequest& request = *slot.request;
+                if (request.type == OrderRequest::Type::Post) {
+                    m_active_strategy = slot.strategy_id;
+                    try {
+                        request.order = &PostOrder(request.px, request.qty, request.direction);
+                    } catch (...) {
+                        request.error = std::current_exception();
+                    }
+                }
+            }
+
+            // Resume in the order of spawning: workflows spawned on resumption run in the next round
+            const size_t n_tasks = m_order_tasks.size();
+            for (size_t i = 0; i < n_tasks; ++i) {
+                ResumeOrderTask(i);
+                if (const std::exception_ptr error = m_order_tasks[i].task.GetError()) {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+    } catch (...) {
+        // Exception of a workflow: the others are dropped with it
+        m_order_tasks.clear();
+        throw;
+    }
+}
+
+size_t Runner::ProcessVirtualFills() {
+    size_t n_allocations = 0;
+    VirtualFill fill;
+    while (true) {
+        const size_t n_start = GetThreadAllocations().n_allocations;
+        if (!m_virtual_exchange->NextFill(fill)) {
+            break;
+        }
+        {
+            LockGuard lock = GetEventLock();
+            m_usr.ProcessExecution(lock, fill.order_id, fill.px, fill.qty, fill.direction);
+        }
+        if constexpr (TRACK_ALLOCATIONS) {
+            const size_t n_fill = GetThreadAllocations().n_allocations - n_start;
+            m_replay_allocations[static_cast<size_t>(ReplayEvent::Fill)].Add(n_fill);
+            n_allocations += n_fill;
+        }
+    }
+    return n_allocations;
+}
+
+void Runner::ProcessPaperOrderBook(TimeType receive_time, TimeType exchange_time, const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty) {
+    {
+        LockGuard lock = GetEventLock();
+        m_virtual_exchange->OnOrderBook(bid_px, bid_qty, ask_px, ask_qty, m_mkt.GetOrderBook().depth);
+    }
+    ProcessPaperFills();
+    m_mkt.ProcessOrderBook(receive_time, exchange_time, bid_px, bid_qty, ask_px, ask_qty);
+    // The strategy may post marketable orders
+    ProcessPaperFills();
+}
+
+void Runner::ProcessPaperTrade(TimeType receive_time, TimeType exchange_time, Direction direction, int px, int qty) {
+    {
+        LockGuard lock = GetEventLock();
+        m_virtual_exchange->OnTrade(direction, px, qty);
+    }
+    ProcessPaperFills();
+    m_mkt.ProcessTrade(receive_time, exchange_time, direction, px, qty);
+    ProcessPaperFills();
+}
+
+void Runner::ProcessPaperFills() {
+    LockGuard lock = GetEventLock();
+    VirtualFill fill;
+    while (m_virtual_exchange->NextFill(fill)) {
+        m_usr.ProcessExecution(lock, fill.order_id, fill.px, fill.qty, fill.direction);
+    }
 }
 
 LockGuard Runner::GetEventLock() {
     return LockGuard(*this);
 }
 
+void Runner::RecordStagedMessage() {
+    if (m_wire_recorder->HasStaged()) {
+        // In the order of the event lock, but not an event: no pending event, request window or status update
+        std::lock_guard lock(m_mutex);
+        m_wire_recorder->RecordStaged();
+    }
+}
+
+void Runner::ConfigureStreamThread(ThreadRole role) {
+    // Every callback passes here: the thread skips the lock once this runner has seen it
+    thread_local uint64_t configured_runner_id = 0;
+    if (configured_runner_id == m_id) {
+        return;
+    }
+    configured_runner_id = m_id;
+    {
+        // The role map only: not an event
+        std::lock_guard lock(m_mutex);
+        const auto [it, is_new] = m_stream_thread_roles.try_emplace(std::this_thread::get_id(), role);
+        if (!is_new) {
+            if (it->second != role) {
+                m_runner_logger->warn("{} stream shares the thread of the {} stream: the thread keeps its {} placement", ThreadRoleName(role), ThreadRoleName(it->second), ThreadRoleName(it->second));
+            }
+            return;
+        }
+    }
+    ConfigureCurrentThread(m_threading, role, m_runner_logger);
+    if (m_threading.prefault) {
+        PrefaultOrderPools();
+    }
+}
+
 bool LockGuard::NotifyNow() const {
     assert(m_runner.n_pending_events >= 1);
     return m_runner.n_pending_events == 1;
@@ -131,9 +825,19 @@ LockGuard::LockGuard(Runner& runner) : m_runner(runner) {
     assert(m_runner.n_pending_events >= 0);
     ++m_runner.n_pending_events;
     m_runner.m_mutex.lock();
+    if (m_runner.m_is_requesting) {
+        ++m_runner.m_n_request_events;
+    }
+    // Message of the stream callback that takes the lock
+    if (m_runner.m_wire_recorder) {
+        m_runner.m_wire_recorder->RecordStaged();
+    }
 }
 
 LockGuard::~LockGuard() {
+    if (m_runner.m_status) {
+        m_runner.m_status->OnEvent(m_runner.m_is_mkt_ready, m_runner.m_is_usr_ready, m_runner.n_pending_events - 1);
+    }
     --m_runner.n_pending_events;
     m_runner.m_mutex.unlock();
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "shadow_feed.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "runner.h"
+
+ShadowFeed::ShadowFeed(Runner& shadow, int depth, std::shared_ptr<spdlog::logger> logger)
+    : m_shadow(shadow),
+      m_logger(std::move(logger)),
+      m_depth(depth),
+      m_events(CAPACITY) {
+    assert(0 < m_depth && m_depth <= MAX_DEPTH);
+    m_thread = std::jthread([this](std::stop_token stop_token) { Loop(stop_token); });
+}
+
+ShadowFeed::~ShadowFeed() {
+    m_thread.request_stop();
+    m_thread.join();
+    if (m_n_dropped > 0) {
+        m_logger->warn("ShadowFeed: {} messages were dropped", m_n_dropped);
+    }
+}
+
+void ShadowFeed::PushOrderBook(TimeType receive_time, TimeType exchange_time, const int* bid_px, const int* bid_qty, const int* ask_px, const int* ask_qty) {
+    std::unique_lock lock(m_mutex);
+    Event* event = Reserve();
+    if (!event) {
+        return;
+    }
+    event->is_order_book = true;
+    event->receive_time = receive_time;
+    event->exchange_time = exchange_time;
+    std::copy_n(bid_px, m_depth, event->bid_px.begin());
+    std::copy_n(bid_qty, m_depth, event->bid_qty.begin());
+    std::copy_n(ask_px, m_depth, event->ask_px.begin());
+    std::copy_n(ask_qty, m_depth, event->ask_qty.begin());
+    Commit(lock);
+}
+
+void ShadowFeed::PushTrade(TimeType receive_time, TimeType exchange_time, Direction direction, int px, int qty) {
+    std::unique_lock lock(m_mutex);
+    Event* event = Reserve();
+    if (!event) {
+        return;
+    }
+    event->is_order_book = false;
+    event->receive_time = receive_time;
+    event->exchange_time = exchange_time;
+    event->direction = direction;
+    event->px = px;
+    event->qty = qty;
+    Commit(lock);
+}
+
+ShadowFeed::Event* ShadowFeed::Reserve() {
+    if (m_end - m_begin == CAPACITY) {
+        if (m_n_dropped++ == 0) {
+            m_logger->warn("ShadowFeed: the shadow is behind by {} messages, dropping the market data", CAPACITY);
+        }
+        return nullptr;
+    }
+    return &m_events[m_end % CAPACITY];
+}
+
+void ShadowFeed::Commit(std::unique_lock<std::mutex>& lock) {
+    // The shadow waits only on an empty queue
+    const bool was_empty = m_begin == m_end;
+    ++m_end;
+    lock.unlock();
+    if (was_empty) {
+        m_cv.notify_one();
+    }
+}
+
+void ShadowFeed::Loop(std::stop_token stop_token) {
+    while (true) {
+        const Event* event;
+        {
+            std::unique_lock lock(m_mutex);
+            if (!m_cv.wait(lock, stop_token, [this]() { return m_begin != m_end; })) {
+                return;
+            }
+            // The slot is not reused until m_begin moves past it
+            event = &m_events[m_begin % CAPACITY];
+        }
+        try {
+            if (event->is_order_book) {
+                m_shadow.ProcessPaperOrderBook(event->receive_time, event->exchange_time, event->bid_px.data(), event->bid_qty.data(), event->ask_px.data(), event->ask_qty.data());
+            } else {
+                m_shadow.ProcessPaperTrade(event->receive_time, event->exchange_time, event->direction, event->px, event->qty);
+            }
+        } catch (const std::exception& e) {
+            m_logger->error("ShadowFeed: the shadow has thrown: {}", e.what());
+        }
+        std::lock_guard lock(m_mutex);
+        ++m_begin;
+    }
+}
@@ -0,0 +1,91 @@
+#include "startup.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+TimeType ToNanoseconds(const timespec& time) {
+    return static_cast<TimeType>(time.tv_sec) * 1'000'000'000 + time.tv_nsec;
+}
+
+// Start time of the process in nanoseconds since epoch (now if /proc is not available)
+TimeType GetProcessStartTime() {
+    const TimeType now = TscClock::Now();
+    std::ifstream stat_file("/proc/self/stat");
+    std::string stat;
+    if (!std::getline(stat_file, stat) || stat.rfind(')') == std::string::npos) {
+        return now;
+    }
+    // The command name may contain spaces: field 3 follows its closing parenthesis, the start time is field 22
+    std::istringstream fields(stat.substr(stat.rfind(')') + 1));
+    std::string field;
+    for (int i = 3; i < 22; ++i) {
+        fields >> field;
+    }
+    int64_t start_ticks = 0;
+    if (!(fields >> start_ticks)) {
+        return now;
+    }
+    timespec boot_time{};
+    clock_gettime(CLOCK_BOOTTIME, &boot_time);
+    const TimeType start_since_boot = start_ticks * 1'000'000'000 / sysconf(_SC_CLK_TCK);
+    return now - (ToNanoseconds(boot_time) - start_since_boot);
+}
+
+}  // namespace
+
+StartupTimeline::Scope::Scope(StartupTimeline& timeline, std::string name)
+    : m_timeline(timeline), m_name(std::move(name)), m_begin(TscClock::Now()) {}
+
+StartupTimeline::Scope::~Scope() {
+    m_timeline.Record(std::move(m_name), m_begin, TscClock::Now());
+}
+
+StartupTimeline::StartupTimeline() : m_process_start(GetProcessStartTime()) {
+    m_phases.reserve(16);
+}
+
+StartupTimeline::Scope StartupTimeline::Measure(std::string name) {
+    return Scope(*this, std::move(name));
+}
+
+void StartupTimeline::Mark(std::string name) {
+    const TimeType time = TscClock::Now();
+    Record(std::move(name), time, time);
+}
+
+void StartupTimeline::Log(spdlog::logger& logger) {
+    std::vector<Phase> phases;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_is_logged) {
+            return;
+        }
+        m_is_logged = true;
+        phases = std::move(m_phases);
+    }
+    std::stable_sort(phases.begin(), phases.end(), [](const Phase& lhs, const Phase& rhs) { return lhs.begin < rhs.begin; });
+    logger.info("Startup timeline (ms since process start; duration ms):");
+    for (const Phase& phase : phases) {
+        logger.info("  {:>9.3f} {:>9.3f}  {}", (phase.begin - m_process_start) / 1e6, (phase.end - phase.begin) / 1e6, phase.name);
+    }
+}
+
+void StartupTimeline::Discard() {
+    std::lock_guard lock(m_mutex);
+    m_is_logged = true;
+    m_phases.clear();
+}
+
+void StartupTimeline::Record(std::string name, TimeType begin, TimeType end) {
+    std::lock_guard lock(m_mutex);
+    // Phases after the log (reconnections) are not part of the startup
+    if (!m_is_logged) {
+        m_phases.push_back(Phase{.name = std::move(name), .begin = begin, .end = end});
+    }
+}
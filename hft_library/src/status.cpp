@@ -0,0 +1,161 @@
+#include "status.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+StatusPublisher::StatusPublisher(const ConfigType& config, const Instrument& instrument, const MarketConnector& mkt, const UserConnector& usr, const RiskGate& risk, const StreamSequencer& sequencer, std::shared_ptr<spdlog::logger> logger)
+    : m_logger(std::move(logger)),
+      m_instrument(instrument),
+      m_mkt(mkt),
+      m_usr(usr),
+      m_risk(risk),
+      m_sequencer(sequencer),
+      m_path(config["path"].as<std::string>()),
+      m_period(config["period_ms"].as<int64_t>(100) * 1'000'000) {
+    int fd = open(m_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        throw std::runtime_error("Could not open runner.status.path " + m_path + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, sizeof(status::Page)) == -1) {
+        close(fd);
+        throw std::runtime_error("Could not resize runner.status.path " + m_path + ": " + std::strerror(errno));
+    }
+    void* address = mmap(nullptr, sizeof(status::Page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Could not map runner.status.path " + m_path + ": " + std::strerror(errno));
+    }
+    m_page = new (address) status::Page{};
+    // Static fields
+    std::strncpy(m_page->figi, m_instrument.figi.c_str(), sizeof(m_page->figi) - 1);
+    m_page->lot_size = m_instrument.lot_size;
+    m_page->px_step = m_instrument.px_step;
+    // Readers check the magic first
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(m_page->magic, status::MAGIC, sizeof(status::MAGIC));
+    m_logger->info("StatusPublisher: path={}; size={} bytes; period={} ms", m_path, sizeof(status::Page), m_period / 1'000'000);
+}
+
+StatusPublisher::~StatusPublisher() {
+    munmap(m_page, sizeof(status::Page));
+}
+
+void StatusPublisher::Publish(TimeType now, bool is_market_ready, bool is_user_ready, int pending_events) {
+    using status::Store;
+    m_next_publish_time = now + m_period;
+    status::Page& page = *m_page;
+
+    // Odd sequence: the page is being written
+    const uint64_t sequence = page.sequence.load(std::memory_order_relaxed);
+    page.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Store(page.publish_time, now);
+    Store(page.n_publishes, page.n_publishes + 1);
+
+    // Readiness
+    Store(page.is_market_ready, is_market_ready);
+    Store(page.is_user_ready, is_user_ready);
+    Store(page.is_feed_stale, m_mkt.IsFeedStale());
+    Store(page.pending_events, pending_events);
+
+    // Market
+    const MarketOrderBook& order_book = m_mkt.GetOrderBook();
+    Store(page.order_book_time, order_book.time);
+    Store(page.best_bid_px, order_book.bid[0].px);
+    Store(page.best_bid_qty, order_book.bid[0].qty);
+    Store(page.best_ask_px, order_book.ask[0].px);
+    Store(page.best_ask_qty, order_book.ask[0].qty);
+
+    // Positions
+    const Positions& positions = m_usr.GetPositions();
+    Store(page.qty, positions.qty);
+    Store(page.money, positions.money);
+    Store(page.open_buy_qty, positions.open_buy_qty);
+    Store(page.open_sell_qty, positions.open_sell_qty);
+    Store(page.open_buy_notional, positions.open_buy_notional);
+
+    // PnL
+    const PnL pnl = m_usr.GetPnL().GetPnL();
+    Store(page.realized, pnl.realized);
+    Store(page.unrealized, pnl.unrealized);
+    Store(page.fees, pnl.fees);
+    Store(page.total, pnl.total);
+    Store(page.exposure, pnl.exposure);
+    Store(page.avg_px, pnl.avg_px);
+    Store(page.mid_px, pnl.mid_px);
+    Store(page.turnover, pnl.turnover);
+    Store(page.volume, pnl.volume);
+    Store(page.n_fills, pnl.n_fills);
+
+    // Latency
+    PublishLatencies();
+
+    // Counters
+    const NotificationStats& notifications = m_mkt.GetNotificationStats();
+    Store(page.n_events, m_n_events);
+    Store(page.n_orderbooks, static_cast<int64_t>(notifications.n_orderbooks));
+    Store(page.n_orderbook_skips, static_cast<int64_t>(notifications.n_orderbook_skips));
+    Store(page.n_trades, static_cast<int64_t>(notifications.n_trades));
+    Store(page.n_trade_skips, static_cast<int64_t>(notifications.n_trade_skips));
+    Store(page.n_risk_checks, static_cast<int64_t>(m_risk.GetChecks()));
+    for (size_t i = 0; i < static_cast<size_t>(RiskRule::Count); ++i) {
+        Store(page.n_risk_rejects[i], static_cast<int64_t>(m_risk.GetRejects(static_cast<RiskRule>(i))));
+    }
+    for (size_t i = 0; i < static_cast<size_t>(StreamAnomaly::Count); ++i) {
+        Store(page.n_stream_anomalies[i], static_cast<int64_t>(m_sequencer.GetAnomalies(static_cast<StreamAnomaly>(i))));
+    }
+    Store(page.n_ladder_dropped_levels, static_cast<int64_t>(m_mkt.GetLadder().GetDroppedLevels()));
+
+    // Resting orders of all strategies: at most MAX_ORDERS are visited
+    size_t n_orders = 0;
+    size_t n_copied = 0;
+    for (int strategy_id = 0; strategy_id < m_usr.GetStrategyCount(); ++strategy_id) {
+        const auto& orders = m_usr.GetPositions(strategy_id).orders;
+        n_orders += orders.size();
+        for (auto it = orders.begin(); it != orders.end() && n_copied < status::MAX_ORDERS; ++it, ++n_copied) {
+            const LimitOrder& order = it->second;
+            status::Order& slot = page.orders[n_copied];
+            Store(slot.px, order.px);
+            Store(slot.qty, order.qty);
+            Store(slot.direction, order.direction == Direction::Buy ? 1 : -1);
+            Store(slot.status, static_cast<int32_t>(order.status));
+        }
+    }
+    Store(page.n_orders, static_cast<int64_t>(n_orders));
+
+    // Even sequence: the page is consistent
+    std::atomic_thread_fence(std::memory_order_release);
+    page.sequence.store(sequence + 2, std::memory_order_relaxed);
+}
+
+void StatusPublisher::PublishLatencies() {
+    using status::Store;
+    status::Page& page = *m_page;
+    Store(page.clock_offset, m_mkt.GetClockOffset());
+    Store(page.feed_latency, m_mkt.GetFeedLatency());
+    const LatencyTracker* trackers[status::N_LATENCIES] = {&m_mkt.GetOrderBookLatency(), &m_mkt.GetTradesLatency(), &m_mkt.GetPingLatency(), &m_usr.GetOrdersStreamLatency()};
+    for (size_t i = 0; i < status::N_LATENCIES; ++i) {
+        const LatencyTracker& tracker = *trackers[i];
+        status::Latency& latency = page.latencies[i];
+        const size_t count = tracker.GetCount();
+        if (count == m_n_published_samples[i]) {
+            continue;
+        }
+        // New samples only: the older ones are already in the page
+        for (size_t index = std::max(m_n_published_samples[i], count > status::LATENCY_WINDOW ? count - status::LATENCY_WINDOW : 0); index < count; ++index) {
+            Store(latency.samples[index % status::LATENCY_WINDOW], tracker.GetSample(index));
+        }
+        m_n_published_samples[i] = count;
+        Store(latency.count, static_cast<int64_t>(count));
+        Store(latency.last, tracker.GetLast());
+        Store(latency.min, tracker.GetMin());
+    }
+}
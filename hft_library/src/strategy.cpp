@@ -4,9 +4,14 @@
 Strategy::Strategy(Runner& runner)
         :
         m_runner(runner),
-        m_logger(runner.GetLogger("strategy", false)),
+        m_strategy_id(runner.GetActiveStrategyId()),
+        m_logger(runner.GetLogger(m_strategy_id == 0 ? "strategy" : "strategy_" + std::to_string(m_strategy_id), false)),
         m_config(runner.GetConfig()),
         m_instrument(runner.GetInstrument()),
         m_order_book(runner.GetMarketConnector().GetOrderBook()),
+        m_ladder(runner.GetMarketConnector().GetLadder()),
         m_trades(runner.GetMarketConnector().GetTrades()),
-        m_positions(runner.GetUserConnector().GetPositions()) {}
+        m_bars(runner.GetMarketConnector().GetBars()),
+        m_streams(runner.GetSequencer()),
+        m_positions(runner.GetUserConnector().GetPositions(m_strategy_id)),
+        m_pnl(runner.GetUserConnector().GetPnL()) {}
@@ -0,0 +1,109 @@
+#include "supervisor.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr auto CHECK_PERIOD = std::chrono::milliseconds(100);
+
+}  // namespace
+
+const char* StreamTypeName(StreamType type) {
+    switch (type) {
+        case StreamType::OrderBook:
+            return "OrderBookStream";
+        case StreamType::Trades:
+            return "TradeStream";
+        case StreamType::Orders:
+            return "OrderStream";
+    }
+    assert(false && "Unreachable");
+    return "";
+}
+
+StreamSupervisor::StreamSupervisor(const ConfigType& config, std::shared_ptr<spdlog::logger> logger)
+    : m_logger(std::move(logger)),
+      m_enabled(config["enabled"].as<bool>(true)),
+      m_silence_timeout(static_cast<TimeType>(config["silence_timeout_s"].as<int>(180)) * 1'000'000'000),
+      m_min_backoff(static_cast<TimeType>(config["min_backoff_ms"].as<int>(100)) * 1'000'000),
+      m_max_backoff(static_cast<TimeType>(config["max_backoff_ms"].as<int>(10'000)) * 1'000'000) {
+    assert(m_min_backoff > 0);
+    assert(m_min_backoff <= m_max_backoff);
+}
+
+void StreamSupervisor::Register(StreamType type, ReconnectFunction reconnect) {
+    StreamState& stream = m_streams[static_cast<int>(type)];
+    stream.reconnect = std::move(reconnect);
+    stream.last_message_time = TscClock::Now();
+}
+
+void StreamSupervisor::Start() {
+    if (!m_enabled) {
+        m_logger->warn("StreamSupervisor is disabled");
+        return;
+    }
+    m_logger->info("Start StreamSupervisor: silence_timeout={} s", m_silence_timeout / 1'000'000'000);
+    m_thread = std::jthread([this](std::stop_token stop_token) { Loop(stop_token); });
+}
+
+void StreamSupervisor::OnFailure(StreamType type) {
+    m_logger->error("{} failed", StreamTypeName(type));
+    m_streams[static_cast<int>(type)].is_failed = true;
+}
+
+void StreamSupervisor::Loop(std::stop_token stop_token) {
+    while (!stop_token.stop_requested()) {
+        std::this_thread::sleep_for(CHECK_PERIOD);
+        TimeType now = TscClock::Now();
+        for (int i = 0; i < N_STREAMS; ++i) {
+            if (m_streams[i].reconnect) {
+                Check(static_cast<StreamType>(i), now);
+            }
+        }
+    }
+}
+
+void StreamSupervisor::Check(StreamType type, TimeType now) {
+    StreamState& stream = m_streams[static_cast<int>(type)];
+    TimeType last_message_time = stream.last_message_time.load(std::memory_order_relaxed);
+    bool is_failed = stream.is_failed.load();
+
+    if (stream.n_attempts > 0 && !is_failed && last_message_time > stream.reconnect_time) {
+        // Messages arrive after the last reconnect
+        m_logger->info("{} is restored after {} ms and {} attempts", StreamTypeName(type), (now - stream.outage_start) / 1'000'000, stream.n_attempts);
+        stream.outage_start = 0;
+        stream.n_attempts = 0;
+    }
+
+    // Detect failure or silence
+    bool is_silent = now - last_message_time > m_silence_timeout;
+    if (!is_failed && !is_silent) {
+        return;
+    }
+    if (stream.outage_start == 0) {
+        m_logger->error("{} is lost: failed={}; silent for {} ms", StreamTypeName(type), is_failed, (now - last_message_time) / 1'000'000);
+        stream.outage_start = now;
+    }
+    if (now < stream.next_attempt_time) {
+        return;
+    }
+
+    // Reconnect with exponential backoff
+    ++stream.n_attempts;
+    TimeType backoff = std::min(m_max_backoff, m_min_backoff << std::min(stream.n_attempts - 1, 20));
+    m_logger->warn("Reconnect {}: attempt {}", StreamTypeName(type), stream.n_attempts);
+    stream.is_failed = false;
+    try {
+        stream.reconnect();
+    } catch (const std::exception& exc) {
+        m_logger->error("Reconnect {} failed: {}", StreamTypeName(type), exc.what());
+        stream.is_failed = true;
+    } catch (...) {
+        m_logger->error("Reconnect {} failed", StreamTypeName(type));
+        stream.is_failed = true;
+    }
+    // Restart silence timer
+    stream.reconnect_time = TscClock::Now();
+    stream.last_message_time = stream.reconnect_time;
+    stream.next_attempt_time = stream.reconnect_time + backoff;
+}
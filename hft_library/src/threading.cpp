@@ -0,0 +1,112 @@
+#include "threading.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace {
+
+constexpr size_t PREFAULT_PAGE_SIZE = 4096;
+constexpr size_t PREFAULT_STACK_SIZE = 256 * 1024;
+
+}  // namespace
+
+const char* ThreadRoleName(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::MarketData:
+            return "market_data";
+        case ThreadRole::Orders:
+            return "orders";
+        case ThreadRole::Strategy:
+            return "strategy";
+    }
+    assert(false && "Unreachable");
+    return "";
+}
+
+ThreadingConfig::ThreadingConfig(const ConfigType& config)
+    : market_data_cpu(config["market_data_cpu"].as<int>(-1)),
+      orders_cpu(config["orders_cpu"].as<int>(-1)),
+      strategy_cpu(config["strategy_cpu"].as<int>(-1)),
+      realtime_priority(config["realtime_priority"].as<int>(0)),
+      lock_memory(config["lock_memory"].as<bool>(false)),
+      prefault(config["prefault"].as<bool>(false)) {
+    assert(realtime_priority >= 0);
+}
+
+int ThreadingConfig::GetCpu(ThreadRole role) const {
+    switch (role) {
+        case ThreadRole::MarketData:
+            return market_data_cpu;
+        case ThreadRole::Orders:
+            return orders_cpu;
+        case ThreadRole::Strategy:
+            return strategy_cpu;
+    }
+    assert(false && "Unreachable");
+    return -1;
+}
+
+void ConfigureCurrentThread(const ThreadingConfig& config, ThreadRole role, std::shared_ptr<spdlog::logger> logger) {
+    const char* name = ThreadRoleName(role);
+    pthread_t thread = pthread_self();
+
+    // Pin to cpu
+    int cpu = config.GetCpu(role);
+    if (cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        if (int error = pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set); error != 0) {
+            logger->warn("Thread {}: failed to pin to cpu {}: {}", name, cpu, std::strerror(error));
+        }
+    }
+
+    // Set real-time scheduling
+    if (config.realtime_priority > 0) {
+        sched_param param{.sched_priority = config.realtime_priority};
+        if (int error = pthread_setschedparam(thread, SCHED_FIFO, &param); error != 0) {
+            logger->warn("Thread {}: failed to set SCHED_FIFO priority {}: {}", name, config.realtime_priority, std::strerror(error));
+        }
+    }
+
+    if (config.prefault) {
+        PrefaultStack();
+    }
+
+    // Report placement
+    int policy;
+    sched_param param{};
+    pthread_getschedparam(thread, &policy, &param);
+    logger->info("Thread {}: tid={}; cpu={} (requested {}); policy={}; priority={}",
+                 name, gettid(), sched_getcpu(), cpu, policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_OTHER", param.sched_priority);
+}
+
+void LockMemory(std::shared_ptr<spdlog::logger> logger) {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        logger->warn("mlockall failed: {}", std::strerror(errno));
+    } else {
+        logger->info("mlockall: success");
+    }
+}
+
+void Prefault(void* ptr, size_t size) {
+    // Write the byte back: a read maps the untouched page to the shared zero page and faults again on the first write
+    volatile char* begin = static_cast<volatile char*>(ptr);
+    for (size_t offset = 0; offset < size; offset += PREFAULT_PAGE_SIZE) {
+        begin[offset] = begin[offset];
+    }
+    if (size > 0) {
+        begin[size - 1] = begin[size - 1];
+    }
+}
+
+void PrefaultStack() {
+    char stack[PREFAULT_STACK_SIZE];
+    std::memset(stack, 0, sizeof(stack));
+    // Keep the stores: the buffer is not read
+    asm volatile("" : : "r"(stack) : "memory");
+}
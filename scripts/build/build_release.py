@@ -0,0 +1,73 @@
+"""
+Production build: no sanitizers, LTO, -march and profile-guided optimization trained on a recorded day.
+1. Configure the build directory with HFT_PGO=generate and build replay_benchmark
+2. Replay the day through GridTrading to collect the profile
+3. Reconfigure the same directory with HFT_PGO=use and build all targets
+
+Usage (from the repository root):
+    python scripts/build/build_release.py private/sweep.yaml data/day.bin [--build-dir build-release] [--no-pgo]
+"""
+import argparse
+import shutil
+import subprocess
+from pathlib import Path
+
+
+def run(*command: str) -> None:
+    print("$", " ".join(command), flush=True)
+    subprocess.run(command, check=True)
+
+
+def configure(build_dir: Path, pgo: str, extra: list[str]) -> None:
+    run("cmake", "-S", ".", "-B", str(build_dir), "-DCMAKE_BUILD_TYPE=Release", f"-DHFT_PGO={pgo}", *extra)
+
+
+def build(build_dir: Path, *targets: str) -> None:
+    command = ["cmake", "--build", str(build_dir), "-j"]
+    for target in targets:
+        command += ["--target", target]
+    run(*command)
+
+
+def get_compiler_id(build_dir: Path) -> str:
+    for line in (build_dir / "CMakeCache.txt").read_text().splitlines():
+        if line.startswith("CMAKE_CXX_COMPILER_ID:"):
+            return line.split("=", 1)[1]
+    return ""
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("config", help="replay_benchmark config (runner, backtest, strategy)")
+    parser.add_argument("data", help="training day from convert_market_data")
+    parser.add_argument("--build-dir", default="build-release")
+    parser.add_argument("--runs", default="3", help="replays of the training day")
+    parser.add_argument("--no-pgo", action="store_true")
+    parser.add_argument("--cmake-arg", action="append", default=[], dest="cmake_args", help="extra cmake argument")
+    args = parser.parse_args()
+    build_dir = Path(args.build_dir)
+
+    if args.no_pgo:
+        configure(build_dir, "off", args.cmake_args)
+        build(build_dir)
+        return
+
+    # Instrumented build
+    pgo_dir = build_dir / "pgo"
+    configure(build_dir, "generate", args.cmake_args)
+    shutil.rmtree(pgo_dir, ignore_errors=True)
+    build(build_dir, "replay_benchmark")
+
+    # Training
+    run(str(build_dir / "hft_library" / "exe" / "replay_benchmark"), args.config, args.data, args.runs)
+    if get_compiler_id(build_dir) == "Clang":
+        profiles = [str(path) for path in pgo_dir.glob("*.profraw")]
+        run("llvm-profdata", "merge", f"-output={pgo_dir / 'default.profdata'}", *profiles)
+
+    # Optimized build: the object paths must match the instrumented build
+    configure(build_dir, "use", args.cmake_args)
+    build(build_dir)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,55 @@
+"""
+Compare replay_benchmark of two build directories on the same day.
+
+Usage (from the repository root):
+    python scripts/build/compare_builds.py private/sweep.yaml data/day.bin build-sanitize build-release [--runs 5]
+"""
+import argparse
+import subprocess
+from pathlib import Path
+
+METRICS = [
+    "throughput_median",
+    "throughput_max",
+    "latency_p50_ns",
+    "latency_p90_ns",
+    "latency_p99_ns",
+    "latency_p999_ns",
+    "latency_max_ns",
+]
+
+
+def run_benchmark(build_dir: str, config: str, data: str, runs: str) -> dict[str, float]:
+    executable = Path(build_dir) / "hft_library" / "exe" / "replay_benchmark"
+    output = subprocess.run([str(executable), config, data, runs], check=True, capture_output=True, text=True).stdout
+    result = {}
+    for line in output.splitlines():
+        if "=" in line:
+            name, value = line.split("=", 1)
+            result[name] = float(value)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("config")
+    parser.add_argument("data")
+    parser.add_argument("baseline", help="build directory, e.g. the sanitized build")
+    parser.add_argument("candidate", help="build directory, e.g. the release build")
+    parser.add_argument("--runs", default="5")
+    args = parser.parse_args()
+
+    baseline = run_benchmark(args.baseline, args.config, args.data, args.runs)
+    candidate = run_benchmark(args.candidate, args.config, args.data, args.runs)
+    if baseline["fills"] != candidate["fills"]:
+        print(f"Warning: builds differ in fills: {baseline['fills']:.0f} vs {candidate['fills']:.0f}")
+
+    width = max(20, len(args.baseline) + 2, len(args.candidate) + 2)
+    print(f"{'metric':<20}{args.baseline:>{width}}{args.candidate:>{width}}{'ratio':>10}")
+    for metric in METRICS:
+        ratio = candidate[metric] / baseline[metric] if baseline[metric] else float("nan")
+        print(f"{metric:<20}{baseline[metric]:>{width}.0f}{candidate[metric]:>{width}.0f}{ratio:>10.2f}")
+
+
+if __name__ == "__main__":
+    main()
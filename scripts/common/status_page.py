@@ -0,0 +1,223 @@
+import mmap
+import struct
+import time
+from dataclasses import dataclass
+
+# Mirror of status::Page in hft_library/include/status.h
+MAGIC = b"HFTST01\0"
+N_LATENCIES = 4
+LATENCY_WINDOW = 4096  # LatencyTracker::WINDOW
+LATENCY_NAMES = ["OrderBook", "Trades", "Ping", "OrdersStream"]
+RISK_RULES = ["OrderQty", "OrderNotional", "Position", "Money", "Short", "OrderRate", "Collar", "Distance", "Loss", "SelfMatch"]
+STREAM_ANOMALIES = ["OrderBookOutOfOrder", "OrderBookStale", "TradeOutOfOrder", "FillDuplicate", "BookBehindFill"]
+MAX_ORDERS = 64
+ORDER_STATUSES = ["PendingNew", "Live", "PartiallyFilled", "PendingCancel", "Done"]
+
+HEADER_FORMAT = "<8sQqq16siid" + "iiii" + "qiiii" + "iiiiq" + "ddddddd" + "qqq" + "qq" + f"qqq{LATENCY_WINDOW}q" * N_LATENCIES + "qqqqqq" + "q" * len(RISK_RULES) + "q" * len(STREAM_ANOMALIES) + "qq"
+ORDER_FORMAT = "<iiii"
+PAGE_SIZE = struct.calcsize(HEADER_FORMAT) + MAX_ORDERS * struct.calcsize(ORDER_FORMAT)
+SEQUENCE_OFFSET = 8
+assert PAGE_SIZE == 132600, PAGE_SIZE
+
+
+@dataclass
+class Latency:
+    count: int
+    last: int  # in ns: without the clock offset correction
+    min: int
+    p50: int  # of the last min(count, LATENCY_WINDOW) samples
+    p99: int
+
+    @staticmethod
+    def from_samples(count: int, last: int, min_latency: int, samples: list[int]) -> "Latency":
+        # The publisher copies the samples only; percentiles as in LatencyTracker::GetPercentile
+        window = sorted(samples[: min(count, LATENCY_WINDOW)])
+
+        def percentile(q: float) -> int:
+            return window[int(q * (len(window) - 1))] if window else 0
+
+        return Latency(count, last, min_latency, percentile(0.5), percentile(0.99))
+
+
+@dataclass
+class Order:
+    px: int  # real_px / px_step
+    qty: int  # in lots
+    direction: int  # 1 if Buy; -1 if Sell
+    status: str
+
+
+@dataclass
+class Status:
+    publish_time: int  # ns since epoch
+    n_publishes: int
+    figi: str
+    lot_size: int
+    px_step: float
+    is_market_ready: bool
+    is_user_ready: bool
+    is_feed_stale: bool
+    pending_events: int
+    order_book_time: int
+    best_bid_px: int
+    best_bid_qty: int
+    best_ask_px: int
+    best_ask_qty: int
+    qty: int
+    money: int  # real_money / (lot * px_step)
+    open_buy_qty: int
+    open_sell_qty: int
+    open_buy_notional: int
+    realized: float
+    unrealized: float
+    fees: float
+    total: float
+    exposure: float
+    avg_px: float
+    mid_px: float
+    turnover: int
+    volume: int
+    n_fills: int
+    clock_offset: int
+    feed_latency: int
+    latencies: dict[str, Latency]
+    n_events: int
+    n_orderbooks: int
+    n_orderbook_skips: int
+    n_trades: int
+    n_trade_skips: int
+    n_risk_checks: int
+    n_risk_rejects: dict[str, int]
+    n_stream_anomalies: dict[str, int]  # StreamSequencer
+    n_ladder_dropped_levels: int  # PriceLadder
+    orders: list[Order]
+    n_orders: int  # may exceed len(orders)
+
+    def to_real_money(self, money: float) -> float:
+        return money * self.lot_size * self.px_step
+
+    def to_real_px(self, px: float) -> float:
+        return px * self.px_step
+
+
+class StatusPageReader:
+    """Read the page published by the Runner (runner.status.path) without broker calls"""
+
+    MAX_ATTEMPTS = 1000
+
+    def __init__(self, path: str) -> None:
+        self.file = open(path, "rb")
+        self.page = mmap.mmap(self.file.fileno(), PAGE_SIZE, access=mmap.ACCESS_READ)
+
+    def close(self) -> None:
+        self.page.close()
+        self.file.close()
+
+    def _sequence(self) -> int:
+        return struct.unpack_from("<Q", self.page, SEQUENCE_OFFSET)[0]
+
+    def read(self) -> Status:
+        # Seqlock: retry while the page is written
+        for _ in range(self.MAX_ATTEMPTS):
+            sequence = self._sequence()
+            if sequence % 2 == 1:
+                time.sleep(0)
+                continue
+            data = self.page[:PAGE_SIZE]
+            if self._sequence() == sequence:
+                break
+        else:
+            raise RuntimeError("Could not read a consistent status page")
+        if data[:8] != MAGIC:
+            raise RuntimeError("Status page is not initialized")
+        return self._parse(data)
+
+    @staticmethod
+    def _parse(data: bytes) -> Status:
+        values = list(struct.unpack_from(HEADER_FORMAT, data))
+        values.reverse()
+        pop = values.pop
+
+        def pop_n(n: int) -> list:
+            return [pop() for _ in range(n)]
+
+        pop_n(2)  # magic, sequence
+        publish_time, n_publishes = pop_n(2)
+        figi = pop().rstrip(b"\0").decode()
+        lot_size, _, px_step = pop_n(3)
+        is_market_ready, is_user_ready, is_feed_stale, pending_events = pop_n(4)
+        order_book_time, best_bid_px, best_bid_qty, best_ask_px, best_ask_qty = pop_n(5)
+        qty, money, open_buy_qty, open_sell_qty, open_buy_notional = pop_n(5)
+        realized, unrealized, fees, total, exposure, avg_px, mid_px = pop_n(7)
+        turnover, volume, n_fills = pop_n(3)
+        clock_offset, feed_latency = pop_n(2)
+        latencies = {name: Latency.from_samples(*pop_n(3), pop_n(LATENCY_WINDOW)) for name in LATENCY_NAMES}
+        n_events, n_orderbooks, n_orderbook_skips, n_trades, n_trade_skips, n_risk_checks = pop_n(6)
+        n_risk_rejects = {rule: pop() for rule in RISK_RULES}
+        n_stream_anomalies = {anomaly: pop() for anomaly in STREAM_ANOMALIES}
+        n_ladder_dropped_levels, n_orders = pop_n(2)
+        assert not values
+
+        orders = []
+        offset = struct.calcsize(HEADER_FORMAT)
+        for i in range(min(n_orders, MAX_ORDERS)):
+            px, order_qty, direction, status = struct.unpack_from(ORDER_FORMAT, data, offset + i * struct.calcsize(ORDER_FORMAT))
+            orders.append(Order(px, order_qty, direction, ORDER_STATUSES[status]))
+
+        return Status(
+            publish_time=publish_time,
+            n_publishes=n_publishes,
+            figi=figi,
+            lot_size=lot_size,
+            px_step=px_step,
+            is_market_ready=bool(is_market_ready),
+            is_user_ready=bool(is_user_ready),
+            is_feed_stale=bool(is_feed_stale),
+            pending_events=pending_events,
+            order_book_time=order_book_time,
+            best_bid_px=best_bid_px,
+            best_bid_qty=best_bid_qty,
+            best_ask_px=best_ask_px,
+            best_ask_qty=best_ask_qty,
+            qty=qty,
+            money=money,
+            open_buy_qty=open_buy_qty,
+            open_sell_qty=open_sell_qty,
+            open_buy_notional=open_buy_notional,
+            realized=realized,
+            unrealized=unrealized,
+            fees=fees,
+            total=total,
+            exposure=exposure,
+            avg_px=avg_px,
+            mid_px=mid_px,
+            turnover=turnover,
+            volume=volume,
+            n_fills=n_fills,
+            clock_offset=clock_offset,
+            feed_latency=feed_latency,
+            latencies=latencies,
+            n_events=n_events,
+            n_orderbooks=n_orderbooks,
+            n_orderbook_skips=n_orderbook_skips,
+            n_trades=n_trades,
+            n_trade_skips=n_trade_skips,
+            n_risk_checks=n_risk_checks,
+            n_risk_rejects=n_risk_rejects,
+            n_stream_anomalies=n_stream_anomalies,
+            n_ladder_dropped_levels=n_ladder_dropped_levels,
+            orders=orders,
+            n_orders=n_orders,
+        )
+
+
+def main():
+    import sys
+
+    reader = StatusPageReader(sys.argv[1] if len(sys.argv) > 1 else "/dev/shm/hft_status")
+    print(reader.read())
+    reader.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,24 @@
+"""
+Reader of bars.txt — OHLCV bars of the trade stream written by MarketConnector (market.bar_log: true).
+
+Columns: resolution_s, start_time (exchange time in ns), open, high, low, close (px steps),
+volume, buy_volume (lots), turnover (sum of px * qty), n_trades.
+Intervals without trades have no bars.
+"""
+from pathlib import Path
+
+import pandas as pd
+
+
+def load_bars(path: Path) -> dict[int, pd.DataFrame]:
+    """Bars by resolution in seconds, indexed by start_time"""
+    bars = pd.read_csv(path)
+    # Keep the first run if the log file contains several runs
+    restarts = bars.index[bars["resolution_s"] == "resolution_s"]
+    if len(restarts) > 0:
+        bars = bars.iloc[:restarts[0]].astype(int)
+    bars["vwap"] = bars["turnover"] / bars["volume"]
+    return {
+        int(resolution): group.drop(columns="resolution_s").set_index("start_time")
+        for resolution, group in bars.groupby("resolution_s")
+    }
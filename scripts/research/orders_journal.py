@@ -0,0 +1,74 @@
+"""
+Reader of orders.txt — the journal of our resting orders written by UserConnector.
+
+Events (rows with the same internal_log_id belong to one event of UserConnector):
+    add             — new order, qty is the order qty
+    reduce          — order is executed, qty is the remaining qty
+    remove          — order is cancelled, filled or rejected
+    snapshot        — the full order set follows, qty is the number of orders
+    snapshot_order  — order of the snapshot
+"""
+from pathlib import Path
+
+import pandas as pd
+
+COLUMNS = ["internal_log_id", "strategy_time", "order_id", "direction", "px", "qty"]
+
+
+def load_orders_journal(path: Path) -> pd.DataFrame:
+    journal = pd.read_csv(path, keep_default_na=False)
+    # Keep the first run if the log file contains several runs
+    restarts = journal.index[journal["internal_log_id"] == "internal_log_id"]
+    if len(restarts) > 0:
+        journal = journal.iloc[:restarts[0]]
+    journal = journal.astype({"internal_log_id": int, "strategy_time": int, "px": int, "qty": int})
+    return journal.reset_index(drop=True)
+
+
+def _apply(orders: dict, row) -> None:
+    if row.event == "snapshot":
+        orders.clear()
+    elif row.event in ("add", "reduce", "snapshot_order"):
+        orders[row.order_id] = (row.direction, row.px, row.qty)
+    elif row.event == "remove":
+        orders.pop(row.order_id, None)
+    else:
+        raise ValueError(f"Unknown event: {row.event}")
+
+
+def orders_at(journal: pd.DataFrame, internal_log_id: int) -> pd.DataFrame:
+    """Resting orders after the event internal_log_id. Replay starts from the last snapshot"""
+    rows = journal[journal["internal_log_id"] <= internal_log_id]
+    snapshots = rows.index[rows["event"] == "snapshot"]
+    if len(snapshots) > 0:
+        rows = rows.loc[snapshots[-1]:]
+    orders = {}
+    for row in rows.itertuples(index=False):
+        _apply(orders, row)
+    return pd.DataFrame(
+        [(order_id, direction, px, qty) for order_id, (direction, px, qty) in orders.items()],
+        columns=["order_id", "direction", "px", "qty"],
+    )
+
+
+def expand_orders_journal(journal: pd.DataFrame) -> pd.DataFrame:
+    """Full order set after each event: the format of the old orders.txt"""
+    orders = {}
+    result = []
+    rows = list(journal.itertuples(index=False))
+    for i, row in enumerate(rows):
+        _apply(orders, row)
+        if i + 1 == len(rows) or rows[i + 1].internal_log_id != row.internal_log_id:
+            for order_id, (direction, px, qty) in orders.items():
+                result.append((row.internal_log_id, row.strategy_time, order_id, direction, px, qty))
+    return pd.DataFrame(result, columns=COLUMNS)
+
+
+if __name__ == "__main__":
+    import sys
+
+    journal = load_orders_journal(Path(sys.argv[1]))
+    last_id = int(journal["internal_log_id"].iloc[-1])
+    print(f"Events: {journal['internal_log_id'].nunique()}; rows: {len(journal)}")
+    print(f"Orders after internal_log_id={last_id}:")
+    print(orders_at(journal, last_id))
@@ -0,0 +1,46 @@
+"""
+Reader of the results of grid_sweep (SweepResultsFile in hft_library/include/backtest/sweep_results.h).
+
+Layout: header (magic, n_parameters, reserved, n_results), parameter names of 32 bytes,
+then one record per configuration: int32 values of the parameters followed by the results.
+"""
+import sys
+from pathlib import Path
+
+import numpy as np
+import pandas as pd
+
+MAGIC = b"HFTSW01"
+NAME_SIZE = 32
+HEADER = np.dtype([("magic", "S8"), ("n_parameters", "<i4"), ("reserved", "<i4"), ("n_results", "<i8")])
+RESULT_FIELDS = [
+    ("pnl", "<f8"),
+    ("turnover", "<i8"),
+    ("filled_qty", "<i8"),
+    ("ok", "<i4"),
+    ("n_fills", "<i4"),
+    ("n_posts", "<i4"),
+    ("n_cancels", "<i4"),
+    ("max_inventory", "<i4"),
+    ("final_qty", "<i4"),
+]
+
+
+def load_sweep_results(path: Path) -> pd.DataFrame:
+    data = Path(path).read_bytes()
+    header = np.frombuffer(data, dtype=HEADER, count=1)[0]
+    if header["magic"] != MAGIC:
+        raise ValueError(f"Not a sweep results file: {path}")
+    n_parameters = int(header["n_parameters"])
+    offset = HEADER.itemsize
+    names = [data[offset + i * NAME_SIZE:offset + (i + 1) * NAME_SIZE].rstrip(b"\0").decode() for i in range(n_parameters)]
+    offset += n_parameters * NAME_SIZE
+    record = np.dtype([(name, "<i4") for name in names] + RESULT_FIELDS)
+    results = np.frombuffer(data, dtype=record, count=int(header["n_results"]), offset=offset)
+    frame = pd.DataFrame(results)
+    frame["ok"] = frame["ok"].astype(bool)
+    return frame
+
+
+if __name__ == "__main__":
+    print(load_sweep_results(Path(sys.argv[1] if len(sys.argv) > 1 else "sweep.bin")).sort_values("pnl", ascending=False).to_string())
@@ -4,6 +4,7 @@ import os
 sys.path.append(os.getcwd())
 
 from scripts.common.utils import read_config, quotation_to_float, to_moscow
+from scripts.common.status_page import StatusPageReader, Status
 
 import tinkoff.invest as inv
 import pandas as pd
@@ -123,6 +124,9 @@ class TinkoffTask:
         self.old_positions = None
         self.old_orders = {}
         self.all_orders = {}
+        # Read positions and orders from the page of the Runner (runner.status.path) instead of the API
+        status_path = config["runner"].get("status", {}).get("path")
+        self.status_reader = StatusPageReader(status_path) if config["telegram"].get("use_status_page", False) and status_path else None
 
     ########################################################
     # Read Positions from Tinkoff
@@ -167,6 +171,21 @@ class TinkoffTask:
             self.ask_orders = self.qty_blocked
             self.bid_orders = round(self.money_blocked / self.last_price)
 
+        @classmethod
+        def from_status(cls, status: Status):
+            self = cls.__new__(cls)
+            self.last_price = status.to_real_px(status.mid_px)
+            self.money_blocked = status.to_real_money(status.open_buy_notional)
+            self.money_balance = status.to_real_money(status.money) - self.money_blocked
+            self.qty_blocked = status.open_sell_qty * status.lot_size
+            self.qty_balance = status.qty * status.lot_size - self.qty_blocked
+            self.money_total = self.money_blocked + self.money_balance
+            self.qty_total = self.qty_blocked + self.qty_balance
+            self.capital = self.money_total + self.qty_total * self.last_price
+            self.ask_orders = status.open_sell_qty
+            self.bid_orders = status.open_buy_qty
+            return self
+
         def __eq__(self, other) -> bool:
             for field in ["money_blocked", "money_balance", "qty_blocked", "qty_balance", "bid_orders", "ask_orders"]:
                 if getattr(self, field) != getattr(other, field):
@@ -198,6 +217,19 @@ class TinkoffTask:
             self.px = quotation_to_float(order.initial_order_price) / self.qty_requested
             self.place_time = to_moscow(order.order_date)
 
+        @classmethod
+        def from_status(cls, status: Status, index: int):
+            self = cls.__new__(cls)
+            order = status.orders[index]
+            self.id = str(index)  # the page has no order ids: orders are compared by position
+            self.status = cls.PARTIAL_FILL if order.status == "PartiallyFilled" else cls.NEW
+            self.direction = cls.BUY if order.direction == 1 else cls.SELL
+            self.qty_requested = order.qty
+            self.qty_executed = 0
+            self.px = status.to_real_px(order.px)
+            self.place_time = None
+            return self
+
         def __eq__(self, other):
             for field in ["id", "status", "direction", "qty_requested", "qty_executed", "px", "place_time"]:
                 if getattr(self, field) != getattr(other, field):
@@ -271,6 +303,14 @@ spread:     {ask_px[0] - bid_px[0] if bid_px and ask_px else None}
 ```"""
 
     async def send_positions(self):
+        if self.status_reader is not None:
+            # Live state of the Runner: no API calls
+            status = self.status_reader.read()
+            positions = self.Positions.from_status(status)
+            orders = {str(i): self.Order.from_status(status, i) for i in range(len(status.orders))}
+            await self.send_positions_update(positions, orders)
+            return
+
         last_price = quotation_to_float((await self.client.market_data.get_last_prices(figi=[self.figi])).last_prices[0].price)
 
         positions = await self.client.operations.get_positions(account_id=self.account_id)
@@ -281,7 +321,9 @@ spread:     {ask_px[0] - bid_px[0] if bid_px and ask_px else None}
         orders = {order.id: order for order in orders}
         for order_id, order in orders.items():
             self.all_orders[order_id] = order
+        await self.send_positions_update(positions, orders)
 
+    async def send_positions_update(self, positions: Positions, orders: dict[str, Order]):
         if self.old_positions is None or self.old_positions != positions or orders != self.old_orders:
             await send_message(self.format_positions(self.old_positions, positions, self.old_orders, orders))
             self.old_positions = positions
@@ -323,6 +365,10 @@ order_id   = {order_id}
                 await asyncio.sleep(tinkoff_api_interval_seconds - elapsed)
 
     async def run_task(self):
+        if self.status_reader is not None:
+            await send_message("Start monitoring positions \\(status page\\)")
+            await self.positions_monitor()
+            return
         async with inv.AsyncClient(token=config["runner"]["token"]) as client:
             self.client = client
             await send_message("Start monitoring positions")